@@ -0,0 +1,95 @@
+#ifndef BENCHMARK_HPP
+# define BENCHMARK_HPP
+
+# define BENCHMARK_WARMUP 5
+# define BENCHMARK_REPETITIONS 31
+# define BENCHMARK_SAMPLE_NS 1e7
+# define BENCHMARK_OUTLIER 3.0
+
+# include <Error.hpp>
+# include <string>
+# include <vector>
+# include <map>
+# include <functional>
+# include <chrono>
+# include <ostream>
+# include <istream>
+# include <sstream>
+# include <iomanip>
+# include <algorithm>
+# include <cmath>
+# include <cstdint>
+# if defined(__linux__)
+#  include <linux/perf_event.h>
+#  include <sys/ioctl.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+# endif
+
+/**
+ * Harness timing a kernel over repeated samples. Each sample runs the kernel
+ * enough times to last about BENCHMARK_SAMPLE_NS nanoseconds, after
+ * BENCHMARK_WARMUP discarded samples. Samples further than BENCHMARK_OUTLIER
+ * scaled median absolute deviations from the median are rejected, and the
+ * median of the others is reported per operation. On Linux, cycles and
+ * instructions are counted with perf_event when the kernel allows it.
+ */
+class Benchmark
+{
+	public:
+		struct Result
+		{
+			std::string name;
+			double ns;
+			double spread;
+			double cycles;
+			double instructions;
+			size_t kept;
+			size_t samples;
+		};
+
+	private:
+		struct Sample
+		{
+			double ns;
+			double cycles;
+			double instructions;
+		};
+
+		size_t warmup;
+		size_t repetitions;
+		int cycles_fd;
+		int instructions_fd;
+
+		void openCounters(void);
+		void closeCounters(void);
+		Sample measure(const std::function<void(void)> &body,
+			size_t iterations);
+
+	public:
+		Benchmark(void);
+		Benchmark(size_t warmup, size_t repetitions);
+		Benchmark(const Benchmark &cpy);
+		virtual ~Benchmark(void) noexcept;
+
+		Benchmark &operator=(const Benchmark &cpy);
+
+		bool hasCounters(void) const;
+		Result run(const std::string &name, size_t operations,
+			const std::function<void(void)> &body);
+
+		static void writeResult(std::ostream &out, const Result &result,
+			const std::map<std::string, double> &baseline);
+		static std::map<std::string, double> readResults(std::istream &in);
+
+		/**
+		 * Keeps the compiler from optimizing away the computation of <value>.
+		 */
+		template <typename T>
+		static void keep(const T &value)
+		{
+			asm volatile("" : : "r,m" (value) : "memory");
+		}
+};
+
+#endif
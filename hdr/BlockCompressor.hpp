@@ -0,0 +1,61 @@
+#ifndef BLOCKCOMPRESSOR_HPP
+# define BLOCKCOMPRESSOR_HPP
+# include <ThreadPool.hpp>
+# include <cstdint>
+# include <cstring>
+# include <cmath>
+# include <algorithm>
+
+/**
+ * Encoder of RGBA8 images to BC1 (opaque) or BC3 (with alpha) blocks. The fast
+ * mode picks color endpoints from the bounding box of the block, the quality
+ * mode from its principal axis refined by least squares.
+ */
+class BlockCompressor
+{
+	public:
+		enum Format
+		{
+			BC1,
+			BC3
+		};
+		enum Mode
+		{
+			FAST,
+			QUALITY
+		};
+
+	private:
+		Mode mode;
+
+		void encodeColor(const uint8_t *block, uint8_t *out) const;
+
+	public:
+		BlockCompressor(void);
+		BlockCompressor(Mode mode);
+		BlockCompressor(const BlockCompressor &cpy);
+		virtual ~BlockCompressor(void) noexcept;
+
+		BlockCompressor &operator=(const BlockCompressor &cpy);
+
+		Mode getMode(void) const;
+		void encodeBC1(const uint8_t *block, uint8_t *out) const;
+		void encodeBC3(const uint8_t *block, uint8_t *out) const;
+		void encodeLevel(const uint8_t *src, uint32_t width, uint32_t height,
+			Format format, uint8_t *dst, uint32_t begin, uint32_t end) const;
+		void encodeChain(const uint8_t *chain, uint32_t width, uint32_t height,
+			uint32_t levels, Format format, uint8_t *dst,
+			ThreadPool &pool) const;
+
+		static size_t blockSize(Format format);
+		static size_t levelSize(Format format, uint32_t width,
+			uint32_t height);
+		static size_t chainSize(Format format, uint32_t width, uint32_t height,
+			uint32_t levels);
+		static bool hasAlpha(const uint8_t *pixels, size_t count);
+		static void encodeAlpha(const uint8_t *block, uint8_t *out);
+		static uint16_t toRgb565(const float *color);
+		static void fromRgb565(uint16_t packed, float *color);
+};
+
+#endif
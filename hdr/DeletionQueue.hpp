@@ -0,0 +1,37 @@
+#ifndef DELETIONQUEUE_HPP
+# define DELETIONQUEUE_HPP
+# include <deque>
+# include <functional>
+# include <cstdint>
+# include <cstddef>
+
+/**
+ * Destruction of GPU objects deferred until the GPU is done with them. Each
+ * destruction is queued with the timeline value of the last submission that
+ * may use its objects, and runs once that value has been reached, so that
+ * nothing needs the whole device to be drained.
+ */
+class DeletionQueue
+{
+	private:
+		struct Entry
+		{
+			uint64_t value;
+			std::function<void(void)> destroy;
+		};
+
+		std::deque<Entry> entries;
+
+	public:
+		DeletionQueue(void);
+		DeletionQueue(const DeletionQueue &cpy);
+		virtual ~DeletionQueue(void) noexcept;
+
+		DeletionQueue &operator=(const DeletionQueue &cpy);
+
+		void push(uint64_t value, std::function<void(void)> destroy);
+		size_t flush(uint64_t completed);
+		size_t size(void) const;
+};
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef DEVICEBENCHMARK_HPP
+# define DEVICEBENCHMARK_HPP
+
+# define DEVICEBENCHMARK_IMAGE_SIZE 2048
+# define DEVICEBENCHMARK_BUFFER_SIZE (64u << 20)
+# define DEVICEBENCHMARK_PASSES 16
+# define DEVICEBENCHMARK_VERTICES (3u << 18)
+# define DEVICEBENCHMARK_TRANSFORM_SIZE 128
+
+# include <Error.hpp>
+# include <vulkan/vulkan.h>
+# include <vector>
+# include <cmath>
+# include <iterator>
+# include <functional>
+
+/**
+ * One-time micro-benchmark of a physical device on a throwaway logical
+ * device: fill rate measured by drawing full screen quads, vertex throughput
+ * by drawing degenerate triangles and memory bandwidth with buffer copies.
+ * The draws use a trivial pipeline built from the embedded SPIR-V, every
+ * iteration waits for the previous one with a barrier, and each test is
+ * timed on the queue with timestamps.
+ */
+class DeviceBenchmark
+{
+	public:
+		struct Result
+		{
+			double fill_rate;
+			double vertex_rate;
+			double bandwidth;
+		};
+
+	private:
+		VkPhysicalDevice physical_device;
+		uint32_t queue_family;
+		std::vector<const char *> extensions;
+		VkDevice device;
+		VkQueue queue;
+		VkCommandPool command_pool;
+		VkImage image;
+		VkDeviceMemory image_memory;
+		VkImageView view;
+		VkRenderPass render_pass;
+		VkFramebuffer framebuffer;
+		VkPipelineLayout layout;
+		VkPipeline pipeline;
+		VkBuffer vertex_buffer;
+		VkDeviceMemory vertex_memory;
+		VkBuffer buffers[2];
+		VkDeviceMemory buffer_memory[2];
+		VkQueryPool query_pool;
+		double timestamp_period;
+		uint64_t timestamp_mask;
+
+		bool setUp(void);
+		void tearDown(void) noexcept;
+		VkDeviceMemory allocate(const VkMemoryRequirements &requirements);
+		VkBuffer createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
+			VkDeviceMemory &memory);
+		void createTarget(void);
+		VkShaderModule createShaderModule(const uint32_t *code, size_t size);
+		void createPipeline(void);
+		void submit(const std::function<void(VkCommandBuffer)> &record);
+		double time(const std::function<void(VkCommandBuffer)> &record);
+		void draw(VkCommandBuffer buf, uint32_t count, uint32_t first);
+
+		static void barrier(VkCommandBuffer buf,
+			VkPipelineStageFlags src_stage, VkAccessFlags src_access,
+			VkPipelineStageFlags dst_stage, VkAccessFlags dst_access);
+
+	public:
+		DeviceBenchmark(void);
+		DeviceBenchmark(VkPhysicalDevice physical_device,
+			uint32_t queue_family, const std::vector<const char *> &extensions);
+		DeviceBenchmark(const DeviceBenchmark &cpy);
+		virtual ~DeviceBenchmark(void) noexcept;
+
+		DeviceBenchmark &operator=(const DeviceBenchmark &cpy);
+
+		Result run(void);
+
+		static double score(const Result &result);
+};
+
+#endif
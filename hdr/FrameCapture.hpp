@@ -0,0 +1,90 @@
+#ifndef FRAMECAPTURE_HPP
+# define FRAMECAPTURE_HPP
+
+# define FRAMECAPTURE_SLOTS 4
+# define FRAMECAPTURE_SHOT_PREFIX "screenshot_"
+# define FRAMECAPTURE_DIGITS 6
+
+# include <Error.hpp>
+# include <MemoryBudget.hpp>
+# include <ThreadPool.hpp>
+# include <vulkan/vulkan.h>
+# include <string>
+# include <vector>
+# include <memory>
+# include <future>
+# include <atomic>
+# include <fstream>
+# include <ostream>
+# include <sstream>
+# include <iomanip>
+# include <cstdint>
+
+/**
+ * Copies of presented images into a ring of host visible buffers, read back
+ * once the GPU is done with them and written as PPM files by the thread pool.
+ * Recording a copy never waits: when every buffer is still in flight or being
+ * written, the frame is dropped and counted. Either every frame is captured,
+ * as a numbered sequence, or single screenshots are taken on request.
+ */
+class FrameCapture
+{
+	private:
+		enum State {FREE, PENDING, WRITING};
+
+		struct Slot
+		{
+			VkBuffer buffer;
+			VkDeviceMemory memory;
+			const uint8_t *data;
+			VkDeviceSize size;
+			uint32_t width;
+			uint32_t height;
+			bool swizzle;
+			uint64_t value;
+			std::string path;
+			std::atomic<State> state;
+			std::future<void> job;
+		};
+
+		VkDevice device;
+		const VkAllocationCallbacks *allocator;
+		MemoryBudget *memory_budget;
+		ThreadPool *pool;
+		std::string prefix;
+		bool shot;
+		uint64_t shots;
+		uint64_t captured;
+		uint64_t dropped;
+		std::atomic<uint64_t> failed;
+		std::vector<std::unique_ptr<Slot>> slots;
+
+		void reserve(Slot &slot, VkDeviceSize size);
+		void destroy(Slot &slot);
+		void write(Slot &slot);
+		std::string getPath(uint64_t frame);
+
+	public:
+		FrameCapture(void);
+		FrameCapture(VkDevice device, const VkAllocationCallbacks *allocator,
+			MemoryBudget *memory_budget, ThreadPool &pool,
+			const std::string &prefix);
+		FrameCapture(const FrameCapture &cpy);
+		virtual ~FrameCapture(void) noexcept;
+
+		FrameCapture &operator=(const FrameCapture &cpy);
+
+		bool isRecording(void) const;
+		bool isShotPending(void) const;
+		void requestShot(void);
+		void reserve(VkExtent2D extent);
+		void record(VkCommandBuffer buf, VkImage image, VkExtent2D extent,
+			VkFormat format, uint64_t value, uint64_t frame);
+		void collect(uint64_t completed);
+		void release(void);
+		void writeReport(std::ostream &out) const;
+
+		static bool supports(VkFormat format);
+};
+
+#endif
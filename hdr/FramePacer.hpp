@@ -0,0 +1,59 @@
+#ifndef FRAMEPACER_HPP
+# define FRAMEPACER_HPP
+# include <chrono>
+# include <thread>
+# include <vector>
+# include <algorithm>
+# include <iostream>
+
+# define PACER_HISTORY 128
+# define PACER_SMOOTHING 0.1
+# define PACER_MARGIN_MS 1.0
+# define PACER_SPIN_MS 1.0
+
+/**
+ * Frame limiter delaying input sampling and command recording to just before
+ * the predicted GPU slot, and measuring input-to-present latency.
+ */
+class FramePacer
+{
+	public:
+		typedef std::chrono::steady_clock Clock;
+
+	private:
+		struct Slot
+		{
+			Clock::time_point input;
+			Clock::time_point submit;
+			bool pending;
+		};
+
+		Clock::duration period;
+		Clock::time_point deadline;
+		Clock::time_point last_report;
+		std::vector<Slot> slots;
+		double cpu_ms;
+		double gpu_ms;
+		std::vector<double> latency;
+		size_t latency_count;
+
+		double predictedWork(void) const;
+
+	public:
+		FramePacer(void);
+		FramePacer(double fps, size_t frames_in_flight);
+		FramePacer(const FramePacer &cpy);
+		virtual ~FramePacer(void) noexcept;
+
+		FramePacer &operator=(const FramePacer &cpy);
+
+		void wait(void);
+		void markInput(size_t slot);
+		void markSubmit(size_t slot);
+		void markComplete(size_t slot, bool observed, double gpu_time);
+		void report(std::ostream &out);
+
+		static double milliseconds(Clock::duration duration);
+};
+
+#endif
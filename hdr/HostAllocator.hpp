@@ -0,0 +1,89 @@
+#ifndef HOSTALLOCATOR_HPP
+# define HOSTALLOCATOR_HPP
+
+# define HOSTALLOCATOR_MIN_CLASS 16
+# define HOSTALLOCATOR_MAX_CLASS 4096
+# define HOSTALLOCATOR_CLASSES 9
+# define HOSTALLOCATOR_CHUNK (64u << 10)
+# define HOSTALLOCATOR_SCOPES 5
+# define HOSTALLOCATOR_LARGE UINT16_MAX
+
+# include <vulkan/vulkan.h>
+# include <mutex>
+# include <vector>
+# include <new>
+# include <cstdint>
+# include <cstring>
+# include <algorithm>
+# include <ostream>
+# include <iomanip>
+
+/**
+ * Host memory of the Vulkan driver, handed out through VkAllocationCallbacks.
+ * Small blocks come from power of two size classes carved out of chunks, with
+ * one arena of chunks per allocation scope so that short-lived command
+ * allocations never fragment long-lived object ones. Freed blocks go back to
+ * their class free list and chunks are only released with the allocator.
+ * Bytes are tracked per scope.
+ */
+class HostAllocator
+{
+	public:
+		struct Usage
+		{
+			size_t bytes;
+			size_t peak;
+			size_t live;
+			size_t total;
+			size_t internal;
+		};
+
+	private:
+		struct Header
+		{
+			uint64_t size;
+			uint32_t scope;
+			uint16_t size_class;
+			uint16_t offset;
+		};
+
+		VkAllocationCallbacks callbacks;
+		std::mutex mutex;
+		void *free_lists[HOSTALLOCATOR_SCOPES][HOSTALLOCATOR_CLASSES];
+		std::vector<void *> chunks;
+		Usage usage[HOSTALLOCATOR_SCOPES];
+
+		uint8_t *take(uint32_t scope, uint16_t size_class);
+		void *allocate(size_t size, size_t alignment,
+			VkSystemAllocationScope scope);
+		void *reallocate(void *original, size_t size, size_t alignment,
+			VkSystemAllocationScope scope);
+		void free(void *memory);
+		void notify(size_t size, VkSystemAllocationScope scope, bool allocated);
+
+		static VKAPI_ATTR void *VKAPI_CALL allocation(void *user, size_t size,
+			size_t alignment, VkSystemAllocationScope scope);
+		static VKAPI_ATTR void *VKAPI_CALL reallocation(void *user,
+			void *original, size_t size, size_t alignment,
+			VkSystemAllocationScope scope);
+		static VKAPI_ATTR void VKAPI_CALL release(void *user, void *memory);
+		static VKAPI_ATTR void VKAPI_CALL internalAllocation(void *user,
+			size_t size, VkInternalAllocationType type,
+			VkSystemAllocationScope scope);
+		static VKAPI_ATTR void VKAPI_CALL internalFree(void *user, size_t size,
+			VkInternalAllocationType type, VkSystemAllocationScope scope);
+		static uint32_t scopeIndex(VkSystemAllocationScope scope);
+
+	public:
+		HostAllocator(void);
+		HostAllocator(const HostAllocator &cpy);
+		virtual ~HostAllocator(void) noexcept;
+
+		HostAllocator &operator=(const HostAllocator &cpy);
+
+		const VkAllocationCallbacks *getCallbacks(void) const;
+		Usage getUsage(VkSystemAllocationScope scope);
+		void writeReport(std::ostream &out);
+};
+
+#endif
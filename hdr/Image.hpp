@@ -0,0 +1,78 @@
+#ifndef IMAGE_HPP
+# define IMAGE_HPP
+
+# define IMAGE_SRGB_TABLE_SIZE 4096
+# define IMAGE_MAX_DIMENSION 16384
+
+# include <Error.hpp>
+# include <ThreadPool.hpp>
+# include <string>
+# include <fstream>
+# include <cstdint>
+# include <cstring>
+# include <cmath>
+# include <cctype>
+# include <algorithm>
+# include <vector>
+# if defined(__SSE2__)
+#  include <emmintrin.h>
+# endif
+
+/**
+ * BMP, TGA or PPM image file. Only the header is parsed on load, pixels are
+ * decoded on demand as 8 bits sRGB RGBA, top row first, straight into the
+ * destination memory (typically a mapped staging buffer).
+ */
+class Image
+{
+	public:
+		enum Format
+		{
+			BMP,
+			TGA,
+			PPM
+		};
+
+	private:
+		std::string data;
+		Format format;
+		uint32_t width;
+		uint32_t height;
+		size_t offset;
+		uint32_t channels;
+		bool bottom_up;
+		bool rle;
+		bool alpha;
+
+		void parseBmp(void);
+		void parseTga(void);
+		void parsePpm(void);
+		void decodeBmp(uint8_t *dst) const;
+		void decodeTga(uint8_t *dst) const;
+		void decodePpm(uint8_t *dst) const;
+
+	public:
+		Image(void);
+		Image(const std::string &path);
+		Image(const Image &cpy);
+		virtual ~Image(void) noexcept;
+
+		Image &operator=(const Image &cpy);
+
+		void load(const std::string &path);
+		uint32_t getWidth(void) const;
+		uint32_t getHeight(void) const;
+		uint32_t getMipLevels(void) const;
+		uint64_t hash(void) const;
+		void decode(uint8_t *dst) const;
+
+		static uint32_t mipLevels(uint32_t width, uint32_t height);
+		static size_t mipChainSize(uint32_t width, uint32_t height,
+			uint32_t levels);
+		static void generateMips(uint8_t *chain, uint32_t width,
+			uint32_t height, uint32_t levels, ThreadPool &pool);
+		static void downsample(const uint8_t *src, uint32_t width,
+			uint32_t height, uint8_t *dst, uint32_t begin, uint32_t end);
+};
+
+#endif
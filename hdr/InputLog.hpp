@@ -0,0 +1,77 @@
+#ifndef INPUTLOG_HPP
+# define INPUTLOG_HPP
+
+# define INPUTLOG_MAGIC "SCOPINP1"
+# define INPUTLOG_MAGIC_SIZE 8
+
+# include <Error.hpp>
+# include <SDL.h>
+# include <string>
+# include <vector>
+# include <fstream>
+# include <ostream>
+# include <iomanip>
+# include <chrono>
+# include <algorithm>
+# include <cstring>
+# include <cstdint>
+
+/**
+ * Events handled by the render thread, written to a binary file frame by
+ * frame along with the time each frame took, or read back from it. A frame is
+ * its duration in microseconds and its event count, followed by its events:
+ * a kind byte and only the fields the program reads for that kind. Replaying
+ * measures the duration of every frame so that sessions can be compared.
+ */
+class InputLog
+{
+	public:
+		enum Mode {OFF, RECORD, REPLAY};
+
+	private:
+		enum Kind : uint8_t {QUIT, KEY, WINDOW, OTHER};
+		typedef std::chrono::steady_clock Clock;
+
+		Mode mode;
+		std::string path;
+		std::ofstream out;
+		std::ifstream in;
+		std::vector<SDL_Event> frame;
+		Clock::time_point last;
+		uint64_t frames;
+		std::vector<float> recorded_ms;
+		std::vector<float> frame_ms;
+
+		void open(void);
+		void writeEvent(const SDL_Event &event);
+		bool readEvent(SDL_Event &event);
+
+		template <typename T>
+		void write(T value)
+		{
+			out.write(reinterpret_cast<const char *> (&value), sizeof(T));
+		}
+
+		template <typename T>
+		bool read(T &value)
+		{
+			in.read(reinterpret_cast<char *> (&value), sizeof(T));
+			return (static_cast<bool> (in));
+		}
+
+	public:
+		InputLog(void);
+		InputLog(const std::string &record, const std::string &replay);
+		InputLog(const InputLog &cpy);
+		virtual ~InputLog(void) noexcept;
+
+		InputLog &operator=(const InputLog &cpy);
+
+		Mode getMode(void) const;
+		void record(const SDL_Event &event);
+		void endFrame(void);
+		bool replay(std::vector<SDL_Event> &events);
+		void writeSummary(std::ostream &out) const;
+};
+
+#endif
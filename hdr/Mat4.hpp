@@ -0,0 +1,42 @@
+#ifndef MAT4_HPP
+# define MAT4_HPP
+# include <cmath>
+
+/**
+ * Three components float vector.
+ */
+struct Vec3
+{
+	float x;
+	float y;
+	float z;
+
+	Vec3 operator+(const Vec3 &rhs) const;
+	Vec3 operator-(const Vec3 &rhs) const;
+	Vec3 operator*(float rhs) const;
+
+	static float dot(const Vec3 &a, const Vec3 &b);
+	static Vec3 cross(const Vec3 &a, const Vec3 &b);
+	static Vec3 normalize(const Vec3 &v);
+	static float length(const Vec3 &v);
+};
+
+/**
+ * Column major 4x4 float matrix, element at row r and column c is m[c * 4 + r]
+ * as expected by GLSL.
+ */
+struct Mat4
+{
+	float m[16];
+
+	Mat4 operator*(const Mat4 &rhs) const;
+
+	static Mat4 identity(void);
+	static Mat4 translation(const Vec3 &t);
+	static Mat4 scale(float s);
+	static Mat4 rotation(float angle, const Vec3 &axis);
+	static Mat4 lookAt(const Vec3 &eye, const Vec3 &center, const Vec3 &up);
+	static Mat4 perspective(float fovy, float aspect, float near, float far);
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef MEMORYBUDGET_HPP
+# define MEMORYBUDGET_HPP
+
+# define MEMORYBUDGET_HIGH 90
+# define MEMORYBUDGET_LOW 75
+# define MEMORYBUDGET_FALLBACK 80
+
+# include <Error.hpp>
+# include <vulkan/vulkan.h>
+# include <unordered_map>
+# include <vector>
+# include <list>
+# include <mutex>
+# include <ostream>
+# include <iomanip>
+# include <algorithm>
+# include <cstdint>
+
+/**
+ * Device memory of the program, allocated and freed through a single place so
+ * that its usage is known per heap. The budget of each heap comes from
+ * VK_EXT_memory_budget when available, or is a fixed share of the heap size
+ * otherwise. Resources that can leave device local memory are ordered by last
+ * use, so that the least recently used are evicted first under pressure.
+ */
+class MemoryBudget
+{
+	public:
+		struct Heap
+		{
+			VkDeviceSize size;
+			VkDeviceSize budget;
+			VkDeviceSize usage;
+			VkDeviceSize own;
+			VkDeviceSize peak;
+			VkDeviceSize retired;
+			bool device_local;
+		};
+
+	private:
+		struct Allocation
+		{
+			uint32_t heap;
+			VkDeviceSize size;
+			bool retired;
+		};
+
+		VkPhysicalDevice physical_device;
+		VkDevice device;
+		const VkAllocationCallbacks *allocator;
+		bool extension;
+		VkDeviceSize cap;
+		VkPhysicalDeviceMemoryProperties properties;
+		std::vector<Heap> heaps;
+		std::unordered_map<VkDeviceMemory, Allocation> allocations;
+		std::list<uint32_t> recent;
+		std::unordered_map<uint32_t, std::list<uint32_t>::iterator> entries;
+		std::mutex mutex;
+
+		uint32_t findType(uint32_t type_filter,
+			VkMemoryPropertyFlags properties,
+			VkMemoryPropertyFlags excluded) const;
+
+	public:
+		MemoryBudget(void);
+		MemoryBudget(VkPhysicalDevice physical_device, VkDevice device,
+			const VkAllocationCallbacks *allocator, bool extension,
+			VkDeviceSize cap);
+		MemoryBudget(const MemoryBudget &cpy);
+		virtual ~MemoryBudget(void) noexcept;
+
+		MemoryBudget &operator=(const MemoryBudget &cpy);
+
+		VkResult allocate(const VkMemoryRequirements &requirements,
+			VkMemoryPropertyFlags properties, VkDeviceMemory &memory);
+		bool supports(uint32_t type_filter,
+			VkMemoryPropertyFlags properties) const;
+		void retire(VkDeviceMemory memory);
+		void free(VkDeviceMemory memory);
+		void update(void);
+		uint32_t getDeviceHeap(void) const;
+		VkDeviceSize getSize(VkDeviceMemory memory);
+		bool exceeds(uint32_t heap, VkDeviceSize extra, uint32_t percent);
+		void touch(uint32_t resource);
+		std::vector<uint32_t> getLeastRecentlyUsed(void);
+		void writeReport(std::ostream &out);
+};
+
+#endif
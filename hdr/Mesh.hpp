@@ -0,0 +1,146 @@
+#ifndef MESH_HPP
+# define MESH_HPP
+
+# define MESH_CHUNK_TRIANGLES 16384
+# define MESH_ASSET_MAGIC "SCMA"
+# define MESH_ASSET_VERSION 1
+# define MESH_ASSET_GENERATED 1u
+
+# include <Error.hpp>
+# include <Mat4.hpp>
+# include <vector>
+# include <string>
+# include <fstream>
+# include <unordered_map>
+# include <cstdint>
+# include <cstring>
+# include <algorithm>
+# include <functional>
+# include <limits>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <fcntl.h>
+# include <unistd.h>
+
+/**
+ * Indexed triangle mesh loaded from a Wavefront OBJ file, or from a binary
+ * asset written by scop-opt. Positions and the remaining vertex attributes are
+ * kept in two separate streams so that position-only passes read the least
+ * memory possible. Large files can be handed out in chunks of triangles while
+ * they are parsed.
+ *
+ * An asset is a header, its levels of detail, quantized vertices and indices.
+ * Positions are 16 bits fractions of the bounds, normals 16 bits signed
+ * fractions and texture coordinates 16 bits fractions of their own range.
+ * Indices are 16 bits when the vertices allow it, every level of detail
+ * indexing the same vertices, the first one being the full mesh.
+ */
+class Mesh
+{
+	public:
+		struct Attributes
+		{
+			float normal[3];
+			float uv[2];
+		};
+		struct Bounds
+		{
+			Vec3 min;
+			Vec3 max;
+		};
+		struct FaceIndex
+		{
+			int32_t v;
+			int32_t vt;
+			int32_t vn;
+
+			bool operator==(const FaceIndex &rhs) const;
+		};
+		struct FaceIndexHash
+		{
+			size_t operator()(const FaceIndex &idx) const;
+		};
+		struct Chunk
+		{
+			uint32_t first_vertex;
+			uint32_t first_index;
+			std::vector<Vec3> positions;
+			std::vector<Attributes> attributes;
+			std::vector<uint32_t> indices;
+			Bounds bounds;
+			float progress;
+		};
+
+		struct AssetHeader
+		{
+			char magic[4];
+			uint32_t version;
+			uint32_t flags;
+			uint32_t vertex_count;
+			uint32_t index_count;
+			uint32_t index_size;
+			uint32_t lod_count;
+			float min[3];
+			float max[3];
+			float uv_min[2];
+			float uv_max[2];
+		};
+		struct AssetLod
+		{
+			uint32_t first_index;
+			uint32_t index_count;
+			float error;
+		};
+		struct AssetVertex
+		{
+			uint16_t position[3];
+			int16_t normal[3];
+			uint16_t uv[2];
+		};
+
+		typedef std::function<void(const Chunk &)> Stream;
+
+	private:
+		std::vector<Vec3> positions;
+		std::vector<Attributes> attributes;
+		std::vector<uint32_t> indices;
+		Bounds bounds;
+		bool generated;
+
+		void sendChunk(const Stream &stream, Chunk &chunk,
+			float progress) const;
+		void computeNormals(const std::vector<bool> &missing);
+		void computeBounds(void);
+		void computeTextureCoordinates(const std::vector<bool> &missing);
+		void loadAsset(const std::string &path);
+		void decodeAsset(const uint8_t *data, size_t size);
+
+	public:
+		Mesh(void);
+		Mesh(const std::string &path);
+		Mesh(const Mesh &cpy);
+		virtual ~Mesh(void) noexcept;
+
+		Mesh &operator=(const Mesh &cpy);
+
+		void load(const std::string &path, const Stream &stream = nullptr);
+		const std::vector<Vec3> &getPositions(void) const;
+		const std::vector<Attributes> &getAttributes(void) const;
+		const std::vector<uint32_t> &getIndices(void) const;
+		const Bounds &getBounds(void) const;
+		Vec3 getCenter(void) const;
+		float getRadius(void) const;
+		bool hasGeneratedAttributes(void) const;
+
+		static void growBounds(Bounds &bounds,
+			const std::vector<Vec3> &positions);
+		static std::string readFile(const std::string &path);
+		static bool isAsset(const std::string &path);
+		static const char *skipSpaces(const char *p, const char *end);
+		static const char *nextLine(const char *p, const char *end);
+		static float parseFloat(const char *&p, const char *end);
+		static bool parseFaceIndex(const char *&p, const char *end,
+			FaceIndex &idx);
+};
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef MESHOPTIMIZER_HPP
+# define MESHOPTIMIZER_HPP
+
+# define MESHOPTIMIZER_CACHE 16
+# define MESHOPTIMIZER_MAX_LODS 6
+# define MESHOPTIMIZER_MIN_TRIANGLES 64
+# define MESHOPTIMIZER_LOD_RATIO 0.6f
+
+# include <Error.hpp>
+# include <Mesh.hpp>
+# include <vector>
+# include <string>
+# include <fstream>
+# include <filesystem>
+# include <system_error>
+# include <unordered_map>
+# include <algorithm>
+# include <array>
+# include <cmath>
+# include <cstdint>
+# include <cstring>
+
+/**
+ * Conversion of a mesh into a binary asset ready to upload. Vertices are
+ * quantized, then those that became identical are welded and degenerate
+ * triangles dropped. Triangles are ordered for the post-transform vertex cache
+ * (Tipsify), and vertices in the order the triangles first use them. Coarser
+ * levels of detail cluster vertices on ever larger cells of the quantization
+ * grid and index the same vertices.
+ */
+class MeshOptimizer
+{
+	public:
+		struct Lod
+		{
+			std::vector<uint32_t> indices;
+			float error;
+		};
+
+	private:
+		struct VertexKey
+		{
+			uint64_t low;
+			uint64_t high;
+
+			bool operator==(const VertexKey &rhs) const;
+		};
+		struct VertexKeyHash
+		{
+			size_t operator()(const VertexKey &key) const;
+		};
+
+		Mesh::AssetHeader header;
+		std::vector<Mesh::AssetVertex> vertices;
+		std::vector<Lod> lods;
+		size_t source_vertices;
+		float source_acmr;
+
+		void quantize(const Mesh &mesh);
+		void weld(std::vector<uint32_t> &indices);
+		std::vector<uint32_t> cluster(const std::vector<uint32_t> &indices,
+			uint32_t shift) const;
+		void buildLods(void);
+		void reorderVertices(void);
+
+	public:
+		MeshOptimizer(void);
+		MeshOptimizer(const Mesh &mesh);
+		MeshOptimizer(const MeshOptimizer &cpy);
+		virtual ~MeshOptimizer(void) noexcept;
+
+		MeshOptimizer &operator=(const MeshOptimizer &cpy);
+
+		const std::vector<Mesh::AssetVertex> &getVertices(void) const;
+		const std::vector<Lod> &getLods(void) const;
+		size_t getSourceVertexCount(void) const;
+		float getSourceAcmr(void) const;
+		size_t getAssetSize(void) const;
+		bool write(const std::string &path) const;
+
+		static void optimizeCache(std::vector<uint32_t> &indices,
+			size_t vertex_count);
+		static float computeAcmr(const std::vector<uint32_t> &indices,
+			size_t vertex_count);
+};
+
+#endif
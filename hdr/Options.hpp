@@ -0,0 +1,56 @@
+#ifndef OPTIONS_HPP
+# define OPTIONS_HPP
+
+# define SCOP_DEFAULT_MODEL "resources/42.obj"
+# define OPTIONS_MIN_FPS 1.0
+# define OPTIONS_MAX_BUDGET (1u << 24)
+
+# include <Error.hpp>
+# include <BlockCompressor.hpp>
+# include <cstring>
+# include <cstdlib>
+# include <cmath>
+# include <string>
+# include <cstdint>
+
+/**
+ * Command line settings of the program.
+ */
+class Options
+{
+	public:
+		bool on_demand;
+		double target_fps;
+		bool report;
+		bool depth_prepass;
+		std::string model;
+		std::string texture;
+		bool gpu_mips;
+		bool compress;
+		BlockCompressor::Mode compress_mode;
+		std::string device;
+		bool device_benchmark;
+		std::string startup_trace;
+		std::string shaders;
+		bool render_pass;
+		uint64_t budget;
+		std::string record;
+		std::string replay;
+		bool software;
+		std::string capture;
+
+		Options(void);
+		Options(int argc, char **argv);
+		Options(const Options &cpy);
+		virtual ~Options(void) noexcept;
+
+		Options &operator=(const Options &cpy);
+
+		void parseCompression(const char *value);
+
+		static void usage(const char *name);
+		static const char *nextValue(int argc, char **argv, int &i);
+		static double toNumber(const char *value);
+};
+
+#endif
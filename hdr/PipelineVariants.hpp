@@ -0,0 +1,61 @@
+#ifndef PIPELINEVARIANTS_HPP
+# define PIPELINEVARIANTS_HPP
+# include <Error.hpp>
+# include <vulkan/vulkan.h>
+# include <unordered_map>
+# include <functional>
+# include <mutex>
+# include <chrono>
+# include <cstdint>
+
+/**
+ * Graphics pipelines compiled lazily, one per distinct fixed-function and
+ * specialization state. A state is packed into a compact key under which its
+ * pipeline is compiled once then shared.
+ */
+class PipelineVariants
+{
+	public:
+		enum Layout {FULL, POSITION};
+		enum Shading {LIT, UNLIT, NORMALS, SHADING_COUNT};
+		enum Blend {OPAQUE, ALPHA};
+		enum Depth {LESS, EQUAL};
+
+		struct Key
+		{
+			Layout layout;
+			Shading shading;
+			VkCullModeFlags cull;
+			Blend blend;
+			VkSampleCountFlagBits samples;
+			Depth depth;
+		};
+
+		typedef std::function<VkPipeline(const Key &)> Builder;
+
+	private:
+		VkDevice device;
+		const VkAllocationCallbacks *allocator;
+		Builder build;
+		std::unordered_map<uint32_t, VkPipeline> pipelines;
+		std::mutex mutex;
+		double compile_ms;
+
+	public:
+		PipelineVariants(void);
+		PipelineVariants(VkDevice device,
+			const VkAllocationCallbacks *allocator, Builder build);
+		PipelineVariants(const PipelineVariants &cpy);
+		virtual ~PipelineVariants(void) noexcept;
+
+		PipelineVariants &operator=(const PipelineVariants &cpy);
+
+		VkPipeline get(const Key &key);
+		void clear(void);
+		size_t size(void);
+		double getCompileTime(void);
+
+		static uint32_t hash(const Key &key);
+};
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef RENDERGRAPH_HPP
+# define RENDERGRAPH_HPP
+# include <Error.hpp>
+# include <MemoryBudget.hpp>
+# include <vulkan/vulkan.h>
+# include <string>
+# include <vector>
+# include <functional>
+# include <ostream>
+# include <iomanip>
+# include <algorithm>
+# include <cstdint>
+
+/**
+ * Passes of a frame declaring the images they use, from which the graph
+ * derives the barriers between them. Images are either imported, one per
+ * swapchain image, or transient: created by the graph for the frame only,
+ * and aliased in memory when their lifetimes don't overlap. Passes whose
+ * output never reaches an exported image are culled, unless they have side
+ * effects outside the graph, like copying an image to a buffer.
+ */
+class RenderGraph
+{
+	public:
+		enum Access {COLOR_WRITE, DEPTH_WRITE, DEPTH_READ, SAMPLED,
+			TRANSFER_SRC, TRANSFER_DST, PRESENT, ACCESS_COUNT};
+
+		struct Use
+		{
+			size_t resource;
+			Access access;
+		};
+
+		typedef std::function<void(VkCommandBuffer, uint32_t)> Record;
+
+	private:
+		struct State
+		{
+			VkPipelineStageFlags2KHR stage;
+			VkAccessFlags2KHR access;
+			VkImageLayout layout;
+		};
+		struct Resource
+		{
+			std::string name;
+			VkFormat format;
+			VkImageAspectFlags aspect;
+			bool transient;
+			bool exported;
+			Access final;
+			std::vector<VkImage> images;
+			std::vector<VkImageView> views;
+			VkImageUsageFlags usage;
+			size_t first;
+			size_t last;
+			size_t block;
+		};
+		struct Pass
+		{
+			std::string name;
+			std::vector<Use> uses;
+			Record record;
+			bool side_effects;
+		};
+		struct Transition
+		{
+			size_t resource;
+			State src;
+			State dst;
+		};
+		struct Block
+		{
+			VkMemoryRequirements requirements;
+			VkDeviceMemory memory;
+			std::vector<size_t> resources;
+		};
+
+		VkDevice device;
+		const VkAllocationCallbacks *allocator;
+		MemoryBudget *memory_budget;
+		PFN_vkCmdPipelineBarrier2KHR pipeline_barrier2;
+		std::vector<Resource> resources;
+		std::vector<Pass> passes;
+		std::vector<size_t> order;
+		std::vector<std::vector<Transition>> barriers;
+		std::vector<Transition> exports;
+		std::vector<Block> blocks;
+		VkDeviceSize unaliased_size;
+
+		std::vector<bool> cull(void) const;
+		void allocateTransients(VkExtent2D extent);
+		void createTransitions(void);
+		void emit(VkCommandBuffer buf, uint32_t index,
+			const std::vector<Transition> &transitions) const;
+
+		static State getState(Access access);
+		static VkImageUsageFlags getUsage(Access access);
+		static bool needsBarrier(const State &src, const State &dst);
+
+	public:
+		RenderGraph(void);
+		RenderGraph(VkDevice device, const VkAllocationCallbacks *allocator,
+			MemoryBudget *memory_budget,
+			PFN_vkCmdPipelineBarrier2KHR pipeline_barrier2);
+		RenderGraph(const RenderGraph &cpy);
+		virtual ~RenderGraph(void) noexcept;
+
+		RenderGraph &operator=(const RenderGraph &cpy);
+
+		size_t importImages(const std::string &name, VkFormat format,
+			VkImageAspectFlags aspect, const std::vector<VkImage> &images,
+			const std::vector<VkImageView> &views, Access final);
+		size_t addTransient(const std::string &name, VkFormat format,
+			VkImageAspectFlags aspect);
+		void addPass(const std::string &name, const std::vector<Use> &uses,
+			Record record, bool side_effects = false);
+		void compile(VkExtent2D extent);
+		void execute(VkCommandBuffer buf, uint32_t index) const;
+		VkImageView getView(size_t resource, uint32_t index = 0) const;
+		std::function<void(void)> release(void);
+		void writeSummary(std::ostream &out) const;
+};
+
+#endif
@@ -29,9 +29,14 @@ class SDL2pp
 
 		void addWindow(char const *t, int x, int y, int w, int h, Uint32 flags);
 		void getWindowPixelResolution(int *width, int *height);
+		void setWindowTitle(char const *title);
 		void vkCreateSurface(VkInstance &instance, VkSurfaceKHR &surface);
+		int presentPixels(const uint32_t *pixels, int width, int height,
+			int pitch);
 		void destroyWindow(void);
 		int pollEvent(SDL_Event *event);
+		int waitEventTimeout(SDL_Event *event, int timeout);
+		int pushEvent(SDL_Event *event);
 		void getVulkanExtensions(std::vector<const char *> &names,
 			bool debug = false);
 };
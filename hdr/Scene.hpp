@@ -0,0 +1,42 @@
+#ifndef SCENE_HPP
+# define SCENE_HPP
+
+# define SCENE_NO_PARENT UINT32_MAX
+
+# include <Error.hpp>
+# include <Mat4.hpp>
+# include <vector>
+# include <cstdint>
+# include <algorithm>
+
+/**
+ * Transform hierarchy stored as flat arrays indexed by node. A node is always
+ * stored after its parent, so world transforms are brought up to date in a
+ * single forward pass starting at the first dirty node.
+ */
+class Scene
+{
+	private:
+		std::vector<uint32_t> parents;
+		std::vector<Mat4> locals;
+		std::vector<Mat4> worlds;
+		std::vector<uint8_t> dirty;
+		size_t first_dirty;
+
+	public:
+		Scene(void);
+		Scene(const Scene &cpy);
+		virtual ~Scene(void) noexcept;
+
+		Scene &operator=(const Scene &cpy);
+
+		uint32_t addNode(uint32_t parent, const Mat4 &local);
+		void setLocal(uint32_t node, const Mat4 &local);
+		void update(void);
+		size_t size(void) const;
+		uint32_t getParent(uint32_t node) const;
+		const Mat4 &getLocal(uint32_t node) const;
+		const Mat4 &getWorld(uint32_t node) const;
+};
+
+#endif
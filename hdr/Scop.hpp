@@ -3,17 +3,120 @@
 
 # define SCOP_WINDOW_WIDTH 1280
 # define SCOP_WINDOW_HEIGHT 720
+# define SCOP_IDLE_TIMEOUT_MS 250
+# define SCOP_EVENT_QUEUE_SIZE 1024
+# define SCOP_PRESENT_EVENT 1
+# define SCOP_ROTATION_SPEED 0.8f
+# define SCOP_REPLAY_DT (1.0f / 60.0f)
+# define SCOP_UPLOAD_BUDGET (4u << 20)
+# define SCOP_PROGRESSIVE_SIZE (32u << 20)
+# define SCOP_MESH_CHUNKS 8
+# define SCOP_DEVICE_CACHE TEXTURECACHE_DIRECTORY "/device"
 
 # include <SDL2pp.hpp>
+# include <Options.hpp>
+# include <FramePacer.hpp>
+# include <SpscQueue.hpp>
+# include <Mesh.hpp>
+# include <Scene.hpp>
+# include <Mat4.hpp>
+# include <Image.hpp>
+# include <BlockCompressor.hpp>
+# include <TextureCache.hpp>
+# include <DeviceBenchmark.hpp>
+# include <TaskGraph.hpp>
+# include <PipelineVariants.hpp>
+# include <ThreadPool.hpp>
+# include <HostAllocator.hpp>
+# include <MemoryBudget.hpp>
+# include <DeletionQueue.hpp>
+# include <RenderGraph.hpp>
+# include <InputLog.hpp>
+# include <SoftRasterizer.hpp>
+# include <FrameCapture.hpp>
+# include <future>
+# include <chrono>
+# include <cstddef>
+# include <atomic>
+# include <thread>
+# include <mutex>
+# include <exception>
 # include <cstring>
 # include <optional>
 # include <set>
 # include <fstream>
+# include <filesystem>
+# include <algorithm>
+# include <cctype>
+# include <cstdio>
 
 class Scop
 {
 	private:
+		struct Texture
+		{
+			VkImage image;
+			VkDeviceMemory memory;
+			VkImageView view;
+		};
+		struct TextureUpload
+		{
+			Texture texture;
+			std::vector<uint8_t> data;
+			uint32_t width;
+			uint32_t height;
+			uint32_t mip_levels;
+			VkFormat format;
+			bool gpu_mips;
+			bool cached;
+			double decode_ms;
+			double mip_ms;
+			double encode_ms;
+			uint32_t level;
+			uint32_t row;
+			uint32_t resident;
+			uint64_t start_frame;
+			std::chrono::steady_clock::time_point start;
+		};
+		struct MeshStream
+		{
+			bool active;
+			bool pending;
+			Mesh::Chunk chunk;
+			VkDeviceSize position_capacity;
+			VkDeviceSize attribute_capacity;
+			VkDeviceSize index_capacity;
+			uint32_t vertex_count;
+			uint32_t refreshed;
+			double first_ms;
+		};
+		struct Transform
+		{
+			Mat4 mvp;
+			Mat4 model;
+		};
+		struct ShaderCode
+		{
+			const uint32_t *words;
+			size_t size;
+			std::vector<uint32_t> file;
+		};
+		struct FragmentConstants
+		{
+			int32_t shading;
+			VkBool32 blend;
+		};
+		enum Resource {RESOURCE_MESH, RESOURCE_TEXTURE};
+
 		SDL2pp sdl;
+		Options options;
+		Mesh mesh;
+		Scene scene;
+		uint32_t turntable;
+		uint32_t model_node;
+		ThreadPool pool;
+		HostAllocator host_allocator;
+		const VkAllocationCallbacks *allocator;
 
 		const uint32_t width;
 		const uint32_t height;
@@ -33,17 +136,98 @@ class Scop
 		std::vector<VkImageView> swapchain_image_view;
 		VkFormat swapchain_image_format;
 		VkExtent2D swapchain_extent;
+		bool swapchain_readable;
+		bool capture_pass;
 		VkRenderPass render_pass;
+		bool dynamic_rendering;
+		PFN_vkCmdBeginRenderingKHR cmd_begin_rendering;
+		PFN_vkCmdEndRenderingKHR cmd_end_rendering;
+		bool synchronization2;
+		PFN_vkCmdPipelineBarrier2KHR cmd_pipeline_barrier2;
+		bool memory_budget_ext;
+		MemoryBudget memory_budget;
+		VkDescriptorSetLayout descriptor_layout;
 		VkPipelineLayout pipeline_layout;
-		VkPipeline graphics_pipeline;
+		PipelineVariants pipelines;
+		PipelineVariants::Key variant;
+		ShaderCode vert_code;
+		ShaderCode frag_code;
+		ShaderCode depth_code;
+		VkShaderModule vert_module;
+		VkShaderModule frag_module;
+		VkShaderModule depth_module;
+		VkFormat depth_format;
+		RenderGraph render_graph;
+		VkImageView depth_image_view;
 		std::vector<VkFramebuffer> swapchain_framebuffers;
 		VkCommandPool command_pool;
 		std::vector<VkCommandBuffer> command_buffer;
+		VkBuffer position_buffer;
+		VkDeviceMemory position_memory;
+		VkBuffer attribute_buffer;
+		VkDeviceMemory attribute_memory;
+		VkBuffer index_buffer;
+		VkDeviceMemory index_memory;
+		bool mesh_resident;
+		bool mesh_page_in;
+		uint32_t index_count;
+		float mesh_radius;
+		VkDeviceSize evicted_texture;
+		VkSampler sampler;
+		VkDescriptorPool descriptor_pool;
+		std::vector<VkDescriptorSet> descriptor_sets;
+		std::vector<VkImageView> descriptor_views;
+		Texture placeholder;
+		Texture texture;
+		TextureCache texture_cache;
+		std::future<TextureUpload> texture_load;
+		TextureUpload texture_upload;
+		bool streaming;
+		std::future<void> mesh_load;
+		SpscQueue<Mesh::Chunk, SCOP_MESH_CHUNKS> mesh_chunks;
+		MeshStream mesh_stream;
+		std::atomic<bool> mesh_cancel;
+		std::atomic<uint32_t> load_percent;
+		DeletionQueue deletion_queue;
+		VkBuffer staging_ring;
+		VkDeviceMemory staging_ring_memory;
+		uint8_t *staging_ring_data;
+		FrameCapture frame_capture;
 		std::vector<VkSemaphore> image_sem;
 		std::vector<VkSemaphore> render_sem;
-		std::vector<VkFence> frame_fence;
+		VkSemaphore timeline;
+		uint64_t timeline_value;
+		std::vector<uint64_t> frame_value;
+		PFN_vkWaitSemaphoresKHR wait_semaphores;
+		PFN_vkGetSemaphoreCounterValueKHR get_semaphore_counter;
+		VkQueryPool query_pool;
+		std::vector<bool> query_written;
+		double timestamp_period;
+		bool software;
+		SoftRasterizer rasterizer;
+		SoftRasterizer::Texture soft_texture;
+		SoftRasterizer::Frame soft_back;
+		SoftRasterizer::Frame soft_pending;
+		SoftRasterizer::Frame soft_front;
+		bool soft_ready;
+		std::mutex soft_mutex;
 
 		uint32_t curr_frame;
+		uint64_t frame_count;
+		bool framebuffer_resized;
+		bool scene_dirty;
+		bool minimized;
+		bool animating;
+		float rotation;
+		std::chrono::steady_clock::time_point last_animation;
+		std::chrono::steady_clock::time_point startup;
+		FramePacer pacer;
+		InputLog input_log;
+		int drawable_width;
+		int drawable_height;
+		std::atomic<bool> running;
+		std::exception_ptr render_error;
+		SpscQueue<SDL_Event, SCOP_EVENT_QUEUE_SIZE> events;
 
 		const bool enableValidationLayers;
 
@@ -63,25 +247,49 @@ class Scop
 		};
 
 		Scop(void);
+		Scop(const Options &options);
 		Scop(const Scop &cpy);
 		virtual ~Scop(void) noexcept;
 
 		Scop &operator=(const Scop &cpy);
 
 		bool manageEvent(void);
+		bool replayEvents(void);
+		bool handleEvent(SDL_Event &event);
+		bool keyboardEvent(SDL_Keycode &key);
+		void windowEvent(SDL_WindowEvent &window);
+		bool isIdle(void);
+		void animate(void);
+		Transform computeTransform(void);
+		void initRenderer(void);
 		void initVulkan(void);
+		void initSoftware(void);
+		void loadSoftwareTexture(void);
+		void loadMesh(void);
+		void frameBounds(const Mesh::Bounds &bounds);
+		void loadShaders(void);
+		ShaderCode loadShader(const std::string &name, const uint32_t *code,
+			size_t size);
 		void destroySemaphores(void);
-		void destroyFences(void);
+		void waitTimeline(uint64_t value);
+		uint64_t getCompletedValue(void);
 		void cleanupSwapChain(void);
+		void destroyBuffers(void);
+		void retireSwapChain(void);
+		void retire(std::function<void(void)> destroy);
 		void cleanup(void);
 		void createInstance(void);
 		void setupDebugMessenger(void);
 		void createSurface(void);
 		void checkValidationLayerSupport(void);
 		void pickPhysicalDevice(void);
+		VkPhysicalDevice benchmarkDevices(
+			const std::vector<VkPhysicalDevice> &candidates);
 		bool isDeviceSuitable(const VkPhysicalDevice &device);
 		QueueFamilyIndices findQueueFamilies(const VkPhysicalDevice &device);
 		bool checkDeviceExtensionSupport(const VkPhysicalDevice &device);
+		std::vector<const char *> getDeviceExtensions(
+			const VkPhysicalDevice &device);
 		SwapChainSupportDetails querySwapChainSupport(
 			const VkPhysicalDevice &device);
 		VkSurfaceFormatKHR chooseSwapSurfaceFormat(
@@ -91,27 +299,40 @@ class Scop
 		VkExtent2D chooseSwapExtent(
 			const VkSurfaceCapabilitiesKHR &capabilities);
 		void createSwapChain(void);
+		bool supportsDynamicRendering(void);
+		bool supportsMemoryBudget(void);
+		bool supportsSynchronization2(void);
 		void createLogicalDevice(void);
 		void createImageViews(void);
 		VkAttachmentDescription setAttachmentDescription(void);
 		VkAttachmentReference setAttachmentReference(void);
-		VkSubpassDescription setSubpassDescription(VkAttachmentReference *ref);
-		VkSubpassDependency setSubpassDependency(void);
+		VkAttachmentDescription setDepthAttachmentDescription(void);
+		VkAttachmentReference setDepthAttachmentReference(void);
+		VkSubpassDescription setSubpassDescription(VkAttachmentReference *ref,
+			VkAttachmentReference *depth_ref);
 		void createRenderPass(void);
 		VkPipelineShaderStageCreateInfo setVertexInfo(VkShaderModule &module);
-		VkPipelineShaderStageCreateInfo setFragmentInfo(VkShaderModule &module);
-		VkPipelineVertexInputStateCreateInfo setVertexInput(void);
+		VkPipelineShaderStageCreateInfo setFragmentInfo(VkShaderModule &module,
+			const VkSpecializationInfo *specialization);
+		VkPipelineVertexInputStateCreateInfo setVertexInput(
+			std::vector<VkVertexInputBindingDescription> &bindings,
+			std::vector<VkVertexInputAttributeDescription> &attributes);
 		VkPipelineInputAssemblyStateCreateInfo setInputAssembly(void);
 		std::vector<VkDynamicState> setDynamicStates(void);
 		VkPipelineDynamicStateCreateInfo setDynamicState(
 			std::vector<VkDynamicState> &states);
 		VkPipelineViewportStateCreateInfo setViewportState(void);
-		VkPipelineRasterizationStateCreateInfo setRasterizer(void);
-		VkPipelineMultisampleStateCreateInfo setMultisampling(void);
-		VkPipelineColorBlendAttachmentState setColorBlendAttachment(void);
+		VkPipelineRasterizationStateCreateInfo setRasterizer(
+			VkCullModeFlags cull);
+		VkPipelineMultisampleStateCreateInfo setMultisampling(
+			VkSampleCountFlagBits samples);
+		VkPipelineDepthStencilStateCreateInfo setDepthStencil(
+			VkCompareOp compare, bool write);
+		VkPipelineColorBlendAttachmentState setColorBlendAttachment(
+			bool blend);
 		VkPipelineColorBlendStateCreateInfo setColorBlend(
 			VkPipelineColorBlendAttachmentState &color_blend);
-		VkShaderModule createShaderModule(const std::vector<char> &code);
+		VkShaderModule createShaderModule(const ShaderCode &code);
 		void createPipelineLayout(void);
 		void assembleGraphicsPipeline(
 			VkPipelineShaderStageCreateInfo        *shader_stages,
@@ -121,25 +342,104 @@ class Scop
 			VkPipelineViewportStateCreateInfo      &viewport_state,
 			VkPipelineRasterizationStateCreateInfo &rasterizer,
 			VkPipelineMultisampleStateCreateInfo   &multisampling,
-			VkPipelineColorBlendStateCreateInfo    &color_blending);
-		void createGraphicsPipeline(void);
+			VkPipelineDepthStencilStateCreateInfo  &depth_stencil,
+			VkPipelineColorBlendStateCreateInfo    &color_blending,
+			uint32_t                               stage_count,
+			VkPipeline                             &pipeline);
+		void createShaderModules(void);
+		VkPipeline createPipeline(const PipelineVariants::Key &key);
+		PipelineVariants::Key getDepthVariant(void);
+		void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
+			VkMemoryPropertyFlags properties, VkBuffer &buffer,
+			VkDeviceMemory &memory);
+		void copyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size);
+		void createDeviceLocalBuffer(const void *data, VkDeviceSize size,
+			VkBufferUsageFlags usage, VkBuffer &buffer, VkDeviceMemory &memory);
+		void createHostBuffer(const void *data, VkDeviceSize size,
+			VkBufferUsageFlags usage, VkBuffer &buffer, VkDeviceMemory &memory);
+		void uploadMesh(bool device_local);
+		void retireMesh(void);
+		void createVertexBuffers(void);
+		void stageUpload(VkCommandBuffer buffer, const void *data,
+			VkDeviceSize size, VkDeviceSize ring_offset, VkBuffer dst,
+			VkDeviceSize dst_offset);
+		void growMeshBuffer(VkCommandBuffer buffer, VkDeviceSize size,
+			VkDeviceSize used, VkBufferUsageFlags usage, VkBuffer &mesh_buffer,
+			VkDeviceMemory &memory, VkDeviceSize &capacity);
+		VkDeviceSize pollMesh(VkCommandBuffer buffer);
+		void pageInMesh(VkCommandBuffer buffer);
+		void reportMesh(void);
+		VkCommandBuffer beginSingleTimeCommands(void);
+		void endSingleTimeCommands(VkCommandBuffer buffer);
+		VkFormat findDepthFormat(void);
+		void createImage(uint32_t width, uint32_t height, VkFormat format,
+			uint32_t mip_levels, VkImageUsageFlags usage, VkImage &image,
+			VkDeviceMemory &memory);
+		VkImageView createImageView(VkImage image, VkFormat format,
+			VkImageAspectFlags aspect, uint32_t base_level,
+			uint32_t level_count);
+		void buildRenderGraph(void);
+		bool needsCapturePass(void) const;
+		void rebuildRenderGraph(void);
+		void createDescriptorSetLayout(void);
+		void createSampler(void);
+		void createDescriptorPool(void);
+		void createDescriptorSets(void);
+		void updateDescriptorSet(void);
+		TextureUpload createTextureUpload(uint32_t width, uint32_t height,
+			uint32_t mip_levels, VkFormat format, bool gpu_mips);
+		void destroyTexture(Texture &texture);
+		void createStagingRing(void);
+		void createPlaceholderTexture(void);
+		bool supportsLinearBlit(VkFormat format);
+		bool supportsBlockCompression(void);
+		TextureUpload prepareTexture(const std::string &path);
+		TextureUpload prepareCompressedTexture(const Image &image,
+			std::chrono::steady_clock::time_point start);
+		void loadTexture(const std::string &path);
+		bool recordTextureStream(VkCommandBuffer buffer,
+			TextureUpload &upload, VkDeviceSize ring_offset,
+			VkDeviceSize budget);
+		void recordMipBlits(VkCommandBuffer buffer,
+			const TextureUpload &upload);
+		void pollTexture(VkCommandBuffer buffer, VkDeviceSize used);
+		void reportTexture(void);
+		void cleanupTextures(void);
+		bool usesTexture(void);
+		bool evict(uint32_t resource);
+		void manageResidency(void);
 		void createFramebuffers(void);
 		void createCommandPool(void);
 		void createCommandBuffers(void);
 		void createSyncObjects(void);
+		void createQueryPool(void);
 		VkCommandBufferBeginInfo setBufferBeginInfo(void);
 		VkRenderPassBeginInfo setRenderPassBeginInfo(uint32_t image_index,
-			const VkClearValue &clear_color);
+			const VkClearValue *clear_values);
 		VkViewport setViewport(void);
+		void beginRendering(VkCommandBuffer buffer, uint32_t image_index,
+			const VkClearValue *clear_values);
+		void endRendering(VkCommandBuffer buffer);
 		void recordCommandBuffer(VkCommandBuffer buffer, uint32_t image_index);
+		void recordScene(VkCommandBuffer buffer, uint32_t image_index);
+		void recordDraw(VkCommandBuffer buffer);
 		void mainLoop(void);
+		void pumpEvents(void);
+		void renderLoop(void);
+		void stopRendering(void);
 		VkSubmitInfo setSubmitInfo(
 			VkSemaphore          *wait_semaphore,
 			VkPipelineStageFlags *wait_stage,
 			VkSemaphore          *signal_semaphore);
 		VkPresentInfoKHR setPresentInfoKHR(VkSwapchainKHR *swapchains,
 			VkSemaphore *signal_semaphore, uint32_t *image_index);
+		void waitForFrame(void);
+		void settle(void);
+		double readGpuTime(void);
 		void drawFrame(void);
+		void drawSoftware(void);
+		void presentSoftware(void);
+		void countFrame(void);
 		void queueSubmit(void);
 		void queuePresent(uint32_t *img_idx);
 		void recreateSwapChain(void);
@@ -159,6 +459,11 @@ class Scop
     		const VkDebugUtilsMessengerCallbackDataEXT  *callback_data,
     		void*                                       pUserData);
 		static std::vector<char> readFile(const std::string &name);
+		bool hasVulkanDevice(void);
+		static std::vector<VkVertexInputBindingDescription>
+			getBindingDescriptions(bool position_only);
+		static std::vector<VkVertexInputAttributeDescription>
+			getAttributeDescriptions(bool position_only);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,25 @@
+#ifndef SHADERS_HPP
+# define SHADERS_HPP
+# include <cstdint>
+
+/**
+ * SPIR-V of the shaders, compiled into the program. Each .inc file is the C
+ * initializer list glslc -mfmt=c writes at build time (see Makefile).
+ */
+constexpr uint32_t SHADER_VERT[] =
+# include <vert.inc>
+;
+
+constexpr uint32_t SHADER_FRAG[] =
+# include <frag.inc>
+;
+
+constexpr uint32_t SHADER_DEPTH[] =
+# include <depth.inc>
+;
+
+constexpr uint32_t SHADER_FILL[] =
+# include <fill.inc>
+;
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef SOFTRASTERIZER_HPP
+# define SOFTRASTERIZER_HPP
+
+# define SOFTRASTERIZER_TILE 64
+# define SOFTRASTERIZER_BLOCK 8
+# define SOFTRASTERIZER_BATCH 4096
+# define SOFTRASTERIZER_MIN_W 1e-6f
+# define SOFTRASTERIZER_CLEAR 0xff000000u
+# define SOFTRASTERIZER_SRGB_TABLE_SIZE 4096
+
+# include <Error.hpp>
+# include <ThreadPool.hpp>
+# include <PipelineVariants.hpp>
+# include <Mesh.hpp>
+# include <Mat4.hpp>
+# include <vector>
+# include <cstdint>
+# include <cmath>
+# include <algorithm>
+# include <bit>
+# if defined(__x86_64__) || defined(__i386__)
+#  define SOFTRASTERIZER_AVX2
+#  include <immintrin.h>
+# endif
+
+/**
+ * CPU renderer of a mesh, drawing what the graphics pipeline would into
+ * 32 bits ARGB pixels. Vertices are transformed in parallel, then triangles
+ * are set up and binned into SOFTRASTERIZER_TILE pixels square tiles by
+ * batches, and the tiles are rasterized in parallel, each by a single thread
+ * walking the batches in order. Within a tile, blocks of SOFTRASTERIZER_BLOCK
+ * pixels keep their farthest depth so that whole blocks behind what is drawn
+ * are skipped. Edge functions and depth tests run on 8 pixels at once with
+ * AVX2 when the CPU supports it, one pixel at a time otherwise.
+ */
+class SoftRasterizer
+{
+	public:
+		struct Frame
+		{
+			std::vector<uint32_t> color;
+			uint32_t width;
+			uint32_t height;
+			uint32_t stride;
+		};
+		struct Texture
+		{
+			uint32_t width;
+			uint32_t height;
+			std::vector<uint8_t> texels;
+		};
+
+	private:
+		struct Vertex
+		{
+			float x;
+			float y;
+			float z;
+			float inv_w;
+			Vec3 normal;
+			float uv[2];
+		};
+		struct Triangle
+		{
+			float edge[3][3];
+			bool top_left[3];
+			float depth[3];
+			uint32_t vertex[3];
+			uint32_t min_x;
+			uint32_t min_y;
+			uint32_t max_x;
+			uint32_t max_y;
+			float min_z;
+		};
+		struct Batch
+		{
+			std::vector<Triangle> triangles;
+			std::vector<std::vector<uint32_t>> bins;
+		};
+
+		ThreadPool *pool;
+		bool avx2;
+		uint32_t tiles_x;
+		uint32_t tiles_y;
+		std::vector<Vertex> vertices;
+		std::vector<Batch> batches;
+		std::vector<float> depth;
+		std::vector<float> block_depth;
+
+		void resize(Frame &frame);
+		void transform(const Mesh &mesh, const Mat4 &mvp, const Mat4 &model,
+			const Frame &frame);
+		void bin(const Mesh &mesh, Batch &batch, size_t begin, size_t end,
+			VkCullModeFlags cull, const Frame &frame);
+		void rasterizeTile(size_t tile, const PipelineVariants::Key &key,
+			const Texture &texture, Frame &frame);
+		void rasterizeBlock(const Triangle &triangle, uint32_t block_x,
+			uint32_t block_y, const PipelineVariants::Key &key,
+			const Texture &texture, Frame &frame);
+		void updateBlockDepth(uint32_t block_x, uint32_t block_y,
+			uint32_t stride);
+		uint32_t shade(const Triangle &triangle, const float lambda[3],
+			uint32_t dst, const PipelineVariants::Key &key,
+			const Texture &texture) const;
+
+		static uint32_t coverRow(const Triangle &triangle, float left,
+			float center, float width, float *row_depth,
+			float lambda[3][SOFTRASTERIZER_BLOCK]);
+		static float farthestDepth(const float *row, uint32_t stride);
+# if defined(SOFTRASTERIZER_AVX2)
+		static uint32_t coverRowAvx2(const Triangle &triangle, float left,
+			float center, float width, float *row_depth,
+			float lambda[3][SOFTRASTERIZER_BLOCK]);
+		static float farthestDepthAvx2(const float *row, uint32_t stride);
+# endif
+
+	public:
+		SoftRasterizer(void);
+		SoftRasterizer(ThreadPool &pool);
+		SoftRasterizer(const SoftRasterizer &cpy);
+		virtual ~SoftRasterizer(void) noexcept;
+
+		SoftRasterizer &operator=(const SoftRasterizer &cpy);
+
+		void draw(const Mesh &mesh, const Mat4 &mvp, const Mat4 &model,
+			const PipelineVariants::Key &key, const Texture &texture,
+			Frame &frame);
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef SPSCQUEUE_HPP
+# define SPSCQUEUE_HPP
+# include <atomic>
+# include <array>
+# include <cstddef>
+
+/**
+ * Bounded lock-free queue for exactly one producer thread and one consumer
+ * thread. <N> must be a power of two. Head and tail only ever grow, the slot
+ * index is taken modulo <N>.
+ */
+template <typename T, size_t N>
+class SpscQueue
+{
+	static_assert(N && !(N & (N - 1)), "SpscQueue size must be a power of 2");
+
+	private:
+		alignas(64) std::atomic<size_t> head;
+		alignas(64) std::atomic<size_t> tail;
+		std::array<T, N> buffer;
+
+	public:
+		SpscQueue(void) : head {0}, tail {0}, buffer {}
+		{
+			// Empty;
+		}
+
+		/**
+		 * Atomics can't be copied, a copy starts empty.
+		 */
+		SpscQueue(const SpscQueue &cpy) : SpscQueue()
+		{
+			(void)cpy;
+		}
+
+		virtual ~SpscQueue(void) noexcept
+		{
+			// Empty;
+		}
+
+		SpscQueue &operator=(const SpscQueue &cpy)
+		{
+			(void)cpy;
+			return (*this);
+		}
+
+		/**
+		 * Producer side. Returns false if the queue is full.
+		 */
+		bool push(const T &value)
+		{
+			size_t t {tail.load(std::memory_order_relaxed)};
+
+			if (t - head.load(std::memory_order_acquire) == N)
+			{
+				return (false);
+			}
+			buffer[t & (N - 1)] = value;
+			tail.store(t + 1, std::memory_order_release);
+			tail.notify_one();
+			return (true);
+		}
+
+		/**
+		 * Consumer side. Returns false if the queue is empty.
+		 */
+		bool pop(T &value)
+		{
+			size_t h {head.load(std::memory_order_relaxed)};
+
+			if (h == tail.load(std::memory_order_acquire))
+			{
+				return (false);
+			}
+			value = buffer[h & (N - 1)];
+			head.store(h + 1, std::memory_order_release);
+			return (true);
+		}
+
+		/**
+		 * Consumer side. Blocks until the queue holds at least one element.
+		 */
+		void wait(void) const
+		{
+			tail.wait(head.load(std::memory_order_relaxed),
+				std::memory_order_acquire);
+		}
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef TASKGRAPH_HPP
+# define TASKGRAPH_HPP
+# include <Error.hpp>
+# include <ThreadPool.hpp>
+# include <string>
+# include <vector>
+# include <deque>
+# include <mutex>
+# include <condition_variable>
+# include <functional>
+# include <exception>
+# include <thread>
+# include <chrono>
+# include <ostream>
+# include <iomanip>
+# include <algorithm>
+
+/**
+ * Tasks with dependencies, run as soon as their dependencies are done: on the
+ * pool, or on the thread calling run() for tasks bound to it. Every task is
+ * timed so that a run can be written out as a trace.
+ */
+class TaskGraph
+{
+	private:
+		struct Node
+		{
+			std::string name;
+			std::function<void(void)> task;
+			std::vector<size_t> dependents;
+			size_t dependencies;
+			bool main_thread;
+			size_t waiting;
+			double start_ms;
+			double end_ms;
+			std::thread::id thread;
+		};
+
+		std::vector<Node> nodes;
+		std::mutex mutex;
+		std::condition_variable changed;
+		std::deque<size_t> main_ready;
+		size_t remaining;
+		std::exception_ptr error;
+		std::chrono::steady_clock::time_point origin;
+
+		void dispatch(size_t node, ThreadPool &pool);
+		void execute(size_t node, ThreadPool &pool);
+
+	public:
+		TaskGraph(void);
+		TaskGraph(const TaskGraph &cpy);
+		virtual ~TaskGraph(void) noexcept;
+
+		TaskGraph &operator=(const TaskGraph &cpy);
+
+		size_t add(const std::string &name, std::function<void(void)> task,
+			const std::vector<size_t> &dependencies = {},
+			bool main_thread = false);
+		void run(ThreadPool &pool);
+		double getDuration(void) const;
+		void writeSummary(std::ostream &out) const;
+		void writeTrace(std::ostream &out) const;
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef TEXTURECACHE_HPP
+# define TEXTURECACHE_HPP
+
+# define TEXTURECACHE_DIRECTORY ".scop_cache"
+# define TEXTURECACHE_VERSION 1
+
+# include <BlockCompressor.hpp>
+# include <string>
+# include <vector>
+# include <fstream>
+# include <filesystem>
+# include <system_error>
+# include <cstdio>
+# include <cstdint>
+# include <cstring>
+
+/**
+ * Directory of block compressed mip chains, one file per source image content
+ * hash and encoding mode, so that a texture is only ever encoded once.
+ */
+class TextureCache
+{
+	public:
+		struct Header
+		{
+			char magic[4];
+			uint32_t version;
+			uint32_t format;
+			uint32_t width;
+			uint32_t height;
+			uint32_t levels;
+			uint64_t size;
+		};
+
+	private:
+		std::string directory;
+
+		std::string path(uint64_t hash, BlockCompressor::Mode mode) const;
+
+	public:
+		TextureCache(void);
+		TextureCache(const std::string &directory);
+		TextureCache(const TextureCache &cpy);
+		virtual ~TextureCache(void) noexcept;
+
+		TextureCache &operator=(const TextureCache &cpy);
+
+		bool read(uint64_t hash, BlockCompressor::Mode mode, uint32_t width,
+			uint32_t height, uint32_t levels, Header &header,
+			std::vector<uint8_t> &data) const;
+		bool write(uint64_t hash, BlockCompressor::Mode mode,
+			const Header &header, const uint8_t *data) const;
+};
+
+#endif
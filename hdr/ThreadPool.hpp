@@ -0,0 +1,63 @@
+#ifndef THREADPOOL_HPP
+# define THREADPOOL_HPP
+# include <thread>
+# include <mutex>
+# include <condition_variable>
+# include <functional>
+# include <future>
+# include <memory>
+# include <atomic>
+# include <vector>
+# include <deque>
+# include <algorithm>
+# include <type_traits>
+# include <exception>
+
+/**
+ * Fixed set of worker threads executing queued tasks in submission order.
+ */
+class ThreadPool
+{
+	private:
+		std::vector<std::thread> workers;
+		std::deque<std::function<void(void)>> tasks;
+		std::mutex mutex;
+		std::condition_variable available;
+		bool stopping;
+
+		void work(void);
+		void push(std::function<void(void)> task);
+
+	public:
+		ThreadPool(void);
+		ThreadPool(size_t count);
+		ThreadPool(const ThreadPool &cpy);
+		virtual ~ThreadPool(void) noexcept;
+
+		ThreadPool &operator=(const ThreadPool &cpy);
+
+		size_t size(void) const;
+		void parallelFor(size_t count,
+			const std::function<void(size_t, size_t)> &body);
+
+		/**
+		 * Queues <task> and returns a future of its result. Exceptions thrown
+		 * by the task are rethrown by the future.
+		 */
+		template <typename F>
+		std::future<std::invoke_result_t<F>> submit(F task)
+		{
+			auto packaged {std::make_shared<
+				std::packaged_task<std::invoke_result_t<F>(void)>>(
+					std::move(task))};
+			std::future<std::invoke_result_t<F>> result {
+				packaged->get_future()};
+
+			push([packaged](void) { (*packaged)(); });
+			return (result);
+		}
+
+		static size_t defaultSize(void);
+};
+
+#endif
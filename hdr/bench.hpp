@@ -0,0 +1,18 @@
+#ifndef BENCH_HPP
+# define BENCH_HPP
+
+# define BENCH_MATRICES 256
+
+# include <iostream>
+# include <fstream>
+# include <exception>
+# include <unordered_map>
+# include <vector>
+# include <string>
+# include <cstring>
+# include <Error.hpp>
+# include <Mesh.hpp>
+# include <Mat4.hpp>
+# include <Benchmark.hpp>
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef OPT_HPP
+# define OPT_HPP
+
+# define OPT_EXTENSION ".scma"
+
+# include <iostream>
+# include <iomanip>
+# include <exception>
+# include <filesystem>
+# include <system_error>
+# include <chrono>
+# include <future>
+# include <vector>
+# include <string>
+# include <cstring>
+# include <Error.hpp>
+# include <Mesh.hpp>
+# include <MeshOptimizer.hpp>
+# include <ThreadPool.hpp>
+
+#endif
@@ -0,0 +1,16 @@
+#version 450
+
+layout(push_constant) uniform Transform
+{
+	mat4 mvp;
+	mat4 model;
+} transform;
+
+layout(location = 0) in vec3 in_position;
+
+invariant gl_Position;
+
+void main()
+{
+	gl_Position = transform.mvp * vec4(in_position, 1.0);
+}
@@ -1,10 +1,31 @@
 #version 450
 
-layout(location = 0) in vec3 frag_color;
+// Pipeline variants: 0 lit, 1 unlit, 2 normals.
+layout(constant_id = 0) const int shading = 0;
+layout(constant_id = 1) const bool blend = false;
+
+layout(binding = 0) uniform sampler2D albedo;
+
+layout(location = 0) in vec3 frag_normal;
+layout(location = 1) in vec2 frag_uv;
 
 layout(location = 0) out vec4 out_color;
 
+const vec3 light_dir = normalize(vec3(0.4, 0.7, 0.6));
+
 void main()
 {
-	out_color = vec4(frag_color, 1.0);
-}
\ No newline at end of file
+	vec3 normal = normalize(frag_normal);
+	vec4 texel = texture(albedo, vec2(frag_uv.x, 1.0 - frag_uv.y));
+	vec3 color = texel.rgb;
+
+	if (shading == 0)
+	{
+		color *= 0.15 + 0.85 * abs(dot(normal, light_dir));
+	}
+	else if (shading == 2)
+	{
+		color = normal * 0.5 + 0.5;
+	}
+	out_color = vec4(color, blend ? texel.a : 1.0);
+}
@@ -1,21 +1,23 @@
 #version 450
 
-layout(location = 0) out vec3 frag_color;
+layout(push_constant) uniform Transform
+{
+	mat4 mvp;
+	mat4 model;
+} transform;
+
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec3 in_normal;
+layout(location = 2) in vec2 in_uv;
 
-vec2 positions[3] = vec2[](
-	vec2(0.0, -0.5),
-	vec2(0.5, 0.5),
-	vec2(-0.5, 0.5)
-);
+layout(location = 0) out vec3 frag_normal;
+layout(location = 1) out vec2 frag_uv;
 
-vec3 colors[3] = vec3[](
-	vec3(1.0, 0.0, 0.0),
-	vec3(0.0, 1.0, 0.0),
-	vec3(0.0, 0.0, 1.0)
-);
+invariant gl_Position;
 
 void main()
 {
-	gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-	frag_color = colors[gl_VertexIndex];
-}
\ No newline at end of file
+	gl_Position = transform.mvp * vec4(in_position, 1.0);
+	frag_normal = mat3(transform.model) * in_normal;
+	frag_uv = in_uv;
+}
@@ -0,0 +1,288 @@
+#include <Benchmark.hpp>
+
+/**
+ * Harness with the default warmup and repetitions.
+ */
+Benchmark::Benchmark(void) :
+	Benchmark(BENCHMARK_WARMUP, BENCHMARK_REPETITIONS)
+{
+	// Empty;
+}
+
+/**
+ * Harness discarding <warmup> samples then keeping up to <repetitions>, at
+ * least one.
+ */
+Benchmark::Benchmark(size_t warmup, size_t repetitions) :
+	warmup {warmup},
+	repetitions {std::max<size_t>(repetitions, 1)},
+	cycles_fd {-1},
+	instructions_fd {-1}
+{
+	openCounters();
+}
+
+/**
+ * Copy constructor, the counters belong to their harness so the copy opens
+ * its own.
+ */
+Benchmark::Benchmark(const Benchmark &cpy) :
+	Benchmark(cpy.warmup, cpy.repetitions)
+{
+	// Empty;
+}
+
+/**
+ * Destructor, closes the counters.
+ */
+Benchmark::~Benchmark(void) noexcept
+{
+	closeCounters();
+}
+
+/**
+ * Copy assignement operator, copies the settings and keeps its counters.
+ */
+Benchmark &Benchmark::operator=(const Benchmark &cpy)
+{
+	warmup = cpy.warmup;
+	repetitions = cpy.repetitions;
+	return (*this);
+}
+
+/**
+ * Opens the cycle and instruction counters of the calling thread, in user
+ * space only, as a group so that they run over the same span. Leaves both
+ * closed if either is unavailable.
+ */
+void Benchmark::openCounters(void)
+{
+#if defined(__linux__)
+	perf_event_attr attr {};
+
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = PERF_COUNT_HW_CPU_CYCLES;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	cycles_fd = static_cast<int> (syscall(SYS_perf_event_open, &attr, 0, -1,
+		-1, 0));
+	if (cycles_fd < 0)
+	{
+		return ;
+	}
+	attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+	attr.disabled = 0;
+	instructions_fd = static_cast<int> (syscall(SYS_perf_event_open, &attr,
+		0, -1, cycles_fd, 0));
+	if (instructions_fd < 0)
+	{
+		closeCounters();
+	}
+#endif
+}
+
+/**
+ * Closes the counters.
+ */
+void Benchmark::closeCounters(void)
+{
+#if defined(__linux__)
+	if (instructions_fd >= 0)
+	{
+		close(instructions_fd);
+	}
+	if (cycles_fd >= 0)
+	{
+		close(cycles_fd);
+	}
+#endif
+	cycles_fd = -1;
+	instructions_fd = -1;
+}
+
+/**
+ * Tells if cycles and instructions are counted.
+ */
+bool Benchmark::hasCounters(void) const
+{
+	return (cycles_fd >= 0);
+}
+
+/**
+ * Runs <body> <iterations> times and returns the time it took, with the
+ * cycles and instructions it retired, negative if they aren't counted.
+ */
+Benchmark::Sample Benchmark::measure(const std::function<void(void)> &body,
+	size_t iterations)
+{
+	Sample sample {0.0, -1.0, -1.0};
+	std::chrono::steady_clock::time_point start {};
+
+#if defined(__linux__)
+	uint64_t cycles {0};
+	uint64_t instructions {0};
+
+	if (hasCounters())
+	{
+		ioctl(cycles_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+		ioctl(cycles_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	}
+#endif
+	start = std::chrono::steady_clock::now();
+	for (size_t i {0}; i < iterations; ++i)
+	{
+		body();
+	}
+	sample.ns = std::chrono::duration<double, std::nano> (
+		std::chrono::steady_clock::now() - start).count();
+#if defined(__linux__)
+	if (hasCounters())
+	{
+		ioctl(cycles_fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+		if (read(cycles_fd, &cycles, sizeof(cycles)) == sizeof(cycles)
+			&& read(instructions_fd, &instructions, sizeof(instructions))
+			== sizeof(instructions))
+		{
+			sample.cycles = static_cast<double> (cycles);
+			sample.instructions = static_cast<double> (instructions);
+		}
+	}
+#endif
+	return (sample);
+}
+
+/**
+ * Median of the sorted <values>.
+ */
+static inline double median(const std::vector<double> &values)
+{
+	size_t half {values.size() / 2};
+
+	if (values.size() % 2)
+	{
+		return (values[half]);
+	}
+	return ((values[half - 1] + values[half]) * 0.5);
+}
+
+/**
+ * Times <body>, which performs <operations> operations, and returns the
+ * median time per operation of the samples kept, with their median absolute
+ * deviation relative to it, and their average cycles and instructions per
+ * operation.
+ */
+Benchmark::Result Benchmark::run(const std::string &name, size_t operations,
+	const std::function<void(void)> &body)
+{
+	Result result {name, 0.0, 0.0, -1.0, -1.0, 0, repetitions};
+	double probe {std::max(measure(body, 1).ns, 1.0)};
+	size_t iterations {static_cast<size_t> (std::max(BENCHMARK_SAMPLE_NS
+		/ probe, 1.0))};
+	double scale {1.0 / static_cast<double> (iterations
+		* std::max<size_t>(operations, 1))};
+	std::vector<Sample> samples {};
+	std::vector<double> times {};
+	std::vector<double> deviations {};
+	double counted[2] {0.0, 0.0};
+	bool counters {true};
+
+	for (size_t i {0}; i < warmup; ++i)
+	{
+		measure(body, iterations);
+	}
+	for (size_t i {0}; i < repetitions; ++i)
+	{
+		samples.push_back(measure(body, iterations));
+		times.push_back(samples.back().ns);
+	}
+	std::sort(times.begin(), times.end());
+
+	double center {median(times)};
+
+	for (double ns : times)
+	{
+		deviations.push_back(std::fabs(ns - center));
+	}
+	std::sort(deviations.begin(), deviations.end());
+
+	double mad {median(deviations)};
+	double limit {BENCHMARK_OUTLIER * 1.4826 * mad};
+
+	times.clear();
+	for (const Sample &sample : samples)
+	{
+		if (std::fabs(sample.ns - center) > limit)
+		{
+			continue ;
+		}
+		times.push_back(sample.ns);
+		counted[0] += sample.cycles;
+		counted[1] += sample.instructions;
+		counters = counters && sample.cycles >= 0.0;
+	}
+	std::sort(times.begin(), times.end());
+	result.kept = times.size();
+	result.ns = median(times) * scale;
+	result.spread = mad / center;
+	if (counters)
+	{
+		result.cycles = counted[0] * scale / static_cast<double> (result.kept);
+		result.instructions = counted[1] * scale
+			/ static_cast<double> (result.kept);
+	}
+	return (result);
+}
+
+/**
+ * Writes <result> on a line: its name then its time per operation first, so
+ * that the line can be read back by readResults, then the spread, counters
+ * and kept samples. The change from the time of the same name in <baseline>
+ * follows if there is one.
+ */
+void Benchmark::writeResult(std::ostream &out, const Result &result,
+	const std::map<std::string, double> &baseline)
+{
+	auto previous {baseline.find(result.name)};
+
+	out << std::left << std::setw(32) << result.name << std::right
+		<< std::fixed << std::setprecision(3) << std::setw(10) << result.ns
+		<< " ns/op " << std::setprecision(1) << std::setw(6)
+		<< result.spread * 100.0 << "%";
+	if (result.cycles >= 0.0)
+	{
+		out << std::setw(9) << result.cycles << " cyc/op" << std::setw(9)
+			<< result.instructions << " ins/op";
+	}
+	out << std::setw(6) << result.kept << "/" << result.samples;
+	if (previous != baseline.end() && previous->second > 0.0)
+	{
+		out << std::showpos << std::setw(9) << (result.ns / previous->second
+			- 1.0) * 100.0 << "%" << std::noshowpos;
+	}
+	out << std::endl;
+}
+
+/**
+ * Reads the times per operation of results written by writeResult, by name.
+ * Lines starting with # are comments.
+ */
+std::map<std::string, double> Benchmark::readResults(std::istream &in)
+{
+	std::map<std::string, double> results {};
+	std::string line {};
+
+	while (std::getline(in, line))
+	{
+		std::istringstream fields {line};
+		std::string name {};
+		double ns {0.0};
+
+		if (!line.empty() && line[0] != '#' && fields >> name >> ns)
+		{
+			results[name] = ns;
+		}
+	}
+	return (results);
+}
@@ -0,0 +1,510 @@
+#include <BlockCompressor.hpp>
+
+/**
+ * Copies the 4x4 block at block coordinates <bx>, <by> of the RGBA level
+ * <src> to <block>. Texels past the edges of the level repeat the edge.
+ */
+static inline void fetchBlock(const uint8_t *src, uint32_t width,
+	uint32_t height, uint32_t bx, uint32_t by, uint8_t *block)
+{
+	for (uint32_t y {0}; y < 4; ++y)
+	{
+		uint32_t sy {std::min(by * 4 + y, height - 1)};
+
+		for (uint32_t x {0}; x < 4; ++x)
+		{
+			uint32_t sx {std::min(bx * 4 + x, width - 1)};
+
+			std::memcpy(block + (y * 4 + x) * 4,
+				src + (static_cast<size_t> (sy) * width + sx) * 4, 4);
+		}
+	}
+}
+
+/**
+ * Builds the four colors palette of the 565 endpoints <c0> and <c1>.
+ */
+static inline void makePalette(uint16_t c0, uint16_t c1, float palette[4][3])
+{
+	BlockCompressor::fromRgb565(c0, palette[0]);
+	BlockCompressor::fromRgb565(c1, palette[1]);
+	for (int c {0}; c < 3; ++c)
+	{
+		palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+		palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+	}
+}
+
+/**
+ * Picks the closest palette entry of each texel of <block> into <indices> and
+ * returns the total squared error.
+ */
+static inline float selectIndices(const uint8_t *block,
+	const float palette[4][3], uint8_t *indices)
+{
+	float error {0.0f};
+
+	for (int i {0}; i < 16; ++i)
+	{
+		float best {INFINITY};
+
+		for (uint8_t p {0}; p < 4; ++p)
+		{
+			float dr {block[i * 4] - palette[p][0]};
+			float dg {block[i * 4 + 1] - palette[p][1]};
+			float db {block[i * 4 + 2] - palette[p][2]};
+			float d {dr * dr + dg * dg + db * db};
+
+			if (d < best)
+			{
+				best = d;
+				indices[i] = p;
+			}
+		}
+		error += best;
+	}
+	return (error);
+}
+
+/**
+ * Endpoints at the corners of the bounding box of the block colors, inset by
+ * a sixteenth of its size since extremes are rarely hit exactly.
+ */
+static inline void boundingBoxEndpoints(const uint8_t *block, float *e0,
+	float *e1)
+{
+	for (int c {0}; c < 3; ++c)
+	{
+		float lo {255.0f};
+		float hi {0.0f};
+
+		for (int i {0}; i < 16; ++i)
+		{
+			lo = std::min(lo, static_cast<float> (block[i * 4 + c]));
+			hi = std::max(hi, static_cast<float> (block[i * 4 + c]));
+		}
+		e0[c] = hi - (hi - lo) / 16.0f;
+		e1[c] = lo + (hi - lo) / 16.0f;
+	}
+}
+
+/**
+ * Endpoints at the extreme projections of the block colors on their principal
+ * axis, found by power iteration on the covariance matrix.
+ */
+static inline void principalAxisEndpoints(const uint8_t *block, float *e0,
+	float *e1)
+{
+	float mean[3] {0.0f, 0.0f, 0.0f};
+	float cov[6] {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+	float axis[3] {1.0f, 1.0f, 1.0f};
+	float lo {INFINITY};
+	float hi {-INFINITY};
+
+	for (int i {0}; i < 16; ++i)
+	{
+		for (int c {0}; c < 3; ++c)
+		{
+			mean[c] += block[i * 4 + c] / 16.0f;
+		}
+	}
+	for (int i {0}; i < 16; ++i)
+	{
+		float r {block[i * 4] - mean[0]};
+		float g {block[i * 4 + 1] - mean[1]};
+		float b {block[i * 4 + 2] - mean[2]};
+
+		cov[0] += r * r;
+		cov[1] += r * g;
+		cov[2] += r * b;
+		cov[3] += g * g;
+		cov[4] += g * b;
+		cov[5] += b * b;
+	}
+	for (int k {0}; k < 8; ++k)
+	{
+		float next[3] {
+			cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2],
+			cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2],
+			cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2]};
+		float norm {std::sqrt(next[0] * next[0] + next[1] * next[1]
+			+ next[2] * next[2])};
+
+		if (norm < 1e-6f)
+		{
+			break ;
+		}
+		for (int c {0}; c < 3; ++c)
+		{
+			axis[c] = next[c] / norm;
+		}
+	}
+	for (int i {0}; i < 16; ++i)
+	{
+		float t {(block[i * 4] - mean[0]) * axis[0]
+			+ (block[i * 4 + 1] - mean[1]) * axis[1]
+			+ (block[i * 4 + 2] - mean[2]) * axis[2]};
+
+		lo = std::min(lo, t);
+		hi = std::max(hi, t);
+	}
+	for (int c {0}; c < 3; ++c)
+	{
+		e0[c] = std::clamp(mean[c] + axis[c] * hi, 0.0f, 255.0f);
+		e1[c] = std::clamp(mean[c] + axis[c] * lo, 0.0f, 255.0f);
+	}
+}
+
+/**
+ * Solves for the endpoints best reproducing <block> in the least squares
+ * sense, given the palette entry of each texel. Returns false if the system is
+ * degenerate (every texel on the same entry).
+ */
+static inline bool refineEndpoints(const uint8_t *block,
+	const uint8_t *indices, float *e0, float *e1)
+{
+	static const float weights[4] {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+	float aa {0.0f};
+	float bb {0.0f};
+	float ab {0.0f};
+	float ax[3] {0.0f, 0.0f, 0.0f};
+	float bx[3] {0.0f, 0.0f, 0.0f};
+
+	for (int i {0}; i < 16; ++i)
+	{
+		float a {weights[indices[i]]};
+		float b {1.0f - a};
+
+		aa += a * a;
+		bb += b * b;
+		ab += a * b;
+		for (int c {0}; c < 3; ++c)
+		{
+			ax[c] += a * block[i * 4 + c];
+			bx[c] += b * block[i * 4 + c];
+		}
+	}
+
+	float det {aa * bb - ab * ab};
+
+	if (std::fabs(det) < 1e-6f)
+	{
+		return (false);
+	}
+	for (int c {0}; c < 3; ++c)
+	{
+		e0[c] = std::clamp((ax[c] * bb - bx[c] * ab) / det, 0.0f, 255.0f);
+		e1[c] = std::clamp((bx[c] * aa - ax[c] * ab) / det, 0.0f, 255.0f);
+	}
+	return (true);
+}
+
+/**
+ * Fast mode compressor.
+ */
+BlockCompressor::BlockCompressor(void) : BlockCompressor(FAST)
+{
+	// Empty;
+}
+
+/**
+ * Compressor using <mode>.
+ */
+BlockCompressor::BlockCompressor(Mode mode) : mode {mode}
+{
+	// Empty;
+}
+
+/**
+ * Copy constructor.
+ */
+BlockCompressor::BlockCompressor(const BlockCompressor &cpy) : mode {cpy.mode}
+{
+	// Empty;
+}
+
+/**
+ * Destructor.
+ */
+BlockCompressor::~BlockCompressor(void) noexcept
+{
+	// Empty;
+}
+
+/**
+ * Copy assignement operator.
+ */
+BlockCompressor &BlockCompressor::operator=(const BlockCompressor &cpy)
+{
+	mode = cpy.mode;
+	return (*this);
+}
+
+/**
+ * Encoding mode.
+ */
+BlockCompressor::Mode BlockCompressor::getMode(void) const
+{
+	return (mode);
+}
+
+/**
+ * Encodes the colors of the 16 RGBA texels of <block> to the 8 bytes of a BC1
+ * color block, always in four colors mode as BC3 requires it.
+ */
+void BlockCompressor::encodeColor(const uint8_t *block, uint8_t *out) const
+{
+	float e0[3];
+	float e1[3];
+	float palette[4][3];
+	uint8_t indices[16];
+	uint8_t candidate[16];
+	uint32_t bits {0};
+
+	if (mode == FAST)
+	{
+		boundingBoxEndpoints(block, e0, e1);
+	}
+	else
+	{
+		principalAxisEndpoints(block, e0, e1);
+	}
+
+	uint16_t c0 {toRgb565(e0)};
+	uint16_t c1 {toRgb565(e1)};
+
+	makePalette(c0, c1, palette);
+
+	float error {selectIndices(block, palette, indices)};
+
+	for (int k {0}; mode == QUALITY && k < 2
+		&& refineEndpoints(block, indices, e0, e1); ++k)
+	{
+		uint16_t r0 {toRgb565(e0)};
+		uint16_t r1 {toRgb565(e1)};
+
+		makePalette(r0, r1, palette);
+
+		float refined {selectIndices(block, palette, candidate)};
+
+		if (refined >= error)
+		{
+			break ;
+		}
+		error = refined;
+		c0 = r0;
+		c1 = r1;
+		std::memcpy(indices, candidate, sizeof(indices));
+	}
+	if (c0 < c1)
+	{
+		std::swap(c0, c1);
+		for (uint8_t &index : indices)
+		{
+			index ^= 1;
+		}
+	}
+	for (int i {0}; i < 16; ++i)
+	{
+		bits |= static_cast<uint32_t> (c0 == c1 ? 0 : indices[i]) << (2 * i);
+	}
+	out[0] = c0 & 0xff;
+	out[1] = c0 >> 8;
+	out[2] = c1 & 0xff;
+	out[3] = c1 >> 8;
+	for (int i {0}; i < 4; ++i)
+	{
+		out[4 + i] = (bits >> (8 * i)) & 0xff;
+	}
+}
+
+/**
+ * Encodes the 16 RGBA texels of <block> to an 8 bytes BC1 block.
+ */
+void BlockCompressor::encodeBC1(const uint8_t *block, uint8_t *out) const
+{
+	encodeColor(block, out);
+}
+
+/**
+ * Encodes the 16 RGBA texels of <block> to a 16 bytes BC3 block: interpolated
+ * alpha followed by BC1 color.
+ */
+void BlockCompressor::encodeBC3(const uint8_t *block, uint8_t *out) const
+{
+	encodeAlpha(block, out);
+	encodeColor(block, out + 8);
+}
+
+/**
+ * Encodes block rows [<begin>, <end>) of the RGBA level <src> to <dst>.
+ */
+void BlockCompressor::encodeLevel(const uint8_t *src, uint32_t width,
+	uint32_t height, Format format, uint8_t *dst, uint32_t begin,
+	uint32_t end) const
+{
+	uint32_t blocks_x {(width + 3) / 4};
+	size_t size {blockSize(format)};
+	uint8_t block[64];
+
+	for (uint32_t by {begin}; by < end; ++by)
+	{
+		for (uint32_t bx {0}; bx < blocks_x; ++bx)
+		{
+			uint8_t *out {dst + (static_cast<size_t> (by) * blocks_x + bx)
+				* size};
+
+			fetchBlock(src, width, height, bx, by, block);
+			if (format == BC1)
+			{
+				encodeBC1(block, out);
+			}
+			else
+			{
+				encodeBC3(block, out);
+			}
+		}
+	}
+}
+
+/**
+ * Encodes the <levels> RGBA levels stored one after another in <chain> to
+ * <dst>, block rows spread over the pool.
+ */
+void BlockCompressor::encodeChain(const uint8_t *chain, uint32_t width,
+	uint32_t height, uint32_t levels, Format format, uint8_t *dst,
+	ThreadPool &pool) const
+{
+	for (uint32_t i {0}; i < levels; ++i)
+	{
+		pool.parallelFor((height + 3) / 4,
+			[this, chain, width, height, format, dst](size_t begin, size_t end)
+			{
+				encodeLevel(chain, width, height, format, dst,
+					static_cast<uint32_t> (begin), static_cast<uint32_t> (end));
+			});
+		chain += static_cast<size_t> (width) * height * 4;
+		dst += levelSize(format, width, height);
+		width = std::max(width / 2, 1u);
+		height = std::max(height / 2, 1u);
+	}
+}
+
+/**
+ * Size in bytes of a block of <format>.
+ */
+size_t BlockCompressor::blockSize(Format format)
+{
+	return (format == BC1 ? 8 : 16);
+}
+
+/**
+ * Size in bytes of a <width> by <height> level in <format>.
+ */
+size_t BlockCompressor::levelSize(Format format, uint32_t width,
+	uint32_t height)
+{
+	return (static_cast<size_t> ((width + 3) / 4) * ((height + 3) / 4)
+		* blockSize(format));
+}
+
+/**
+ * Size in bytes of the first <levels> levels of the mip chain in <format>.
+ */
+size_t BlockCompressor::chainSize(Format format, uint32_t width,
+	uint32_t height, uint32_t levels)
+{
+	size_t size {0};
+
+	for (uint32_t i {0}; i < levels; ++i)
+	{
+		size += levelSize(format, std::max(width >> i, 1u),
+			std::max(height >> i, 1u));
+	}
+	return (size);
+}
+
+/**
+ * Tells if any of the <count> RGBA <pixels> isn't opaque.
+ */
+bool BlockCompressor::hasAlpha(const uint8_t *pixels, size_t count)
+{
+	for (size_t i {0}; i < count; ++i)
+	{
+		if (pixels[i * 4 + 3] != 255)
+		{
+			return (true);
+		}
+	}
+	return (false);
+}
+
+/**
+ * Encodes the alpha of the 16 RGBA texels of <block> to an 8 bytes BC3 alpha
+ * block, in eight values mode between the extreme alphas.
+ */
+void BlockCompressor::encodeAlpha(const uint8_t *block, uint8_t *out)
+{
+	uint8_t hi {0};
+	uint8_t lo {255};
+	float palette[8];
+	uint64_t bits {0};
+
+	for (int i {0}; i < 16; ++i)
+	{
+		hi = std::max(hi, block[i * 4 + 3]);
+		lo = std::min(lo, block[i * 4 + 3]);
+	}
+	palette[0] = hi;
+	palette[1] = lo;
+	for (int i {2}; i < 8; ++i)
+	{
+		palette[i] = ((8 - i) * hi + (i - 1) * lo) / 7.0f;
+	}
+	for (int i {0}; i < 16 && hi != lo; ++i)
+	{
+		uint64_t best {0};
+
+		for (uint64_t p {1}; p < 8; ++p)
+		{
+			if (std::fabs(block[i * 4 + 3] - palette[p])
+				< std::fabs(block[i * 4 + 3] - palette[best]))
+			{
+				best = p;
+			}
+		}
+		bits |= best << (3 * i);
+	}
+	out[0] = hi;
+	out[1] = lo;
+	for (int i {0}; i < 6; ++i)
+	{
+		out[2 + i] = (bits >> (8 * i)) & 0xff;
+	}
+}
+
+/**
+ * Rounds the 0-255 float <color> to packed RGB 565.
+ */
+uint16_t BlockCompressor::toRgb565(const float *color)
+{
+	uint16_t r {static_cast<uint16_t> (std::lround(color[0] * 31.0f / 255.0f))};
+	uint16_t g {static_cast<uint16_t> (std::lround(color[1] * 63.0f / 255.0f))};
+	uint16_t b {static_cast<uint16_t> (std::lround(color[2] * 31.0f / 255.0f))};
+
+	return (static_cast<uint16_t> (r << 11 | g << 5 | b));
+}
+
+/**
+ * Expands packed RGB 565 to 0-255 float <color> as decoders do.
+ */
+void BlockCompressor::fromRgb565(uint16_t packed, float *color)
+{
+	uint32_t r {static_cast<uint32_t> (packed >> 11) & 31};
+	uint32_t g {static_cast<uint32_t> (packed >> 5) & 63};
+	uint32_t b {static_cast<uint32_t> (packed) & 31};
+
+	color[0] = static_cast<float> (r << 3 | r >> 2);
+	color[1] = static_cast<float> (g << 2 | g >> 4);
+	color[2] = static_cast<float> (b << 3 | b >> 2);
+}
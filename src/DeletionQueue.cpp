@@ -0,0 +1,72 @@
+#include <DeletionQueue.hpp>
+
+/**
+ * Empty queue.
+ */
+DeletionQueue::DeletionQueue(void) :
+	entries {}
+{
+	// Empty;
+}
+
+/**
+ * Copy constructor, the queued destructions belong to their queue so the copy
+ * starts empty.
+ */
+DeletionQueue::DeletionQueue(const DeletionQueue &cpy) : DeletionQueue()
+{
+	(void)cpy;
+}
+
+/**
+ * Destructor, the queue must have been flushed while the objects exist.
+ */
+DeletionQueue::~DeletionQueue(void) noexcept
+{
+	// Empty;
+}
+
+/**
+ * Copy assignement operator, keeps its own destructions.
+ */
+DeletionQueue &DeletionQueue::operator=(const DeletionQueue &cpy)
+{
+	(void)cpy;
+	return (*this);
+}
+
+/**
+ * Queues <destroy> to run once the timeline reached <value>. Values must not
+ * decrease from one push to the next.
+ */
+void DeletionQueue::push(uint64_t value, std::function<void(void)> destroy)
+{
+	entries.push_back(Entry {value, std::move(destroy)});
+}
+
+/**
+ * Runs, in the order they were queued, the destructions whose value is at
+ * most <completed>. Returns how many ran.
+ */
+size_t DeletionQueue::flush(uint64_t completed)
+{
+	size_t count {0};
+
+	while (!entries.empty() && entries.front().value <= completed)
+	{
+		std::function<void(void)> destroy {std::move(entries.front().destroy)};
+
+		entries.pop_front();
+		destroy();
+		++count;
+	}
+	return (count);
+}
+
+/**
+ * Number of destructions still queued.
+ */
+size_t DeletionQueue::size(void) const
+{
+	return (entries.size());
+}
@@ -0,0 +1,685 @@
+#include <DeviceBenchmark.hpp>
+#include <Shaders.hpp>
+
+/**
+ * Benchmark of no device.
+ */
+DeviceBenchmark::DeviceBenchmark(void) :
+	DeviceBenchmark(VK_NULL_HANDLE, 0, {})
+{
+	// Empty;
+}
+
+/**
+ * Benchmark of <physical_device> on its <queue_family>, with the device
+ * <extensions> the application itself enables.
+ */
+DeviceBenchmark::DeviceBenchmark(VkPhysicalDevice physical_device,
+	uint32_t queue_family, const std::vector<const char *> &extensions) :
+	physical_device {physical_device},
+	queue_family {queue_family},
+	extensions {extensions},
+	device {VK_NULL_HANDLE},
+	queue {VK_NULL_HANDLE},
+	command_pool {VK_NULL_HANDLE},
+	image {VK_NULL_HANDLE},
+	image_memory {VK_NULL_HANDLE},
+	view {VK_NULL_HANDLE},
+	render_pass {VK_NULL_HANDLE},
+	framebuffer {VK_NULL_HANDLE},
+	layout {VK_NULL_HANDLE},
+	pipeline {VK_NULL_HANDLE},
+	vertex_buffer {VK_NULL_HANDLE},
+	vertex_memory {VK_NULL_HANDLE},
+	buffers {VK_NULL_HANDLE, VK_NULL_HANDLE},
+	buffer_memory {VK_NULL_HANDLE, VK_NULL_HANDLE},
+	query_pool {VK_NULL_HANDLE},
+	timestamp_period {0.0},
+	timestamp_mask {0}
+{
+	// Empty;
+}
+
+/**
+ * Copy constructor, only the benchmarked device is copied.
+ */
+DeviceBenchmark::DeviceBenchmark(const DeviceBenchmark &cpy) :
+	DeviceBenchmark(cpy.physical_device, cpy.queue_family, cpy.extensions)
+{
+	// Empty;
+}
+
+/**
+ * Destructor.
+ */
+DeviceBenchmark::~DeviceBenchmark(void) noexcept
+{
+	tearDown();
+}
+
+/**
+ * Copy assignement operator, only the benchmarked device is copied.
+ */
+DeviceBenchmark &DeviceBenchmark::operator=(const DeviceBenchmark &cpy)
+{
+	tearDown();
+	physical_device = cpy.physical_device;
+	queue_family = cpy.queue_family;
+	extensions = cpy.extensions;
+	return (*this);
+}
+
+/**
+ * Allocates device local memory fitting <requirements>.
+ */
+VkDeviceMemory DeviceBenchmark::allocate(
+	const VkMemoryRequirements &requirements)
+{
+	VkPhysicalDeviceMemoryProperties properties {};
+	VkMemoryAllocateInfo alloc_info {};
+	VkDeviceMemory memory {VK_NULL_HANDLE};
+
+	vkGetPhysicalDeviceMemoryProperties(physical_device, &properties);
+	alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	alloc_info.allocationSize = requirements.size;
+	alloc_info.memoryTypeIndex = properties.memoryTypeCount;
+	for (uint32_t i {0}; i < properties.memoryTypeCount; ++i)
+	{
+		if ((requirements.memoryTypeBits & (1 << i))
+			&& (properties.memoryTypes[i].propertyFlags
+				& VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+		{
+			alloc_info.memoryTypeIndex = i;
+			break ;
+		}
+	}
+	if (alloc_info.memoryTypeIndex == properties.memoryTypeCount
+		|| vkAllocateMemory(device, &alloc_info, nullptr, &memory)
+		!= VK_SUCCESS)
+	{
+		throw (Error("DeviceBenchmark::allocate", "failed allocation"));
+	}
+	return (memory);
+}
+
+/**
+ * Creates a buffer of <size> bytes for <usage>, bound to device local
+ * <memory>.
+ */
+VkBuffer DeviceBenchmark::createBuffer(VkDeviceSize size,
+	VkBufferUsageFlags usage, VkDeviceMemory &memory)
+{
+	VkBufferCreateInfo buffer_info {};
+	VkMemoryRequirements requirements {};
+	VkBuffer buffer {VK_NULL_HANDLE};
+
+	buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	buffer_info.size = size;
+	buffer_info.usage = usage;
+	buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	if (vkCreateBuffer(device, &buffer_info, nullptr, &buffer) != VK_SUCCESS)
+	{
+		throw (Error("DeviceBenchmark::createBuffer", "failed creation"));
+	}
+	vkGetBufferMemoryRequirements(device, buffer, &requirements);
+	try
+	{
+		memory = allocate(requirements);
+	}
+	catch (...)
+	{
+		vkDestroyBuffer(device, buffer, nullptr);
+		throw ;
+	}
+	vkBindBufferMemory(device, buffer, memory, 0);
+	return (buffer);
+}
+
+/**
+ * Creates the image drawn to, its view, and the render pass and framebuffer
+ * drawing to it. The render pass keeps the image in the color attachment
+ * layout and has no dependency of its own, the barriers between iterations
+ * are recorded around it.
+ */
+void DeviceBenchmark::createTarget(void)
+{
+	VkImageCreateInfo image_info {};
+	VkMemoryRequirements requirements {};
+	VkImageViewCreateInfo view_info {};
+	VkAttachmentDescription attachment {};
+	VkAttachmentReference reference {0,
+		VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+	VkSubpassDescription subpass {};
+	VkRenderPassCreateInfo pass_info {};
+	VkFramebufferCreateInfo framebuffer_info {};
+
+	image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	image_info.imageType = VK_IMAGE_TYPE_2D;
+	image_info.format = VK_FORMAT_R8G8B8A8_UNORM;
+	image_info.extent = VkExtent3D {DEVICEBENCHMARK_IMAGE_SIZE,
+		DEVICEBENCHMARK_IMAGE_SIZE, 1};
+	image_info.mipLevels = 1;
+	image_info.arrayLayers = 1;
+	image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+	image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+	image_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	if (vkCreateImage(device, &image_info, nullptr, &image) != VK_SUCCESS)
+	{
+		throw (Error("DeviceBenchmark::createTarget", "failed image"));
+	}
+	vkGetImageMemoryRequirements(device, image, &requirements);
+	image_memory = allocate(requirements);
+	vkBindImageMemory(device, image, image_memory, 0);
+	view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	view_info.image = image;
+	view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	view_info.format = image_info.format;
+	view_info.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+	if (vkCreateImageView(device, &view_info, nullptr, &view) != VK_SUCCESS)
+	{
+		throw (Error("DeviceBenchmark::createTarget", "failed view"));
+	}
+	attachment.format = image_info.format;
+	attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	attachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &reference;
+	pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	pass_info.attachmentCount = 1;
+	pass_info.pAttachments = &attachment;
+	pass_info.subpassCount = 1;
+	pass_info.pSubpasses = &subpass;
+	if (vkCreateRenderPass(device, &pass_info, nullptr, &render_pass)
+		!= VK_SUCCESS)
+	{
+		throw (Error("DeviceBenchmark::createTarget", "failed render pass"));
+	}
+	framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebuffer_info.renderPass = render_pass;
+	framebuffer_info.attachmentCount = 1;
+	framebuffer_info.pAttachments = &view;
+	framebuffer_info.width = DEVICEBENCHMARK_IMAGE_SIZE;
+	framebuffer_info.height = DEVICEBENCHMARK_IMAGE_SIZE;
+	framebuffer_info.layers = 1;
+	if (vkCreateFramebuffer(device, &framebuffer_info, nullptr, &framebuffer)
+		!= VK_SUCCESS)
+	{
+		throw (Error("DeviceBenchmark::createTarget", "failed framebuffer"));
+	}
+}
+
+/**
+ * Creates a shader module from the <size> words of SPIR-V at <code>.
+ */
+VkShaderModule DeviceBenchmark::createShaderModule(const uint32_t *code,
+	size_t size)
+{
+	VkShaderModuleCreateInfo create_info {};
+	VkShaderModule module {VK_NULL_HANDLE};
+
+	create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	create_info.codeSize = size * sizeof(uint32_t);
+	create_info.pCode = code;
+	if (vkCreateShaderModule(device, &create_info, nullptr, &module)
+		!= VK_SUCCESS)
+	{
+		throw (Error("DeviceBenchmark::createShaderModule",
+			"failed creation"));
+	}
+	return (module);
+}
+
+/**
+ * Creates the pipeline drawing every test: the vertex shader of the depth
+ * pre-pass, positions only with the transform pushed as constants, and a
+ * fragment shader writing a constant color. Nothing is culled, blended or
+ * depth tested, so the draws only cost vertex shading and color writes.
+ */
+void DeviceBenchmark::createPipeline(void)
+{
+	VkPushConstantRange range {VK_SHADER_STAGE_VERTEX_BIT, 0,
+		DEVICEBENCHMARK_TRANSFORM_SIZE};
+	VkPipelineLayoutCreateInfo layout_info {};
+	VkShaderModule modules[2] {VK_NULL_HANDLE, VK_NULL_HANDLE};
+	VkPipelineShaderStageCreateInfo stages[2] {};
+	VkVertexInputBindingDescription binding {0, 3 * sizeof(float),
+		VK_VERTEX_INPUT_RATE_VERTEX};
+	VkVertexInputAttributeDescription attribute {0, 0,
+		VK_FORMAT_R32G32B32_SFLOAT, 0};
+	VkPipelineVertexInputStateCreateInfo vertex_input {};
+	VkPipelineInputAssemblyStateCreateInfo input_assembly {};
+	VkViewport viewport {0.0f, 0.0f, DEVICEBENCHMARK_IMAGE_SIZE,
+		DEVICEBENCHMARK_IMAGE_SIZE, 0.0f, 1.0f};
+	VkRect2D scissor {{0, 0}, {DEVICEBENCHMARK_IMAGE_SIZE,
+		DEVICEBENCHMARK_IMAGE_SIZE}};
+	VkPipelineViewportStateCreateInfo viewport_state {};
+	VkPipelineRasterizationStateCreateInfo rasterizer {};
+	VkPipelineMultisampleStateCreateInfo multisampling {};
+	VkPipelineColorBlendAttachmentState blend {};
+	VkPipelineColorBlendStateCreateInfo color_blend {};
+	VkGraphicsPipelineCreateInfo pipeline_info {};
+	VkResult status {VK_SUCCESS};
+
+	layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layout_info.pushConstantRangeCount = 1;
+	layout_info.pPushConstantRanges = &range;
+	if (vkCreatePipelineLayout(device, &layout_info, nullptr, &layout)
+		!= VK_SUCCESS)
+	{
+		throw (Error("DeviceBenchmark::createPipeline", "failed layout"));
+	}
+	modules[0] = createShaderModule(SHADER_DEPTH, std::size(SHADER_DEPTH));
+	try
+	{
+		modules[1] = createShaderModule(SHADER_FILL, std::size(SHADER_FILL));
+	}
+	catch (...)
+	{
+		vkDestroyShaderModule(device, modules[0], nullptr);
+		throw ;
+	}
+	for (int i {0}; i < 2; ++i)
+	{
+		stages[i].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		stages[i].stage = i ? VK_SHADER_STAGE_FRAGMENT_BIT
+			: VK_SHADER_STAGE_VERTEX_BIT;
+		stages[i].module = modules[i];
+		stages[i].pName = "main";
+	}
+	vertex_input.sType =
+		VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertex_input.vertexBindingDescriptionCount = 1;
+	vertex_input.pVertexBindingDescriptions = &binding;
+	vertex_input.vertexAttributeDescriptionCount = 1;
+	vertex_input.pVertexAttributeDescriptions = &attribute;
+	input_assembly.sType =
+		VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	viewport_state.sType =
+		VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewport_state.viewportCount = 1;
+	viewport_state.pViewports = &viewport;
+	viewport_state.scissorCount = 1;
+	viewport_state.pScissors = &scissor;
+	rasterizer.sType =
+		VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizer.cullMode = VK_CULL_MODE_NONE;
+	rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	rasterizer.lineWidth = 1.0f;
+	multisampling.sType =
+		VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+	blend.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT
+		| VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	color_blend.sType =
+		VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	color_blend.attachmentCount = 1;
+	color_blend.pAttachments = &blend;
+	pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipeline_info.stageCount = 2;
+	pipeline_info.pStages = stages;
+	pipeline_info.pVertexInputState = &vertex_input;
+	pipeline_info.pInputAssemblyState = &input_assembly;
+	pipeline_info.pViewportState = &viewport_state;
+	pipeline_info.pRasterizationState = &rasterizer;
+	pipeline_info.pMultisampleState = &multisampling;
+	pipeline_info.pColorBlendState = &color_blend;
+	pipeline_info.layout = layout;
+	pipeline_info.renderPass = render_pass;
+	pipeline_info.subpass = 0;
+	pipeline_info.basePipelineIndex = -1;
+	status = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1,
+		&pipeline_info, nullptr, &pipeline);
+	vkDestroyShaderModule(device, modules[0], nullptr);
+	vkDestroyShaderModule(device, modules[1], nullptr);
+	if (status != VK_SUCCESS)
+	{
+		throw (Error("DeviceBenchmark::createPipeline", "failed pipeline"));
+	}
+}
+
+/**
+ * Creates the logical device, its command pool and timestamp query pool, the
+ * drawing target and pipeline, the vertex buffer and the two copied buffers.
+ * The vertex buffer starts with a full screen quad, followed by
+ * DEVICEBENCHMARK_VERTICES vertices at the origin making degenerate
+ * triangles. Returns false, creating nothing, if the queue family can't
+ * write timestamps.
+ */
+bool DeviceBenchmark::setUp(void)
+{
+	float priority {1.0f};
+	VkPhysicalDeviceProperties properties {};
+	uint32_t count {0};
+	VkDeviceQueueCreateInfo queue_info {};
+	VkDeviceCreateInfo device_info {};
+	VkCommandPoolCreateInfo pool_info {};
+	VkQueryPoolCreateInfo query_info {};
+	const float quad[6][3] {{-1.0f, -1.0f, 0.0f}, {1.0f, -1.0f, 0.0f},
+		{1.0f, 1.0f, 0.0f}, {-1.0f, -1.0f, 0.0f}, {1.0f, 1.0f, 0.0f},
+		{-1.0f, 1.0f, 0.0f}};
+
+	vkGetPhysicalDeviceProperties(physical_device, &properties);
+	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &count, nullptr);
+
+	std::vector<VkQueueFamilyProperties> families(count);
+
+	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &count,
+		families.data());
+	if (queue_family >= count || families[queue_family].timestampValidBits == 0
+		|| properties.limits.timestampPeriod == 0.0f)
+	{
+		return (false);
+	}
+	timestamp_period = properties.limits.timestampPeriod;
+	timestamp_mask = families[queue_family].timestampValidBits < 64
+		? (uint64_t {1} << families[queue_family].timestampValidBits) - 1
+		: ~uint64_t {0};
+	queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+	queue_info.queueFamilyIndex = queue_family;
+	queue_info.queueCount = 1;
+	queue_info.pQueuePriorities = &priority;
+	device_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	device_info.queueCreateInfoCount = 1;
+	device_info.pQueueCreateInfos = &queue_info;
+	device_info.enabledExtensionCount =
+		static_cast<uint32_t> (extensions.size());
+	device_info.ppEnabledExtensionNames = extensions.data();
+	if (vkCreateDevice(physical_device, &device_info, nullptr, &device)
+		!= VK_SUCCESS)
+	{
+		throw (Error("DeviceBenchmark::setUp", "failed device creation"));
+	}
+	vkGetDeviceQueue(device, queue_family, 0, &queue);
+	pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	pool_info.queueFamilyIndex = queue_family;
+	if (vkCreateCommandPool(device, &pool_info, nullptr, &command_pool)
+		!= VK_SUCCESS)
+	{
+		throw (Error("DeviceBenchmark::setUp", "failed pool creation"));
+	}
+	query_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	query_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	query_info.queryCount = 2;
+	if (vkCreateQueryPool(device, &query_info, nullptr, &query_pool)
+		!= VK_SUCCESS)
+	{
+		throw (Error("DeviceBenchmark::setUp", "failed query pool creation"));
+	}
+	createTarget();
+	createPipeline();
+	vertex_buffer = createBuffer(sizeof(quad) + DEVICEBENCHMARK_VERTICES
+		* sizeof(quad[0]), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
+		| VK_BUFFER_USAGE_TRANSFER_DST_BIT, vertex_memory);
+	for (int i {0}; i < 2; ++i)
+	{
+		buffers[i] = createBuffer(DEVICEBENCHMARK_BUFFER_SIZE,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+			| VK_BUFFER_USAGE_TRANSFER_DST_BIT, buffer_memory[i]);
+	}
+	submit([&](VkCommandBuffer buf)
+	{
+		VkImageMemoryBarrier layout_barrier {};
+
+		vkCmdFillBuffer(buf, vertex_buffer, 0, VK_WHOLE_SIZE, 0);
+		barrier(buf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_ACCESS_TRANSFER_WRITE_BIT);
+		vkCmdUpdateBuffer(buf, vertex_buffer, 0, sizeof(quad), quad);
+		barrier(buf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+			VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+		layout_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		layout_barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		layout_barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		layout_barrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		layout_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		layout_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		layout_barrier.image = image;
+		layout_barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0,
+			1};
+		vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, 0, nullptr, 0,
+			nullptr, 1, &layout_barrier);
+	});
+	return (true);
+}
+
+/**
+ * Destroys everything setUp() created.
+ */
+void DeviceBenchmark::tearDown(void) noexcept
+{
+	if (device == VK_NULL_HANDLE)
+	{
+		return ;
+	}
+	vkDeviceWaitIdle(device);
+	for (int i {0}; i < 2; ++i)
+	{
+		vkDestroyBuffer(device, buffers[i], nullptr);
+		vkFreeMemory(device, buffer_memory[i], nullptr);
+		buffers[i] = VK_NULL_HANDLE;
+		buffer_memory[i] = VK_NULL_HANDLE;
+	}
+	vkDestroyBuffer(device, vertex_buffer, nullptr);
+	vkFreeMemory(device, vertex_memory, nullptr);
+	vkDestroyPipeline(device, pipeline, nullptr);
+	vkDestroyPipelineLayout(device, layout, nullptr);
+	vkDestroyFramebuffer(device, framebuffer, nullptr);
+	vkDestroyRenderPass(device, render_pass, nullptr);
+	vkDestroyImageView(device, view, nullptr);
+	vkDestroyImage(device, image, nullptr);
+	vkFreeMemory(device, image_memory, nullptr);
+	vkDestroyQueryPool(device, query_pool, nullptr);
+	vkDestroyCommandPool(device, command_pool, nullptr);
+	vkDestroyDevice(device, nullptr);
+	vertex_buffer = VK_NULL_HANDLE;
+	vertex_memory = VK_NULL_HANDLE;
+	pipeline = VK_NULL_HANDLE;
+	layout = VK_NULL_HANDLE;
+	framebuffer = VK_NULL_HANDLE;
+	render_pass = VK_NULL_HANDLE;
+	view = VK_NULL_HANDLE;
+	image = VK_NULL_HANDLE;
+	image_memory = VK_NULL_HANDLE;
+	query_pool = VK_NULL_HANDLE;
+	command_pool = VK_NULL_HANDLE;
+	queue = VK_NULL_HANDLE;
+	device = VK_NULL_HANDLE;
+}
+
+/**
+ * Records a barrier making the <src_access> of <src_stage> available to the
+ * <dst_access> of <dst_stage>.
+ */
+void DeviceBenchmark::barrier(VkCommandBuffer buf,
+	VkPipelineStageFlags src_stage, VkAccessFlags src_access,
+	VkPipelineStageFlags dst_stage, VkAccessFlags dst_access)
+{
+	VkMemoryBarrier memory_barrier {};
+
+	memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	memory_barrier.srcAccessMask = src_access;
+	memory_barrier.dstAccessMask = dst_access;
+	vkCmdPipelineBarrier(buf, src_stage, dst_stage, 0, 1, &memory_barrier, 0,
+		nullptr, 0, nullptr);
+}
+
+/**
+ * Submits the commands recorded by <record> and waits for the queue to
+ * execute them.
+ */
+void DeviceBenchmark::submit(
+	const std::function<void(VkCommandBuffer)> &record)
+{
+	VkCommandBufferAllocateInfo alloc_info {};
+	VkCommandBufferBeginInfo begin_info {};
+	VkSubmitInfo submit_info {};
+	VkCommandBuffer buf {VK_NULL_HANDLE};
+
+	alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	alloc_info.commandPool = command_pool;
+	alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	alloc_info.commandBufferCount = 1;
+	if (vkAllocateCommandBuffers(device, &alloc_info, &buf) != VK_SUCCESS)
+	{
+		throw (Error("DeviceBenchmark::submit", "failed allocation"));
+	}
+	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(buf, &begin_info);
+	record(buf);
+	vkEndCommandBuffer(buf);
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers = &buf;
+	if (vkQueueSubmit(queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS)
+	{
+		vkFreeCommandBuffers(device, command_pool, 1, &buf);
+		throw (Error("DeviceBenchmark::submit", "failed submission"));
+	}
+	vkQueueWaitIdle(queue);
+	vkFreeCommandBuffers(device, command_pool, 1, &buf);
+}
+
+/**
+ * Returns how long the queue took to execute the commands recorded by
+ * <record>, in seconds, from timestamps written before and after them.
+ */
+double DeviceBenchmark::time(
+	const std::function<void(VkCommandBuffer)> &record)
+{
+	uint64_t stamps[2] {0, 0};
+
+	submit([&](VkCommandBuffer buf)
+	{
+		vkCmdResetQueryPool(buf, query_pool, 0, 2);
+		vkCmdWriteTimestamp(buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			query_pool, 0);
+		record(buf);
+		vkCmdWriteTimestamp(buf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			query_pool, 1);
+	});
+	if (vkGetQueryPoolResults(device, query_pool, 0, 2, sizeof(stamps),
+		stamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT
+		| VK_QUERY_RESULT_WAIT_BIT) != VK_SUCCESS)
+	{
+		throw (Error("DeviceBenchmark::time", "failed query results"));
+	}
+	return (static_cast<double> ((stamps[1] - stamps[0]) & timestamp_mask)
+		* timestamp_period / 1e9);
+}
+
+/**
+ * Records DEVICEBENCHMARK_PASSES render passes each drawing <count> vertices
+ * of the vertex buffer from <first>, every pass waiting for the color writes
+ * of the previous one.
+ */
+void DeviceBenchmark::draw(VkCommandBuffer buf, uint32_t count,
+	uint32_t first)
+{
+	const float transform[DEVICEBENCHMARK_TRANSFORM_SIZE / sizeof(float)] {
+		1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f,
+		1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+	VkRenderPassBeginInfo begin_info {};
+	VkDeviceSize offset {0};
+
+	begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	begin_info.renderPass = render_pass;
+	begin_info.framebuffer = framebuffer;
+	begin_info.renderArea = {{0, 0}, {DEVICEBENCHMARK_IMAGE_SIZE,
+		DEVICEBENCHMARK_IMAGE_SIZE}};
+	for (int i {0}; i < DEVICEBENCHMARK_PASSES; ++i)
+	{
+		barrier(buf, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+		vkCmdBeginRenderPass(buf, &begin_info, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		vkCmdBindVertexBuffers(buf, 0, 1, &vertex_buffer, &offset);
+		vkCmdPushConstants(buf, layout, VK_SHADER_STAGE_VERTEX_BIT, 0,
+			sizeof(transform), transform);
+		vkCmdDraw(buf, count, 1, first, 0);
+		vkCmdEndRenderPass(buf);
+	}
+}
+
+/**
+ * Runs the benchmark: fill rate in gigapixels per second, vertex throughput
+ * in gigavertices per second and bandwidth in gigabytes read and written per
+ * second. Each test runs once untimed first so that lazy allocations and
+ * clock ramp up don't count. A device whose queue can't write timestamps
+ * gets an empty result.
+ */
+DeviceBenchmark::Result DeviceBenchmark::run(void)
+{
+	VkBufferCopy region {0, 0, DEVICEBENCHMARK_BUFFER_SIZE};
+	auto fill {[&](VkCommandBuffer buf)
+	{
+		draw(buf, 6, 0);
+	}};
+	auto vertices {[&](VkCommandBuffer buf)
+	{
+		draw(buf, DEVICEBENCHMARK_VERTICES, 6);
+	}};
+	auto copy {[&](VkCommandBuffer buf)
+	{
+		for (int i {0}; i < DEVICEBENCHMARK_PASSES; ++i)
+		{
+			barrier(buf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
+			vkCmdCopyBuffer(buf, buffers[i % 2], buffers[1 - i % 2], 1,
+				&region);
+		}
+	}};
+	Result result {0.0, 0.0, 0.0};
+
+	try
+	{
+		if (!setUp())
+		{
+			return (result);
+		}
+		time(fill);
+		result.fill_rate = static_cast<double> (DEVICEBENCHMARK_PASSES)
+			* DEVICEBENCHMARK_IMAGE_SIZE * DEVICEBENCHMARK_IMAGE_SIZE
+			/ time(fill) / 1e9;
+		time(vertices);
+		result.vertex_rate = static_cast<double> (DEVICEBENCHMARK_PASSES)
+			* DEVICEBENCHMARK_VERTICES / time(vertices) / 1e9;
+		time(copy);
+		result.bandwidth = 2.0 * DEVICEBENCHMARK_PASSES
+			* DEVICEBENCHMARK_BUFFER_SIZE / time(copy) / 1e9;
+	}
+	catch (...)
+	{
+		tearDown();
+		throw ;
+	}
+	tearDown();
+	return (result);
+}
+
+/**
+ * Single figure ranking benchmark results: geometric mean of fill rate,
+ * vertex throughput and bandwidth, so that none dominates.
+ */
+double DeviceBenchmark::score(const Result &result)
+{
+	return (std::cbrt(result.fill_rate * result.vertex_rate
+		* result.bandwidth));
+}
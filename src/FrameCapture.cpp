@@ -0,0 +1,376 @@
+#include <FrameCapture.hpp>
+
+/**
+ * Capture of no device, capturing nothing.
+ */
+FrameCapture::FrameCapture(void) :
+	device {VK_NULL_HANDLE},
+	allocator {nullptr},
+	memory_budget {nullptr},
+	pool {nullptr},
+	prefix {},
+	shot {false},
+	shots {0},
+	captured {0},
+	dropped {0},
+	failed {0},
+	slots {}
+{
+	for (size_t i {0}; i < FRAMECAPTURE_SLOTS; ++i)
+	{
+		slots.push_back(std::make_unique<Slot>());
+	}
+}
+
+/**
+ * Capture creating its buffers on <device> with <allocator> from
+ * <memory_budget>, and writing the files on <pool>. Every frame is captured
+ * to <prefix> followed by its number if <prefix> isn't empty, only requested
+ * screenshots otherwise.
+ */
+FrameCapture::FrameCapture(VkDevice device,
+	const VkAllocationCallbacks *allocator, MemoryBudget *memory_budget,
+	ThreadPool &pool, const std::string &prefix) : FrameCapture()
+{
+	this->device = device;
+	this->allocator = allocator;
+	this->memory_budget = memory_budget;
+	this->pool = &pool;
+	this->prefix = prefix;
+}
+
+/**
+ * Copy constructor, only the settings are copied since the buffers belong to
+ * their capture.
+ */
+FrameCapture::FrameCapture(const FrameCapture &cpy) : FrameCapture()
+{
+	device = cpy.device;
+	allocator = cpy.allocator;
+	memory_budget = cpy.memory_budget;
+	pool = cpy.pool;
+	prefix = cpy.prefix;
+}
+
+/**
+ * Destructor, the buffers must have been released while the device exists.
+ */
+FrameCapture::~FrameCapture(void) noexcept
+{
+	// Empty;
+}
+
+/**
+ * Copy assignement operator, only the settings are copied. The buffers must
+ * have been released.
+ */
+FrameCapture &FrameCapture::operator=(const FrameCapture &cpy)
+{
+	for (const std::unique_ptr<Slot> &slot : slots)
+	{
+		if (slot->buffer != VK_NULL_HANDLE)
+		{
+			throw (Error("FrameCapture::operator=", "buffers not released"));
+		}
+	}
+	device = cpy.device;
+	allocator = cpy.allocator;
+	memory_budget = cpy.memory_budget;
+	pool = cpy.pool;
+	prefix = cpy.prefix;
+	shot = false;
+	shots = 0;
+	captured = 0;
+	dropped = 0;
+	failed = 0;
+	return (*this);
+}
+
+/**
+ * Tells if every frame is captured.
+ */
+bool FrameCapture::isRecording(void) const
+{
+	return (!prefix.empty());
+}
+
+/**
+ * Tells if a screenshot was requested and not taken yet.
+ */
+bool FrameCapture::isShotPending(void) const
+{
+	return (shot);
+}
+
+/**
+ * Captures the next recorded frame as a screenshot.
+ */
+void FrameCapture::requestShot(void)
+{
+	shot = true;
+}
+
+/**
+ * Gives the free buffers room for images of <extent> when every frame is
+ * captured, so that the first copies don't allocate while recording.
+ */
+void FrameCapture::reserve(VkExtent2D extent)
+{
+	if (!isRecording())
+	{
+		return ;
+	}
+	for (const std::unique_ptr<Slot> &slot : slots)
+	{
+		if (slot->state.load(std::memory_order_acquire) == FREE)
+		{
+			reserve(*slot, static_cast<VkDeviceSize> (extent.width)
+				* extent.height * 4);
+		}
+	}
+}
+
+/**
+ * Makes the buffer of the free <slot> hold at least <size> bytes, mapped for
+ * good. Host cached memory is preferred since the host reads it back.
+ */
+void FrameCapture::reserve(Slot &slot, VkDeviceSize size)
+{
+	VkBufferCreateInfo create_info {};
+	VkMemoryRequirements requirements {};
+	VkMemoryPropertyFlags properties {VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+		| VK_MEMORY_PROPERTY_HOST_CACHED_BIT};
+	void *data {nullptr};
+
+	if (slot.size >= size)
+	{
+		return ;
+	}
+	destroy(slot);
+	create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	create_info.size = size;
+	create_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	if (vkCreateBuffer(device, &create_info, allocator, &slot.buffer)
+		!= VK_SUCCESS)
+	{
+		throw (Error("FrameCapture::reserve", "failed to create buffer"));
+	}
+	vkGetBufferMemoryRequirements(device, slot.buffer, &requirements);
+	if (!memory_budget->supports(requirements.memoryTypeBits, properties))
+	{
+		properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+			| VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	}
+	if (memory_budget->allocate(requirements, properties, slot.memory)
+		!= VK_SUCCESS)
+	{
+		throw (Error("FrameCapture::reserve", "failed to allocate memory"));
+	}
+	vkBindBufferMemory(device, slot.buffer, slot.memory, 0);
+	if (vkMapMemory(device, slot.memory, 0, VK_WHOLE_SIZE, 0, &data)
+		!= VK_SUCCESS)
+	{
+		throw (Error("FrameCapture::reserve", "failed to map memory"));
+	}
+	slot.data = static_cast<const uint8_t *> (data);
+	slot.size = size;
+}
+
+/**
+ * Destroys the buffer of <slot>, which the GPU and the pool must be done with.
+ */
+void FrameCapture::destroy(Slot &slot)
+{
+	if (slot.buffer != VK_NULL_HANDLE)
+	{
+		vkDestroyBuffer(device, slot.buffer, allocator);
+	}
+	if (slot.memory != VK_NULL_HANDLE)
+	{
+		vkUnmapMemory(device, slot.memory);
+		memory_budget->free(slot.memory);
+	}
+	slot.buffer = VK_NULL_HANDLE;
+	slot.memory = VK_NULL_HANDLE;
+	slot.data = nullptr;
+	slot.size = 0;
+}
+
+/**
+ * Name of the file of a captured frame: <prefix> and the frame number when
+ * every frame is captured, a screenshot number otherwise.
+ */
+std::string FrameCapture::getPath(uint64_t frame)
+{
+	std::ostringstream path {};
+
+	if (isRecording())
+	{
+		path << prefix << std::setw(FRAMECAPTURE_DIGITS) << std::setfill('0')
+			<< frame;
+	}
+	else
+	{
+		path << FRAMECAPTURE_SHOT_PREFIX << std::setw(FRAMECAPTURE_DIGITS)
+			<< std::setfill('0') << shots++;
+	}
+	path << ".ppm";
+	return (path.str());
+}
+
+/**
+ * Records into <buf> the copy of <image> of <extent> and <format>, in the
+ * transfer source layout, to a free buffer, made visible to the host once the
+ * timeline reaches <value>. Does nothing if the frame isn't to be captured,
+ * and drops it if no buffer is free.
+ */
+void FrameCapture::record(VkCommandBuffer buf, VkImage image,
+	VkExtent2D extent, VkFormat format, uint64_t value, uint64_t frame)
+{
+	Slot *slot {nullptr};
+	VkBufferImageCopy region {};
+	VkBufferMemoryBarrier barrier {};
+
+	if ((!shot && !isRecording()) || !supports(format))
+	{
+		return ;
+	}
+	for (const std::unique_ptr<Slot> &candidate : slots)
+	{
+		if (candidate->state.load(std::memory_order_acquire) == FREE)
+		{
+			slot = candidate.get();
+			break ;
+		}
+	}
+	if (slot == nullptr)
+	{
+		++dropped;
+		return ;
+	}
+	reserve(*slot, static_cast<VkDeviceSize> (extent.width) * extent.height
+		* 4);
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.layerCount = 1;
+	region.imageExtent = VkExtent3D {extent.width, extent.height, 1};
+	vkCmdCopyImageToBuffer(buf, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		slot->buffer, 1, &region);
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer = slot->buffer;
+	barrier.size = VK_WHOLE_SIZE;
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+	slot->width = extent.width;
+	slot->height = extent.height;
+	slot->swizzle = format == VK_FORMAT_B8G8R8A8_UNORM
+		|| format == VK_FORMAT_B8G8R8A8_SRGB;
+	slot->value = value;
+	slot->path = getPath(frame);
+	slot->state.store(PENDING, std::memory_order_release);
+	shot = false;
+	++captured;
+}
+
+/**
+ * Hands the copies done once the timeline reached <completed> to the pool,
+ * which writes them and frees their buffers.
+ */
+void FrameCapture::collect(uint64_t completed)
+{
+	for (const std::unique_ptr<Slot> &slot : slots)
+	{
+		if (slot->state.load(std::memory_order_acquire) != PENDING
+			|| slot->value > completed)
+		{
+			continue ;
+		}
+		slot->state.store(WRITING, std::memory_order_relaxed);
+		slot->job = pool->submit([this, slot = slot.get()](void)
+			{
+				write(*slot);
+			});
+	}
+}
+
+/**
+ * Writes the image read back into <slot> as a binary PPM, then frees the
+ * slot. Runs on the pool, a file that can't be written is counted.
+ */
+void FrameCapture::write(Slot &slot)
+{
+	VkMappedMemoryRange range {};
+	std::vector<char> row(static_cast<size_t> (slot.width) * 3);
+	size_t red {slot.swizzle ? 2u : 0u};
+	std::ofstream out {slot.path, std::ios::binary};
+
+	range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+	range.memory = slot.memory;
+	range.size = VK_WHOLE_SIZE;
+	vkInvalidateMappedMemoryRanges(device, 1, &range);
+	out << "P6\n" << slot.width << ' ' << slot.height << "\n255\n";
+	for (size_t y {0}; y < slot.height; ++y)
+	{
+		const uint8_t *pixel {slot.data + y * slot.width * 4};
+
+		for (size_t x {0}; x < slot.width; ++x, pixel += 4)
+		{
+			row[3 * x] = static_cast<char> (pixel[red]);
+			row[3 * x + 1] = static_cast<char> (pixel[1]);
+			row[3 * x + 2] = static_cast<char> (pixel[2 - red]);
+		}
+		out.write(row.data(), static_cast<std::streamsize> (row.size()));
+	}
+	if (!out)
+	{
+		failed.fetch_add(1, std::memory_order_relaxed);
+	}
+	slot.state.store(FREE, std::memory_order_release);
+}
+
+/**
+ * Writes the copies not written yet, waits for the pool to be done, and
+ * destroys the buffers. The device must be idle.
+ */
+void FrameCapture::release(void)
+{
+	collect(UINT64_MAX);
+	for (const std::unique_ptr<Slot> &slot : slots)
+	{
+		if (slot->job.valid())
+		{
+			slot->job.wait();
+		}
+		destroy(*slot);
+	}
+}
+
+/**
+ * Writes how many frames were captured, dropped and not written. Writes
+ * nothing if no frame was to be captured.
+ */
+void FrameCapture::writeReport(std::ostream &out) const
+{
+	if (!captured && !dropped)
+	{
+		return ;
+	}
+	out << "capture " << captured << " frames, " << dropped << " dropped, "
+		<< failed.load(std::memory_order_relaxed) << " not written"
+		<< std::endl;
+}
+
+/**
+ * Tells if images of <format> can be captured: 8 bits RGBA or BGRA.
+ */
+bool FrameCapture::supports(VkFormat format)
+{
+	return (format == VK_FORMAT_B8G8R8A8_UNORM
+		|| format == VK_FORMAT_B8G8R8A8_SRGB
+		|| format == VK_FORMAT_R8G8B8A8_UNORM
+		|| format == VK_FORMAT_R8G8B8A8_SRGB);
+}
@@ -0,0 +1,207 @@
+#include <FramePacer.hpp>
+
+/**
+ * Default constructor, no frame limit and a single frame slot.
+ */
+FramePacer::FramePacer(void) : FramePacer(0.0, 1)
+{
+	// Empty;
+}
+
+/**
+ * Paces frames at <fps> frames per second, 0 disables the limiter but keeps
+ * measuring. One slot is tracked per frame in flight.
+ */
+FramePacer::FramePacer(double fps, size_t frames_in_flight) :
+	period {Clock::duration::zero()},
+	deadline {Clock::now()},
+	last_report {Clock::now()},
+	slots(frames_in_flight, Slot {}),
+	cpu_ms {0.0},
+	gpu_ms {0.0},
+	latency(PACER_HISTORY, 0.0),
+	latency_count {0}
+{
+	if (fps > 0.0)
+	{
+		period = std::chrono::duration_cast<Clock::duration>(
+			std::chrono::duration<double>(1.0 / fps));
+	}
+}
+
+/**
+ * Copy constructor.
+ */
+FramePacer::FramePacer(const FramePacer &cpy) :
+	period {cpy.period},
+	deadline {cpy.deadline},
+	last_report {cpy.last_report},
+	slots {cpy.slots},
+	cpu_ms {cpy.cpu_ms},
+	gpu_ms {cpy.gpu_ms},
+	latency {cpy.latency},
+	latency_count {cpy.latency_count}
+{
+	// Empty;
+}
+
+/**
+ * Destructor.
+ */
+FramePacer::~FramePacer(void) noexcept
+{
+	// Empty;
+}
+
+/**
+ * Copy assignement operator.
+ */
+FramePacer &FramePacer::operator=(const FramePacer &cpy)
+{
+	period = cpy.period;
+	deadline = cpy.deadline;
+	last_report = cpy.last_report;
+	slots = cpy.slots;
+	cpu_ms = cpy.cpu_ms;
+	gpu_ms = cpy.gpu_ms;
+	latency = cpy.latency;
+	latency_count = cpy.latency_count;
+	return (*this);
+}
+
+/**
+ * Predicted time in milliseconds between sampling input and the end of the
+ * frame on the GPU, with a safety margin.
+ */
+double FramePacer::predictedWork(void) const
+{
+	double work {cpu_ms + gpu_ms};
+
+	return (work + work * PACER_SMOOTHING + PACER_MARGIN_MS);
+}
+
+/**
+ * Sleeps until the latest moment the next frame can start and still be done
+ * by its deadline. Deadlines are spaced by the target period; if the loop fell
+ * behind (stall, idle on-demand mode) the schedule restarts from now. The last
+ * PACER_SPIN_MS are spent yielding since sleeps overshoot.
+ */
+void FramePacer::wait(void)
+{
+	if (period == Clock::duration::zero())
+	{
+		return ;
+	}
+
+	Clock::time_point now {Clock::now()};
+	auto work {std::chrono::duration_cast<Clock::duration>(
+		std::chrono::duration<double, std::milli>(predictedWork()))};
+	auto spin {std::chrono::duration_cast<Clock::duration>(
+		std::chrono::duration<double, std::milli>(PACER_SPIN_MS))};
+
+	deadline += period;
+	if (deadline < now + work - period)
+	{
+		deadline = now + work;
+	}
+
+	Clock::time_point start {deadline - work};
+
+	if (start - spin > now)
+	{
+		std::this_thread::sleep_until(start - spin);
+	}
+	while (Clock::now() < start)
+	{
+		std::this_thread::yield();
+	}
+}
+
+/**
+ * Records the moment the input used by the frame of <slot> was sampled.
+ */
+void FramePacer::markInput(size_t slot)
+{
+	slots[slot].input = Clock::now();
+}
+
+/**
+ * Records the submission of the frame of <slot> and updates the CPU cost
+ * estimate (input sampling to submission).
+ */
+void FramePacer::markSubmit(size_t slot)
+{
+	Slot &s {slots[slot]};
+
+	s.submit = Clock::now();
+	s.pending = true;
+	cpu_ms += (milliseconds(s.submit - s.input) - cpu_ms) * PACER_SMOOTHING;
+}
+
+/**
+ * Called once the fence of <slot> signaled. <gpu_time> is the measured GPU
+ * duration of the frame in milliseconds, negative if unknown. If <observed>,
+ * the caller actually blocked on the fence so now is its completion time;
+ * otherwise completion is estimated as submission plus GPU time. The present
+ * request is queued right behind the frame, so this is reported as the
+ * input-to-present latency.
+ */
+void FramePacer::markComplete(size_t slot, bool observed, double gpu_time)
+{
+	Slot &s {slots[slot]};
+
+	if (!s.pending)
+	{
+		return ;
+	}
+	s.pending = false;
+	if (gpu_time >= 0.0)
+	{
+		gpu_ms += (gpu_time - gpu_ms) * PACER_SMOOTHING;
+	}
+
+	double lat {milliseconds(s.submit - s.input) + std::max(gpu_time, 0.0)};
+
+	if (observed)
+	{
+		lat = std::max(lat, milliseconds(Clock::now() - s.input));
+	}
+	latency[latency_count % latency.size()] = lat;
+	++latency_count;
+}
+
+/**
+ * Prints the latency statistics of the recent frames to <out>, at most once
+ * per second.
+ */
+void FramePacer::report(std::ostream &out)
+{
+	Clock::time_point now {Clock::now()};
+
+	if (now - last_report < std::chrono::seconds(1) || latency_count == 0)
+	{
+		return ;
+	}
+	last_report = now;
+
+	std::vector<double> sorted(latency.begin(), latency.begin()
+		+ std::min(latency_count, latency.size()));
+	double sum {0.0};
+
+	std::sort(sorted.begin(), sorted.end());
+	for (double l : sorted)
+	{
+		sum += l;
+	}
+	out << "latency avg " << sum / sorted.size() << " ms";
+	out << ", p99 " << sorted[(sorted.size() - 1) * 99 / 100] << " ms";
+	out << " | cpu " << cpu_ms << " ms, gpu " << gpu_ms << " ms" << std::endl;
+}
+
+/**
+ * Converts a clock duration to milliseconds.
+ */
+double FramePacer::milliseconds(Clock::duration duration)
+{
+	return (std::chrono::duration<double, std::milli>(duration).count());
+}
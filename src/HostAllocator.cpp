@@ -0,0 +1,332 @@
+#include <HostAllocator.hpp>
+
+/**
+ * Empty allocator, its callbacks hand this instance to the driver.
+ */
+HostAllocator::HostAllocator(void) :
+	callbacks {
+		.pUserData = this,
+		.pfnAllocation = &HostAllocator::allocation,
+		.pfnReallocation = &HostAllocator::reallocation,
+		.pfnFree = &HostAllocator::release,
+		.pfnInternalAllocation = &HostAllocator::internalAllocation,
+		.pfnInternalFree = &HostAllocator::internalFree
+	},
+	mutex {},
+	free_lists {},
+	chunks {},
+	usage {}
+{
+	// Empty;
+}
+
+/**
+ * Copy constructor, memory belongs to the allocator that handed it out so
+ * the copy starts empty.
+ */
+HostAllocator::HostAllocator(const HostAllocator &cpy) : HostAllocator()
+{
+	(void)cpy;
+}
+
+/**
+ * Destructor, releases every chunk. Everything allocated through the
+ * callbacks must have been freed.
+ */
+HostAllocator::~HostAllocator(void) noexcept
+{
+	for (void *chunk : chunks)
+	{
+		::operator delete(chunk, std::align_val_t(HOSTALLOCATOR_MAX_CLASS));
+	}
+}
+
+/**
+ * Copy assignement operator, keeps its own memory.
+ */
+HostAllocator &HostAllocator::operator=(const HostAllocator &cpy)
+{
+	(void)cpy;
+	return (*this);
+}
+
+/**
+ * Callbacks to pass to every Vulkan call of the objects using this allocator.
+ */
+const VkAllocationCallbacks *HostAllocator::getCallbacks(void) const
+{
+	return (&callbacks);
+}
+
+/**
+ * Index of <scope> in the tables, unknown scopes count as object ones.
+ */
+uint32_t HostAllocator::scopeIndex(VkSystemAllocationScope scope)
+{
+	uint32_t index {static_cast<uint32_t> (scope)};
+
+	return (index < HOSTALLOCATOR_SCOPES ? index
+		: static_cast<uint32_t> (VK_SYSTEM_ALLOCATION_SCOPE_OBJECT));
+}
+
+/**
+ * Pops a block of <size_class> from the arena of <scope>, carving a new chunk
+ * into blocks if the free list is empty. Returns null if out of memory. Called
+ * with the lock held.
+ */
+uint8_t *HostAllocator::take(uint32_t scope, uint16_t size_class)
+{
+	void *&head {free_lists[scope][size_class]};
+
+	if (!head)
+	{
+		size_t block_size {static_cast<size_t> (HOSTALLOCATOR_MIN_CLASS)
+			<< size_class};
+		uint8_t *chunk {static_cast<uint8_t *> (::operator new(
+			HOSTALLOCATOR_CHUNK, std::align_val_t(HOSTALLOCATOR_MAX_CLASS),
+			std::nothrow))};
+
+		if (!chunk)
+		{
+			return (nullptr);
+		}
+		chunks.push_back(chunk);
+		for (size_t i {HOSTALLOCATOR_CHUNK}; i >= block_size; i -= block_size)
+		{
+			void *block {chunk + i - block_size};
+
+			*static_cast<void **> (block) = head;
+			head = block;
+		}
+	}
+
+	uint8_t *block {static_cast<uint8_t *> (head)};
+
+	head = *static_cast<void **> (head);
+	return (block);
+}
+
+/**
+ * Returns <size> bytes aligned on <alignment> accounted to <scope>, or null if
+ * out of memory. The block header sits right before the returned address.
+ * Blocks past the largest size class are allocated on their own.
+ */
+void *HostAllocator::allocate(size_t size, size_t alignment,
+	VkSystemAllocationScope scope)
+{
+	size_t offset {std::max(alignment, sizeof(Header))};
+	size_t needed {size + offset};
+	uint32_t index {scopeIndex(scope)};
+	uint16_t size_class {HOSTALLOCATOR_LARGE};
+	uint8_t *block {nullptr};
+
+	if (offset > UINT16_MAX)
+	{
+		return (nullptr);
+	}
+
+	std::lock_guard<std::mutex> lock {mutex};
+
+	if (needed <= HOSTALLOCATOR_MAX_CLASS)
+	{
+		size_class = 0;
+		while ((static_cast<size_t> (HOSTALLOCATOR_MIN_CLASS) << size_class)
+			< needed)
+		{
+			++size_class;
+		}
+		block = take(index, size_class);
+	}
+	else
+	{
+		block = static_cast<uint8_t *> (::operator new(needed,
+			std::align_val_t(offset), std::nothrow));
+	}
+	if (!block)
+	{
+		return (nullptr);
+	}
+	reinterpret_cast<Header *> (block + offset)[-1] = Header {
+		.size = size,
+		.scope = index,
+		.size_class = size_class,
+		.offset = static_cast<uint16_t> (offset)
+	};
+	usage[index].bytes += size;
+	usage[index].peak = std::max(usage[index].peak, usage[index].bytes);
+	++usage[index].live;
+	++usage[index].total;
+	return (block + offset);
+}
+
+/**
+ * Resizes <original> to <size> bytes aligned on <alignment>, in place if its
+ * block is large enough. Follows realloc: a null <original> allocates, a null
+ * <size> frees, and on failure null is returned with <original> untouched.
+ */
+void *HostAllocator::reallocate(void *original, size_t size,
+	size_t alignment, VkSystemAllocationScope scope)
+{
+	if (!original)
+	{
+		return (allocate(size, alignment, scope));
+	}
+	if (size == 0)
+	{
+		free(original);
+		return (nullptr);
+	}
+
+	Header &header {static_cast<Header *> (original)[-1]};
+
+	{
+		std::lock_guard<std::mutex> lock {mutex};
+
+		if (header.size_class != HOSTALLOCATOR_LARGE
+			&& header.offset % alignment == 0
+			&& size + header.offset <= static_cast<size_t> (
+				HOSTALLOCATOR_MIN_CLASS) << header.size_class)
+		{
+			usage[header.scope].bytes += size;
+			usage[header.scope].bytes -= header.size;
+			usage[header.scope].peak = std::max(usage[header.scope].peak,
+				usage[header.scope].bytes);
+			header.size = size;
+			return (original);
+		}
+	}
+
+	void *memory {allocate(size, alignment, scope)};
+
+	if (memory)
+	{
+		std::memcpy(memory, original, std::min<size_t>(size, header.size));
+		free(original);
+	}
+	return (memory);
+}
+
+/**
+ * Gives <memory> back to its size class, or to the system if it was allocated
+ * on its own.
+ */
+void HostAllocator::free(void *memory)
+{
+	if (!memory)
+	{
+		return ;
+	}
+
+	Header header {static_cast<Header *> (memory)[-1]};
+	uint8_t *block {static_cast<uint8_t *> (memory) - header.offset};
+	std::lock_guard<std::mutex> lock {mutex};
+
+	usage[header.scope].bytes -= header.size;
+	--usage[header.scope].live;
+	if (header.size_class == HOSTALLOCATOR_LARGE)
+	{
+		::operator delete(block, std::align_val_t(header.offset));
+		return ;
+	}
+
+	void *&head {free_lists[header.scope][header.size_class]};
+
+	*reinterpret_cast<void **> (block) = head;
+	head = block;
+}
+
+/**
+ * Accounts <size> bytes the driver <allocated> or freed by itself in <scope>.
+ */
+void HostAllocator::notify(size_t size, VkSystemAllocationScope scope,
+	bool allocated)
+{
+	std::lock_guard<std::mutex> lock {mutex};
+	Usage &scope_usage {usage[scopeIndex(scope)]};
+
+	scope_usage.internal = allocated ? scope_usage.internal + size
+		: scope_usage.internal - size;
+}
+
+/**
+ * Usage of <scope> so far.
+ */
+HostAllocator::Usage HostAllocator::getUsage(VkSystemAllocationScope scope)
+{
+	std::lock_guard<std::mutex> lock {mutex};
+
+	return (usage[scopeIndex(scope)]);
+}
+
+/**
+ * Writes the usage of every scope: bytes in use and at peak, live and total
+ * allocations, and bytes the driver allocated by itself.
+ */
+void HostAllocator::writeReport(std::ostream &out)
+{
+	const char *names[HOSTALLOCATOR_SCOPES] {"command", "object", "cache",
+		"device", "instance"};
+	std::lock_guard<std::mutex> lock {mutex};
+
+	out << "host memory:" << std::endl << std::left << std::setw(9) << "scope"
+		<< std::right << std::setw(11) << "bytes" << std::setw(11) << "peak"
+		<< std::setw(10) << "live" << std::setw(10) << "total"
+		<< std::setw(10) << "internal" << std::endl;
+	for (uint32_t i {0}; i < HOSTALLOCATOR_SCOPES; ++i)
+	{
+		out << std::left << std::setw(9) << names[i] << std::right
+			<< std::setw(11) << usage[i].bytes << std::setw(11)
+			<< usage[i].peak << std::setw(10) << usage[i].live
+			<< std::setw(10) << usage[i].total << std::setw(10)
+			<< usage[i].internal << std::endl;
+	}
+}
+
+/**
+ * pfnAllocation of the callbacks.
+ */
+VKAPI_ATTR void *VKAPI_CALL HostAllocator::allocation(void *user, size_t size,
+	size_t alignment, VkSystemAllocationScope scope)
+{
+	return (static_cast<HostAllocator *> (user)->allocate(size, alignment,
+		scope));
+}
+
+/**
+ * pfnReallocation of the callbacks.
+ */
+VKAPI_ATTR void *VKAPI_CALL HostAllocator::reallocation(void *user,
+	void *original, size_t size, size_t alignment,
+	VkSystemAllocationScope scope)
+{
+	return (static_cast<HostAllocator *> (user)->reallocate(original, size,
+		alignment, scope));
+}
+
+/**
+ * pfnFree of the callbacks.
+ */
+VKAPI_ATTR void VKAPI_CALL HostAllocator::release(void *user, void *memory)
+{
+	static_cast<HostAllocator *> (user)->free(memory);
+}
+
+/**
+ * pfnInternalAllocation of the callbacks.
+ */
+VKAPI_ATTR void VKAPI_CALL HostAllocator::internalAllocation(void *user,
+	size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope)
+{
+	(void)type;
+	static_cast<HostAllocator *> (user)->notify(size, scope, true);
+}
+
+/**
+ * pfnInternalFree of the callbacks.
+ */
+VKAPI_ATTR void VKAPI_CALL HostAllocator::internalFree(void *user,
+	size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope)
+{
+	(void)type;
+	static_cast<HostAllocator *> (user)->notify(size, scope, false);
+}
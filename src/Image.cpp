@@ -0,0 +1,595 @@
+#include <Image.hpp>
+
+/**
+ * Lookup tables between 8 bits sRGB and linear intensities.
+ */
+struct GammaTables
+{
+	float to_linear[256];
+	uint8_t to_srgb[IMAGE_SRGB_TABLE_SIZE];
+};
+
+/**
+ * Builds the sRGB transfer function tables.
+ */
+static inline GammaTables buildGammaTables(void)
+{
+	GammaTables tables {};
+
+	for (int i {0}; i < 256; ++i)
+	{
+		float c {static_cast<float> (i) / 255.0f};
+
+		tables.to_linear[i] = c <= 0.04045f
+			? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+	}
+	for (int i {0}; i < IMAGE_SRGB_TABLE_SIZE; ++i)
+	{
+		float l {static_cast<float> (i) / (IMAGE_SRGB_TABLE_SIZE - 1)};
+		float c {l <= 0.0031308f
+			? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f};
+
+		tables.to_srgb[i] = static_cast<uint8_t> (c * 255.0f + 0.5f);
+	}
+	return (tables);
+}
+
+/**
+ * Shared gamma tables, built on first use.
+ */
+static inline const GammaTables &gammaTables(void)
+{
+	static const GammaTables tables {buildGammaTables()};
+
+	return (tables);
+}
+
+/**
+ * Reads the little endian integer of <bytes> bytes at <pos> in <data>.
+ */
+static inline uint32_t readLe(const std::string &data, size_t pos,
+	size_t bytes)
+{
+	uint32_t value {0};
+
+	if (pos + bytes > data.size())
+	{
+		throw (Error("Image::load", "truncated header"));
+	}
+	for (size_t i {0}; i < bytes; ++i)
+	{
+		value |= static_cast<uint32_t> (static_cast<uint8_t> (data[pos + i]))
+			<< (8 * i);
+	}
+	return (value);
+}
+
+/**
+ * Throws from <method> if a side of a <width> by <height> image is larger
+ * than IMAGE_MAX_DIMENSION, which keeps every size computed from them far
+ * from overflowing.
+ */
+static inline void checkDimensions(const char *method, uint64_t width,
+	uint64_t height)
+{
+	if (width > IMAGE_MAX_DIMENSION || height > IMAGE_MAX_DIMENSION)
+	{
+		throw (Error(method, "image too large"));
+	}
+}
+
+/**
+ * Size in bytes of a BMP row of <width> pixels of <channels> bytes, padded to
+ * 4 bytes.
+ */
+static inline uint64_t bmpStride(uint64_t width, uint64_t channels)
+{
+	return ((width * channels + 3) & ~static_cast<uint64_t> (3));
+}
+
+/**
+ * Writes the pixel of <channels> bytes at <src> to <dst> as RGBA. Files store
+ * BGR(A) or grey levels. Without <alpha>, the fourth byte is padding.
+ */
+static inline void writePixel(const uint8_t *src, uint32_t channels,
+	bool alpha, uint8_t *dst)
+{
+	if (channels == 1)
+	{
+		dst[0] = src[0];
+		dst[1] = src[0];
+		dst[2] = src[0];
+		dst[3] = 255;
+		return ;
+	}
+	dst[0] = src[2];
+	dst[1] = src[1];
+	dst[2] = src[0];
+	dst[3] = channels == 4 && alpha ? src[3] : 255;
+}
+
+/**
+ * Empty image.
+ */
+Image::Image(void) :
+	format {BMP},
+	width {0},
+	height {0},
+	offset {0},
+	channels {0},
+	bottom_up {false},
+	rle {false},
+	alpha {false}
+{
+	// Empty;
+}
+
+/**
+ * Reads the image file at <path>.
+ */
+Image::Image(const std::string &path) : Image()
+{
+	load(path);
+}
+
+/**
+ * Copy constructor.
+ */
+Image::Image(const Image &cpy) :
+	data {cpy.data},
+	format {cpy.format},
+	width {cpy.width},
+	height {cpy.height},
+	offset {cpy.offset},
+	channels {cpy.channels},
+	bottom_up {cpy.bottom_up},
+	rle {cpy.rle},
+	alpha {cpy.alpha}
+{
+	// Empty;
+}
+
+/**
+ * Destructor.
+ */
+Image::~Image(void) noexcept
+{
+	// Empty;
+}
+
+/**
+ * Copy assignement operator.
+ */
+Image &Image::operator=(const Image &cpy)
+{
+	data = cpy.data;
+	format = cpy.format;
+	width = cpy.width;
+	height = cpy.height;
+	offset = cpy.offset;
+	channels = cpy.channels;
+	bottom_up = cpy.bottom_up;
+	rle = cpy.rle;
+	alpha = cpy.alpha;
+	return (*this);
+}
+
+/**
+ * Reads the file at <path> and parses its header, the format is told by its
+ * content.
+ */
+void Image::load(const std::string &path)
+{
+	std::ifstream file {path, std::ios::binary | std::ios::ate};
+
+	if (!file.is_open())
+	{
+		throw (Error("Image::load", "failed to open file"));
+	}
+	data.resize(static_cast<size_t> (file.tellg()));
+	file.seekg(0);
+	file.read(data.data(), static_cast<std::streamsize> (data.size()));
+	if (data.size() >= 2 && data[0] == 'B' && data[1] == 'M')
+	{
+		parseBmp();
+	}
+	else if (data.size() >= 2 && data[0] == 'P'
+		&& (data[1] == '6' || data[1] == '5'))
+	{
+		parsePpm();
+	}
+	else
+	{
+		parseTga();
+	}
+	if (width == 0 || height == 0)
+	{
+		throw (Error("Image::load", "empty image"));
+	}
+}
+
+/**
+ * Parses an uncompressed 24 or 32 bits BMP header.
+ */
+void Image::parseBmp(void)
+{
+	int32_t signed_height {static_cast<int32_t> (readLe(data, 22, 4))};
+	uint32_t bpp {readLe(data, 28, 2)};
+	uint32_t compression {readLe(data, 30, 4)};
+
+	if ((bpp != 24 && bpp != 32) || (compression != 0 && compression != 3))
+	{
+		throw (Error("Image::parseBmp", "unsupported BMP"));
+	}
+	format = BMP;
+	offset = readLe(data, 10, 4);
+	width = readLe(data, 18, 4);
+	height = signed_height < 0 ? 0u - static_cast<uint32_t> (signed_height)
+		: static_cast<uint32_t> (signed_height);
+	channels = bpp / 8;
+	bottom_up = signed_height > 0;
+	rle = false;
+	alpha = compression == 3;
+	checkDimensions("Image::parseBmp", width, height);
+	if (static_cast<uint64_t> (offset) + bmpStride(width, channels) * height
+		> data.size())
+	{
+		throw (Error("Image::parseBmp", "truncated pixels"));
+	}
+}
+
+/**
+ * Parses a true color or grey level TGA header, raw or run length encoded.
+ */
+void Image::parseTga(void)
+{
+	uint32_t type {readLe(data, 2, 1)};
+	uint32_t bpp {readLe(data, 16, 1)};
+
+	if (readLe(data, 1, 1) != 0
+		|| ((type == 2 || type == 10) && bpp != 24 && bpp != 32)
+		|| ((type == 3 || type == 11) && bpp != 8)
+		|| (type != 2 && type != 3 && type != 10 && type != 11))
+	{
+		throw (Error("Image::parseTga", "unsupported TGA"));
+	}
+	format = TGA;
+	offset = 18 + readLe(data, 0, 1);
+	width = readLe(data, 12, 2);
+	height = readLe(data, 14, 2);
+	channels = bpp / 8;
+	bottom_up = !(readLe(data, 17, 1) & 0x20);
+	rle = type >= 9;
+	alpha = channels == 4;
+	checkDimensions("Image::parseTga", width, height);
+	if (!rle && static_cast<uint64_t> (offset)
+		+ static_cast<uint64_t> (width) * height * channels > data.size())
+	{
+		throw (Error("Image::parseTga", "truncated pixels"));
+	}
+}
+
+/**
+ * Parses a binary PPM or PGM header with 8 bits samples.
+ */
+void Image::parsePpm(void)
+{
+	uint32_t values[3] {0, 0, 0};
+	size_t pos {2};
+
+	for (uint32_t &value : values)
+	{
+		while (pos < data.size()
+			&& (std::isspace(data[pos]) || data[pos] == '#'))
+		{
+			if (data[pos] == '#')
+			{
+				while (pos < data.size() && data[pos] != '\n')
+				{
+					++pos;
+				}
+			}
+			else
+			{
+				++pos;
+			}
+		}
+		if (pos >= data.size() || !std::isdigit(data[pos]))
+		{
+			throw (Error("Image::parsePpm", "invalid header"));
+		}
+		while (pos < data.size() && std::isdigit(data[pos]))
+		{
+			value = value * 10 + static_cast<uint32_t> (data[pos++] - '0');
+			if (value > IMAGE_MAX_DIMENSION)
+			{
+				throw (Error("Image::parsePpm", "image too large"));
+			}
+		}
+	}
+	if (values[2] != 255)
+	{
+		throw (Error("Image::parsePpm", "unsupported sample size"));
+	}
+	format = PPM;
+	offset = pos + 1;
+	width = values[0];
+	height = values[1];
+	channels = data[1] == '6' ? 3 : 1;
+	bottom_up = false;
+	rle = false;
+	alpha = false;
+	if (static_cast<uint64_t> (offset)
+		+ static_cast<uint64_t> (width) * height * channels > data.size())
+	{
+		throw (Error("Image::parsePpm", "truncated pixels"));
+	}
+}
+
+/**
+ * Width in pixels.
+ */
+uint32_t Image::getWidth(void) const
+{
+	return (width);
+}
+
+/**
+ * Height in pixels.
+ */
+uint32_t Image::getHeight(void) const
+{
+	return (height);
+}
+
+/**
+ * Number of levels of the complete mip chain.
+ */
+uint32_t Image::getMipLevels(void) const
+{
+	return (mipLevels(width, height));
+}
+
+/**
+ * 64 bits FNV-1a hash of the whole file, identifying its content.
+ */
+uint64_t Image::hash(void) const
+{
+	uint64_t hash {0xcbf29ce484222325ull};
+
+	for (unsigned char c : data)
+	{
+		hash = (hash ^ c) * 0x100000001b3ull;
+	}
+	return (hash);
+}
+
+/**
+ * Decodes the pixels to <dst> as width * height RGBA pixels, top row first.
+ */
+void Image::decode(uint8_t *dst) const
+{
+	switch (format)
+	{
+		case BMP:
+			return (decodeBmp(dst));
+		case TGA:
+			return (decodeTga(dst));
+		case PPM:
+			return (decodePpm(dst));
+	}
+}
+
+/**
+ * Decodes BMP rows, padded to 4 bytes and usually stored bottom-up.
+ */
+void Image::decodeBmp(uint8_t *dst) const
+{
+	const uint8_t *pixels {reinterpret_cast<const uint8_t *> (data.data())
+		+ offset};
+	size_t stride {static_cast<size_t> (bmpStride(width, channels))};
+
+	for (uint32_t y {0}; y < height; ++y)
+	{
+		const uint8_t *src {pixels
+			+ stride * (bottom_up ? height - 1 - y : y)};
+		uint8_t *row {dst + static_cast<size_t> (y) * width * 4};
+
+		for (uint32_t x {0}; x < width; ++x)
+		{
+			writePixel(src + x * channels, channels, alpha, row + x * 4);
+		}
+	}
+}
+
+/**
+ * Decodes TGA pixels, raw or as run length packets which may cross rows.
+ */
+void Image::decodeTga(uint8_t *dst) const
+{
+	const uint8_t *src {reinterpret_cast<const uint8_t *> (data.data())
+		+ offset};
+	const uint8_t *end {reinterpret_cast<const uint8_t *> (data.data())
+		+ data.size()};
+	size_t count {static_cast<size_t> (width) * height};
+	size_t i {0};
+
+	while (i < count)
+	{
+		size_t run {1};
+		bool repeat {false};
+
+		if (rle)
+		{
+			if (src >= end)
+			{
+				throw (Error("Image::decodeTga", "truncated pixels"));
+			}
+			run = (*src & 0x7f) + 1;
+			repeat = *src++ & 0x80;
+		}
+		if (src + (repeat ? 1 : run) * channels > end)
+		{
+			throw (Error("Image::decodeTga", "truncated pixels"));
+		}
+		for (size_t j {0}; j < run && i < count; ++j, ++i)
+		{
+			size_t y {i / width};
+			size_t row {bottom_up ? height - 1 - y : y};
+
+			writePixel(src, channels, alpha,
+				dst + (row * width + i % width) * 4);
+			if (!repeat)
+			{
+				src += channels;
+			}
+		}
+		if (repeat)
+		{
+			src += channels;
+		}
+	}
+}
+
+/**
+ * Decodes PPM (RGB) or PGM (grey) pixels.
+ */
+void Image::decodePpm(uint8_t *dst) const
+{
+	const uint8_t *src {reinterpret_cast<const uint8_t *> (data.data())
+		+ offset};
+	size_t count {static_cast<size_t> (width) * height};
+
+	for (size_t i {0}; i < count; ++i, src += channels, dst += 4)
+	{
+		dst[0] = src[0];
+		dst[1] = src[channels == 3 ? 1 : 0];
+		dst[2] = src[channels == 3 ? 2 : 0];
+		dst[3] = 255;
+	}
+}
+
+/**
+ * Number of levels of the complete mip chain of a <width> by <height> image.
+ */
+uint32_t Image::mipLevels(uint32_t width, uint32_t height)
+{
+	return (static_cast<uint32_t> (std::floor(std::log2(
+		std::max(width, height)))) + 1);
+}
+
+/**
+ * Size in bytes of the first <levels> RGBA levels of the mip chain, stored one
+ * after another.
+ */
+size_t Image::mipChainSize(uint32_t width, uint32_t height, uint32_t levels)
+{
+	size_t size {0};
+
+	for (uint32_t i {0}; i < levels; ++i)
+	{
+		size += static_cast<size_t> (std::max(width >> i, 1u))
+			* std::max(height >> i, 1u) * 4;
+	}
+	return (size);
+}
+
+/**
+ * Fills levels 1 to <levels> - 1 of <chain> from level 0. Each level depends
+ * on the previous one, rows of a level are spread over the pool.
+ */
+void Image::generateMips(uint8_t *chain, uint32_t width, uint32_t height,
+	uint32_t levels, ThreadPool &pool)
+{
+	uint8_t *src {chain};
+
+	gammaTables();
+	for (uint32_t i {1}; i < levels; ++i)
+	{
+		uint8_t *dst {src + static_cast<size_t> (width) * height * 4};
+
+		pool.parallelFor(std::max(height / 2, 1u),
+			[src, width, height, dst](size_t begin, size_t end)
+			{
+				downsample(src, width, height, dst,
+					static_cast<uint32_t> (begin), static_cast<uint32_t> (end));
+			});
+		width = std::max(width / 2, 1u);
+		height = std::max(height / 2, 1u);
+		src = dst;
+	}
+}
+
+/**
+ * Converts the <width> RGBA texels of <row> to floats in <out>: colors to
+ * linear intensities through the gamma table, alpha scaled to [0, 1].
+ */
+static inline void linearRow(const uint8_t *row, uint32_t width, float *out,
+	const GammaTables &tables)
+{
+	for (uint32_t x {0}; x < width; ++x, row += 4, out += 4)
+	{
+		out[0] = tables.to_linear[row[0]];
+		out[1] = tables.to_linear[row[1]];
+		out[2] = tables.to_linear[row[2]];
+		out[3] = static_cast<float> (row[3]) * (1.0f / 255.0f);
+	}
+}
+
+/**
+ * Computes rows [<begin>, <end>) of the half size level <dst> of the RGBA
+ * <src> level with a gamma correct 2x2 box filter: colors are averaged in
+ * linear space, alpha as is. Odd edges are clamped. Both source rows are
+ * converted to linear floats once, then each output texel is averaged as a
+ * vector of four channels, scaled to an index into the sRGB table for colors
+ * and to 8 bits for alpha.
+ */
+void Image::downsample(const uint8_t *src, uint32_t width, uint32_t height,
+	uint8_t *dst, uint32_t begin, uint32_t end)
+{
+	const GammaTables &tables {gammaTables()};
+	uint32_t dst_width {std::max(width / 2, 1u)};
+	std::vector<float> rows(static_cast<size_t> (width) * 8);
+	float *row0 {rows.data()};
+	float *row1 {rows.data() + static_cast<size_t> (width) * 4};
+	const float scale[4] {0.25f * (IMAGE_SRGB_TABLE_SIZE - 1),
+		0.25f * (IMAGE_SRGB_TABLE_SIZE - 1),
+		0.25f * (IMAGE_SRGB_TABLE_SIZE - 1), 0.25f * 255.0f};
+
+	for (uint32_t y {begin}; y < end; ++y)
+	{
+		uint8_t *out {dst + static_cast<size_t> (y) * dst_width * 4};
+
+		linearRow(src + static_cast<size_t> (std::min(2 * y, height - 1))
+			* width * 4, width, row0, tables);
+		linearRow(src + static_cast<size_t> (std::min(2 * y + 1,
+			height - 1)) * width * 4, width, row1, tables);
+		for (uint32_t x {0}; x < dst_width; ++x, out += 4)
+		{
+			uint32_t x0 {std::min(2 * x, width - 1) * 4};
+			uint32_t x1 {std::min(2 * x + 1, width - 1) * 4};
+#if defined(__SSE2__)
+			alignas(16) int32_t index[4];
+			__m128 sum {_mm_add_ps(
+				_mm_add_ps(_mm_loadu_ps(row0 + x0), _mm_loadu_ps(row0 + x1)),
+				_mm_add_ps(_mm_loadu_ps(row1 + x0), _mm_loadu_ps(row1 + x1)))};
+
+			_mm_store_si128(reinterpret_cast<__m128i *> (index),
+				_mm_cvtps_epi32(_mm_mul_ps(sum, _mm_loadu_ps(scale))));
+#else
+			int32_t index[4];
+
+			for (int c {0}; c < 4; ++c)
+			{
+				index[c] = static_cast<int32_t> (std::nearbyint((row0[x0 + c]
+					+ row0[x1 + c] + row1[x0 + c] + row1[x1 + c])
+					* scale[c]));
+			}
+#endif
+			out[0] = tables.to_srgb[index[0]];
+			out[1] = tables.to_srgb[index[1]];
+			out[2] = tables.to_srgb[index[2]];
+			out[3] = static_cast<uint8_t> (index[3]);
+		}
+	}
+}
@@ -0,0 +1,310 @@
+#include <InputLog.hpp>
+
+/**
+ * Log neither recording nor replaying.
+ */
+InputLog::InputLog(void) :
+	mode {OFF},
+	path {},
+	out {},
+	in {},
+	frame {},
+	last {Clock::now()},
+	frames {0},
+	recorded_ms {},
+	frame_ms {}
+{
+	// Empty;
+}
+
+/**
+ * Log replaying the file at <replay> if it isn't empty, recording to the file
+ * at <record> otherwise, or doing nothing if both are empty. Throws if the
+ * file can't be opened or isn't an input log.
+ */
+InputLog::InputLog(const std::string &record, const std::string &replay) :
+	InputLog()
+{
+	if (!replay.empty())
+	{
+		mode = REPLAY;
+		path = replay;
+	}
+	else if (!record.empty())
+	{
+		mode = RECORD;
+		path = record;
+	}
+	open();
+}
+
+/**
+ * Copy constructor, the file belongs to its log so the copy opens it again:
+ * a recording copy starts the file over.
+ */
+InputLog::InputLog(const InputLog &cpy) : InputLog()
+{
+	mode = cpy.mode;
+	path = cpy.path;
+	open();
+}
+
+/**
+ * Destructor, the recorded frames are flushed when the file closes.
+ */
+InputLog::~InputLog(void) noexcept
+{
+	// Empty;
+}
+
+/**
+ * Copy assignement operator, opens the file of <cpy> again.
+ */
+InputLog &InputLog::operator=(const InputLog &cpy)
+{
+	if (this == &cpy)
+	{
+		return (*this);
+	}
+	out.close();
+	in.close();
+	mode = cpy.mode;
+	path = cpy.path;
+	frame.clear();
+	frames = 0;
+	recorded_ms.clear();
+	frame_ms.clear();
+	open();
+	return (*this);
+}
+
+/**
+ * Opens the file of the current mode and writes or checks its magic.
+ */
+void InputLog::open(void)
+{
+	char magic[INPUTLOG_MAGIC_SIZE] {};
+
+	if (mode == RECORD)
+	{
+		out.open(path, std::ios::binary | std::ios::trunc);
+		if (!out)
+		{
+			throw (Error("InputLog::open", "failed to create the input log"));
+		}
+		out.write(INPUTLOG_MAGIC, INPUTLOG_MAGIC_SIZE);
+	}
+	else if (mode == REPLAY)
+	{
+		in.open(path, std::ios::binary);
+		if (!in)
+		{
+			throw (Error("InputLog::open", "failed to open the input log"));
+		}
+		if (!in.read(magic, INPUTLOG_MAGIC_SIZE)
+			|| std::memcmp(magic, INPUTLOG_MAGIC, INPUTLOG_MAGIC_SIZE))
+		{
+			throw (Error("InputLog::open", "not an input log"));
+		}
+	}
+	last = Clock::now();
+}
+
+/**
+ * Current mode.
+ */
+InputLog::Mode InputLog::getMode(void) const
+{
+	return (mode);
+}
+
+/**
+ * Keeps <event> for the frame being recorded.
+ */
+void InputLog::record(const SDL_Event &event)
+{
+	if (mode == RECORD)
+	{
+		frame.push_back(event);
+	}
+}
+
+/**
+ * Writes the frame being recorded: the microseconds elapsed since the
+ * previous one, and the events it kept.
+ */
+void InputLog::endFrame(void)
+{
+	if (mode != RECORD)
+	{
+		return ;
+	}
+
+	Clock::time_point now {Clock::now()};
+	uint64_t elapsed {static_cast<uint64_t> (
+		std::chrono::duration_cast<std::chrono::microseconds> (now - last)
+		.count())};
+
+	last = now;
+	write(static_cast<uint32_t> (std::min<uint64_t>(elapsed, UINT32_MAX)));
+	write(static_cast<uint16_t> (std::min<size_t>(frame.size(), UINT16_MAX)));
+	for (size_t i {0}; i < frame.size() && i < UINT16_MAX; ++i)
+	{
+		writeEvent(frame[i]);
+	}
+	frame.clear();
+	++frames;
+}
+
+/**
+ * Writes <event> with only the fields the program reads. Keys are the only
+ * keyboard events handled, every unknown event counts as an other one.
+ */
+void InputLog::writeEvent(const SDL_Event &event)
+{
+	switch (event.type)
+	{
+		case SDL_QUIT:
+			write(QUIT);
+			break ;
+		case SDL_KEYDOWN:
+			write(KEY);
+			write(static_cast<int32_t> (event.key.keysym.sym));
+			break ;
+		case SDL_WINDOWEVENT:
+			write(WINDOW);
+			write(static_cast<uint8_t> (event.window.event));
+			write(static_cast<int32_t> (event.window.data1));
+			write(static_cast<int32_t> (event.window.data2));
+			break ;
+		default:
+			write(OTHER);
+			break ;
+	}
+}
+
+/**
+ * Reads back an event written by writeEvent. Other events become user events,
+ * which only mark the scene as dirty. Returns false if the file is truncated
+ * or corrupted.
+ */
+bool InputLog::readEvent(SDL_Event &event)
+{
+	Kind kind {OTHER};
+	uint8_t window {0};
+	int32_t data[2] {};
+
+	event = SDL_Event {};
+	if (!read(kind))
+	{
+		return (false);
+	}
+	switch (kind)
+	{
+		case QUIT:
+			event.type = SDL_QUIT;
+			return (true);
+		case KEY:
+			event.type = SDL_KEYDOWN;
+			return (read(event.key.keysym.sym));
+		case WINDOW:
+			event.type = SDL_WINDOWEVENT;
+			if (!read(window) || !read(data[0]) || !read(data[1]))
+			{
+				return (false);
+			}
+			event.window.event = window;
+			event.window.data1 = data[0];
+			event.window.data2 = data[1];
+			return (true);
+		case OTHER:
+			event.type = SDL_USEREVENT;
+			return (true);
+		default:
+			return (false);
+	}
+}
+
+/**
+ * Replaces <events> with the events of the next recorded frame, and measures
+ * how long the previous frame took, next to how long it took when recorded.
+ * Returns false once every frame has been
+ * replayed.
+ */
+bool InputLog::replay(std::vector<SDL_Event> &events)
+{
+	Clock::time_point now {Clock::now()};
+	uint32_t elapsed {0};
+	uint16_t count {0};
+
+	events.clear();
+	if (mode != REPLAY)
+	{
+		return (false);
+	}
+	if (frames)
+	{
+		frame_ms.push_back(std::chrono::duration<float, std::milli> (
+			now - last).count());
+	}
+	last = now;
+	if (!read(elapsed) || !read(count))
+	{
+		return (false);
+	}
+	recorded_ms.push_back(static_cast<float> (elapsed) / 1000.0f);
+	events.resize(count);
+	for (SDL_Event &event : events)
+	{
+		if (!readEvent(event))
+		{
+			events.clear();
+			return (false);
+		}
+	}
+	++frames;
+	return (true);
+}
+
+/**
+ * Writes the distribution of <values> in milliseconds: average, median, 90th
+ * and 99th percentiles, and worst.
+ */
+static inline void writeDistribution(std::ostream &out, const char *name,
+	std::vector<float> values)
+{
+	float total {0.0f};
+
+	if (values.empty())
+	{
+		return ;
+	}
+	std::sort(values.begin(), values.end());
+	for (float ms : values)
+	{
+		total += ms;
+	}
+	out << std::fixed << std::setprecision(2) << std::left << std::setw(10)
+		<< name << std::right << std::setw(8) << values.size()
+		<< " frames avg " << total / static_cast<float> (values.size())
+		<< " p50 " << values[values.size() / 2]
+		<< " p90 " << values[values.size() * 90 / 100]
+		<< " p99 " << values[values.size() * 99 / 100]
+		<< " max " << values.back() << " ms" << std::endl;
+}
+
+/**
+ * Writes the distribution of the frame times of the recorded session and of
+ * its replay. The first recorded frame includes startup and is left out.
+ * Writes nothing if not replaying.
+ */
+void InputLog::writeSummary(std::ostream &out) const
+{
+	if (mode != REPLAY || recorded_ms.empty())
+	{
+		return ;
+	}
+	writeDistribution(out, "recorded", std::vector<float> (
+		recorded_ms.begin() + 1, recorded_ms.end()));
+	writeDistribution(out, "replayed", frame_ms);
+}
@@ -0,0 +1,192 @@
+#include <Mat4.hpp>
+
+/**
+ * Component-wise addition.
+ */
+Vec3 Vec3::operator+(const Vec3 &rhs) const
+{
+	return (Vec3 {x + rhs.x, y + rhs.y, z + rhs.z});
+}
+
+/**
+ * Component-wise subtraction.
+ */
+Vec3 Vec3::operator-(const Vec3 &rhs) const
+{
+	return (Vec3 {x - rhs.x, y - rhs.y, z - rhs.z});
+}
+
+/**
+ * Scalar multiplication.
+ */
+Vec3 Vec3::operator*(float rhs) const
+{
+	return (Vec3 {x * rhs, y * rhs, z * rhs});
+}
+
+/**
+ * Dot product.
+ */
+float Vec3::dot(const Vec3 &a, const Vec3 &b)
+{
+	return (a.x * b.x + a.y * b.y + a.z * b.z);
+}
+
+/**
+ * Cross product.
+ */
+Vec3 Vec3::cross(const Vec3 &a, const Vec3 &b)
+{
+	return (Vec3 {
+		a.y * b.z - a.z * b.y,
+		a.z * b.x - a.x * b.z,
+		a.x * b.y - a.y * b.x
+	});
+}
+
+/**
+ * Euclidean length.
+ */
+float Vec3::length(const Vec3 &v)
+{
+	return (std::sqrt(dot(v, v)));
+}
+
+/**
+ * Unit vector of same direction, null vectors are returned as is.
+ */
+Vec3 Vec3::normalize(const Vec3 &v)
+{
+	float len {length(v)};
+
+	if (len == 0.0f)
+	{
+		return (v);
+	}
+	return (v * (1.0f / len));
+}
+
+/**
+ * Matrix product.
+ */
+Mat4 Mat4::operator*(const Mat4 &rhs) const
+{
+	Mat4 res {};
+
+	for (int c {0}; c < 4; ++c)
+	{
+		for (int r {0}; r < 4; ++r)
+		{
+			res.m[c * 4 + r] = m[r] * rhs.m[c * 4]
+				+ m[4 + r] * rhs.m[c * 4 + 1]
+				+ m[8 + r] * rhs.m[c * 4 + 2]
+				+ m[12 + r] * rhs.m[c * 4 + 3];
+		}
+	}
+	return (res);
+}
+
+/**
+ * Identity matrix.
+ */
+Mat4 Mat4::identity(void)
+{
+	Mat4 res {};
+
+	res.m[0] = 1.0f;
+	res.m[5] = 1.0f;
+	res.m[10] = 1.0f;
+	res.m[15] = 1.0f;
+	return (res);
+}
+
+/**
+ * Translation by <t>.
+ */
+Mat4 Mat4::translation(const Vec3 &t)
+{
+	Mat4 res {identity()};
+
+	res.m[12] = t.x;
+	res.m[13] = t.y;
+	res.m[14] = t.z;
+	return (res);
+}
+
+/**
+ * Uniform scaling by <s>.
+ */
+Mat4 Mat4::scale(float s)
+{
+	Mat4 res {identity()};
+
+	res.m[0] = s;
+	res.m[5] = s;
+	res.m[10] = s;
+	return (res);
+}
+
+/**
+ * Rotation of <angle> radians around <axis>.
+ */
+Mat4 Mat4::rotation(float angle, const Vec3 &axis)
+{
+	Vec3 a {Vec3::normalize(axis)};
+	float c {std::cos(angle)};
+	float s {std::sin(angle)};
+	float t {1.0f - c};
+	Mat4 res {identity()};
+
+	res.m[0] = t * a.x * a.x + c;
+	res.m[1] = t * a.x * a.y + s * a.z;
+	res.m[2] = t * a.x * a.z - s * a.y;
+	res.m[4] = t * a.x * a.y - s * a.z;
+	res.m[5] = t * a.y * a.y + c;
+	res.m[6] = t * a.y * a.z + s * a.x;
+	res.m[8] = t * a.x * a.z + s * a.y;
+	res.m[9] = t * a.y * a.z - s * a.x;
+	res.m[10] = t * a.z * a.z + c;
+	return (res);
+}
+
+/**
+ * Right handed view matrix looking from <eye> to <center>.
+ */
+Mat4 Mat4::lookAt(const Vec3 &eye, const Vec3 &center, const Vec3 &up)
+{
+	Vec3 f {Vec3::normalize(center - eye)};
+	Vec3 s {Vec3::normalize(Vec3::cross(f, up))};
+	Vec3 u {Vec3::cross(s, f)};
+	Mat4 res {identity()};
+
+	res.m[0] = s.x;
+	res.m[4] = s.y;
+	res.m[8] = s.z;
+	res.m[1] = u.x;
+	res.m[5] = u.y;
+	res.m[9] = u.z;
+	res.m[2] = -f.x;
+	res.m[6] = -f.y;
+	res.m[10] = -f.z;
+	res.m[12] = -Vec3::dot(s, eye);
+	res.m[13] = -Vec3::dot(u, eye);
+	res.m[14] = Vec3::dot(f, eye);
+	return (res);
+}
+
+/**
+ * Perspective projection for Vulkan clip space: depth in [0, 1] and y axis
+ * pointing down, hence the negated y scale.
+ */
+Mat4 Mat4::perspective(float fovy, float aspect, float near, float far)
+{
+	float f {1.0f / std::tan(fovy / 2.0f)};
+	Mat4 res {};
+
+	res.m[0] = f / aspect;
+	res.m[5] = -f;
+	res.m[10] = far / (near - far);
+	res.m[11] = -1.0f;
+	res.m[14] = (near * far) / (near - far);
+	return (res);
+}
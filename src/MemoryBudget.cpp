@@ -0,0 +1,369 @@
+#include <MemoryBudget.hpp>
+
+/**
+ * Budget of no device.
+ */
+MemoryBudget::MemoryBudget(void) :
+	MemoryBudget(VK_NULL_HANDLE, VK_NULL_HANDLE, nullptr, false, 0)
+{
+	// Empty;
+}
+
+/**
+ * Budget of the memory <device> allocates from <physical_device> with
+ * <allocator>. <extension> tells if VK_EXT_memory_budget is enabled. A non
+ * null <cap> bounds the budget of device local heaps.
+ */
+MemoryBudget::MemoryBudget(VkPhysicalDevice physical_device, VkDevice device,
+	const VkAllocationCallbacks *allocator, bool extension, VkDeviceSize cap) :
+	physical_device {physical_device},
+	device {device},
+	allocator {allocator},
+	extension {extension},
+	cap {cap},
+	properties {},
+	heaps {},
+	allocations {},
+	recent {},
+	entries {},
+	mutex {}
+{
+	if (physical_device == VK_NULL_HANDLE)
+	{
+		return ;
+	}
+	vkGetPhysicalDeviceMemoryProperties(physical_device, &properties);
+	for (uint32_t i {0}; i < properties.memoryHeapCount; ++i)
+	{
+		heaps.push_back(Heap {
+			.size = properties.memoryHeaps[i].size,
+			.budget = 0,
+			.usage = 0,
+			.own = 0,
+			.peak = 0,
+			.retired = 0,
+			.device_local = static_cast<bool> (properties.memoryHeaps[i].flags
+				& VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+		});
+	}
+	update();
+}
+
+/**
+ * Copy constructor, only the device is copied since the allocations belong to
+ * their budget.
+ */
+MemoryBudget::MemoryBudget(const MemoryBudget &cpy) :
+	MemoryBudget(cpy.physical_device, cpy.device, cpy.allocator,
+		cpy.extension, cpy.cap)
+{
+	// Empty;
+}
+
+/**
+ * Destructor, the memory must have been freed while the device exists.
+ */
+MemoryBudget::~MemoryBudget(void) noexcept
+{
+	// Empty;
+}
+
+/**
+ * Copy assignement operator, only the device and the heaps are copied.
+ * Everything allocated so far must have been freed.
+ */
+MemoryBudget &MemoryBudget::operator=(const MemoryBudget &cpy)
+{
+	std::lock_guard<std::mutex> lock {mutex};
+
+	if (!allocations.empty())
+	{
+		throw (Error("MemoryBudget::operator=", "memory not freed"));
+	}
+	physical_device = cpy.physical_device;
+	device = cpy.device;
+	allocator = cpy.allocator;
+	extension = cpy.extension;
+	cap = cpy.cap;
+	properties = cpy.properties;
+	heaps = cpy.heaps;
+	recent.clear();
+	entries.clear();
+	return (*this);
+}
+
+/**
+ * Finds a memory type allowed by <type_filter> having every <properties> and
+ * none of <excluded>. Returns UINT32_MAX if there is none.
+ */
+uint32_t MemoryBudget::findType(uint32_t type_filter,
+	VkMemoryPropertyFlags properties, VkMemoryPropertyFlags excluded) const
+{
+	for (uint32_t i {0}; i < this->properties.memoryTypeCount; ++i)
+	{
+		VkMemoryPropertyFlags flags {
+			this->properties.memoryTypes[i].propertyFlags};
+
+		if ((type_filter & (1 << i)) && (flags & properties) == properties
+			&& !(flags & excluded))
+		{
+			return (i);
+		}
+	}
+	return (UINT32_MAX);
+}
+
+/**
+ * Allocates <requirements> from a memory type having every <properties>.
+ * Memory that doesn't have to be device local is taken from host heaps first.
+ * If device local memory is exhausted, any other type the resource accepts is
+ * used instead, so that it is slower rather than missing. Throws if no type
+ * fits, returns the result of the allocation otherwise.
+ */
+VkResult MemoryBudget::allocate(const VkMemoryRequirements &requirements,
+	VkMemoryPropertyFlags properties, VkDeviceMemory &memory)
+{
+	VkMemoryAllocateInfo alloc_info {};
+	uint32_t type {UINT32_MAX};
+
+	if (!(properties & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+	{
+		type = findType(requirements.memoryTypeBits, properties,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	}
+	if (type == UINT32_MAX)
+	{
+		type = findType(requirements.memoryTypeBits, properties, 0);
+	}
+	if (type == UINT32_MAX)
+	{
+		throw (Error("MemoryBudget::allocate", "no suitable memory type"));
+	}
+	alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	alloc_info.allocationSize = requirements.size;
+	alloc_info.memoryTypeIndex = type;
+
+	VkResult result {vkAllocateMemory(device, &alloc_info, allocator,
+		&memory)};
+
+	if (result == VK_ERROR_OUT_OF_DEVICE_MEMORY
+		&& (properties & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+	{
+		type = findType(requirements.memoryTypeBits,
+			properties & ~VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		if (type != UINT32_MAX)
+		{
+			alloc_info.memoryTypeIndex = type;
+			result = vkAllocateMemory(device, &alloc_info, allocator, &memory);
+		}
+	}
+	if (result != VK_SUCCESS)
+	{
+		return (result);
+	}
+
+	std::lock_guard<std::mutex> lock {mutex};
+	uint32_t index {this->properties.memoryTypes[type].heapIndex};
+	Heap &heap {heaps[index]};
+
+	allocations.emplace(memory, Allocation {index, requirements.size,
+		false});
+	heap.own += requirements.size;
+	heap.usage += requirements.size;
+	heap.peak = std::max(heap.peak, heap.own);
+	return (VK_SUCCESS);
+}
+
+/**
+ * Tells if a memory type allowed by <type_filter> has every <properties>.
+ */
+bool MemoryBudget::supports(uint32_t type_filter,
+	VkMemoryPropertyFlags properties) const
+{
+	return (findType(type_filter, properties, 0) != UINT32_MAX);
+}
+
+/**
+ * Stops counting <memory> as used although it is only freed later, once the
+ * GPU is done with it, so that what replaces it can be accounted already.
+ */
+void MemoryBudget::retire(VkDeviceMemory memory)
+{
+	std::lock_guard<std::mutex> lock {mutex};
+	auto it {allocations.find(memory)};
+
+	if (it == allocations.end() || it->second.retired)
+	{
+		return ;
+	}
+
+	Heap &heap {heaps[it->second.heap]};
+
+	it->second.retired = true;
+	heap.retired += it->second.size;
+	heap.usage -= std::min(heap.usage, it->second.size);
+}
+
+/**
+ * Frees <memory>, allocated by this budget or null.
+ */
+void MemoryBudget::free(VkDeviceMemory memory)
+{
+	if (memory == VK_NULL_HANDLE)
+	{
+		return ;
+	}
+	{
+		std::lock_guard<std::mutex> lock {mutex};
+		auto it {allocations.find(memory)};
+
+		if (it != allocations.end())
+		{
+			Heap &heap {heaps[it->second.heap]};
+
+			heap.own -= it->second.size;
+			if (it->second.retired)
+			{
+				heap.retired -= it->second.size;
+			}
+			else
+			{
+				heap.usage -= std::min(heap.usage, it->second.size);
+			}
+			allocations.erase(it);
+		}
+	}
+	vkFreeMemory(device, memory, allocator);
+}
+
+/**
+ * Refreshes the budget and usage of every heap. Without the extension the
+ * budget is MEMORYBUDGET_FALLBACK percent of the heap and only the memory of
+ * this budget counts as used. Retired memory never does.
+ */
+void MemoryBudget::update(void)
+{
+	VkPhysicalDeviceMemoryBudgetPropertiesEXT budget {};
+	VkPhysicalDeviceMemoryProperties2 memory {};
+	std::lock_guard<std::mutex> lock {mutex};
+
+	if (extension)
+	{
+		budget.sType =
+			VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+		memory.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+		memory.pNext = &budget;
+		vkGetPhysicalDeviceMemoryProperties2(physical_device, &memory);
+	}
+	for (uint32_t i {0}; i < heaps.size(); ++i)
+	{
+		Heap &heap {heaps[i]};
+
+		heap.budget = extension ? budget.heapBudget[i]
+			: heap.size / 100 * MEMORYBUDGET_FALLBACK;
+		heap.usage = extension ? budget.heapUsage[i] : heap.own;
+		heap.usage -= std::min(heap.usage, heap.retired);
+		if (cap && heap.device_local)
+		{
+			heap.budget = std::min(heap.budget, cap);
+		}
+	}
+}
+
+/**
+ * Index of the largest device local heap.
+ */
+uint32_t MemoryBudget::getDeviceHeap(void) const
+{
+	uint32_t index {0};
+
+	for (uint32_t i {0}; i < heaps.size(); ++i)
+	{
+		if (heaps[i].device_local && (!heaps[index].device_local
+			|| heaps[i].size > heaps[index].size))
+		{
+			index = i;
+		}
+	}
+	return (index);
+}
+
+/**
+ * Size of <memory>, or 0 if it wasn't allocated by this budget.
+ */
+VkDeviceSize MemoryBudget::getSize(VkDeviceMemory memory)
+{
+	std::lock_guard<std::mutex> lock {mutex};
+	auto it {allocations.find(memory)};
+
+	return (it != allocations.end() ? it->second.size : 0);
+}
+
+/**
+ * Tells if using <extra> more bytes of <heap> would go past <percent> of its
+ * budget.
+ */
+bool MemoryBudget::exceeds(uint32_t heap, VkDeviceSize extra,
+	uint32_t percent)
+{
+	std::lock_guard<std::mutex> lock {mutex};
+
+	if (heap >= heaps.size())
+	{
+		return (false);
+	}
+	return (heaps[heap].usage + extra > heaps[heap].budget / 100 * percent);
+}
+
+/**
+ * Marks <resource> as the most recently used.
+ */
+void MemoryBudget::touch(uint32_t resource)
+{
+	std::lock_guard<std::mutex> lock {mutex};
+	auto it {entries.find(resource)};
+
+	if (it != entries.end())
+	{
+		recent.splice(recent.begin(), recent, it->second);
+		return ;
+	}
+	recent.push_front(resource);
+	entries.emplace(resource, recent.begin());
+}
+
+/**
+ * Every resource touched so far, least recently used first.
+ */
+std::vector<uint32_t> MemoryBudget::getLeastRecentlyUsed(void)
+{
+	std::lock_guard<std::mutex> lock {mutex};
+
+	return (std::vector<uint32_t> (recent.rbegin(), recent.rend()));
+}
+
+/**
+ * Writes the size, budget, usage, usage of this program and its peak of every
+ * heap, in MiB.
+ */
+void MemoryBudget::writeReport(std::ostream &out)
+{
+	std::lock_guard<std::mutex> lock {mutex};
+
+	out << "device memory" << (extension ? "" : " (estimated budget)") << ":"
+		<< std::endl << std::left << std::setw(9) << "heap" << std::right
+		<< std::setw(10) << "size" << std::setw(10) << "budget"
+		<< std::setw(10) << "usage" << std::setw(10) << "own"
+		<< std::setw(10) << "peak" << std::endl;
+	for (uint32_t i {0}; i < heaps.size(); ++i)
+	{
+		out << std::left << std::setw(9) << (std::to_string(i)
+			+ (heaps[i].device_local ? " local" : " host")) << std::right
+			<< std::setw(10) << (heaps[i].size >> 20)
+			<< std::setw(10) << (heaps[i].budget >> 20)
+			<< std::setw(10) << (heaps[i].usage >> 20)
+			<< std::setw(10) << (heaps[i].own >> 20)
+			<< std::setw(10) << (heaps[i].peak >> 20) << std::endl;
+	}
+}
@@ -0,0 +1,730 @@
+#include <Mesh.hpp>
+
+/**
+ * Exact powers of ten representable by a double.
+ */
+static const double pow10_table[] {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/**
+ * Compares two face indices.
+ */
+bool Mesh::FaceIndex::operator==(const FaceIndex &rhs) const
+{
+	return (v == rhs.v && vt == rhs.vt && vn == rhs.vn);
+}
+
+/**
+ * Mixes the three indices of a face vertex into a hash.
+ */
+size_t Mesh::FaceIndexHash::operator()(const FaceIndex &idx) const
+{
+	uint64_t h {static_cast<uint32_t> (idx.v) * 0x9E3779B97F4A7C15ull};
+
+	h ^= static_cast<uint32_t> (idx.vt) + 0x7F4A7C159E3779B9ull + (h << 6)
+		+ (h >> 2);
+	h ^= static_cast<uint32_t> (idx.vn) + 0x94D049BB133111EBull + (h << 6)
+		+ (h >> 2);
+	return (static_cast<size_t> (h));
+}
+
+/**
+ * Default constructor, empty mesh.
+ */
+Mesh::Mesh(void) : bounds {}, generated {false}
+{
+	// Empty;
+}
+
+/**
+ * Loads the OBJ file at <path>.
+ */
+Mesh::Mesh(const std::string &path) : bounds {}, generated {false}
+{
+	load(path);
+}
+
+/**
+ * Copy constructor.
+ */
+Mesh::Mesh(const Mesh &cpy) :
+	positions {cpy.positions},
+	attributes {cpy.attributes},
+	indices {cpy.indices},
+	bounds {cpy.bounds},
+	generated {cpy.generated}
+{
+	// Empty;
+}
+
+/**
+ * Destructor.
+ */
+Mesh::~Mesh(void) noexcept
+{
+	// Empty;
+}
+
+/**
+ * Copy assignement operator.
+ */
+Mesh &Mesh::operator=(const Mesh &cpy)
+{
+	positions = cpy.positions;
+	attributes = cpy.attributes;
+	indices = cpy.indices;
+	bounds = cpy.bounds;
+	generated = cpy.generated;
+	return (*this);
+}
+
+/**
+ * Converts an OBJ index, 1-based or negative relative to the end, to a 0-based
+ * index in an array of <count> elements. 0 (absent) gives -1.
+ */
+static inline int32_t resolveIndex(int32_t idx, size_t count)
+{
+	int64_t res {idx > 0 ? idx - 1 : static_cast<int64_t> (count) + idx};
+
+	if (idx == 0)
+	{
+		return (-1);
+	}
+	if (res < 0 || res >= static_cast<int64_t> (count))
+	{
+		throw (Error("Mesh::load", "face index out of range"));
+	}
+	return (static_cast<int32_t> (res));
+}
+
+/**
+ * Length of the keyword starting at <p>.
+ */
+static inline size_t keywordLength(const char *p, const char *end)
+{
+	const char *start {p};
+
+	while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+	{
+		++p;
+	}
+	return (static_cast<size_t> (p - start));
+}
+
+/**
+ * Hands the vertices and indices parsed since the previous chunk to <stream>,
+ * with the bounds of every position so far and the <progress> of the parse.
+ */
+void Mesh::sendChunk(const Stream &stream, Chunk &chunk, float progress) const
+{
+	chunk.first_vertex += chunk.positions.size();
+	chunk.first_index += chunk.indices.size();
+	chunk.positions.assign(positions.begin() + chunk.first_vertex,
+		positions.end());
+	chunk.attributes.assign(attributes.begin() + chunk.first_vertex,
+		attributes.end());
+	chunk.indices.assign(indices.begin() + chunk.first_index, indices.end());
+	growBounds(chunk.bounds, chunk.positions);
+	chunk.progress = progress;
+	stream(chunk);
+}
+
+/**
+ * Parses the faces and vertex data of the OBJ file at <path>. Face vertices
+ * sharing the same position, texture and normal indices are welded into one
+ * vertex, polygons are triangulated as fans. Every other statement is ignored.
+ * With a <stream>, every MESH_CHUNK_TRIANGLES triangles are handed to it as
+ * they are parsed. Their missing normals are the one of their first face and
+ * their missing texture coordinates are null until the end of the parse.
+ * Binary assets are decoded whole instead, without <stream>.
+ */
+void Mesh::load(const std::string &path, const Stream &stream)
+{
+	if (isAsset(path))
+	{
+		return (loadAsset(path));
+	}
+
+	std::string data {readFile(path)};
+	const char *p {data.data()};
+	const char *end {p + data.size()};
+	std::vector<Vec3> raw_v;
+	std::vector<float> raw_vt;
+	std::vector<Vec3> raw_vn;
+	std::unordered_map<FaceIndex, uint32_t, FaceIndexHash> welded;
+	std::vector<bool> missing_normal;
+	std::vector<bool> missing_uv;
+	std::vector<uint32_t> face;
+	float far {std::numeric_limits<float>::max()};
+	Chunk chunk {0, 0, {}, {}, {}, Bounds {Vec3 {far, far, far},
+		Vec3 {-far, -far, -far}}, 0.0f};
+
+	positions.clear();
+	attributes.clear();
+	indices.clear();
+	while (p < end)
+	{
+		p = skipSpaces(p, end);
+
+		size_t len {keywordLength(p, end)};
+		const char *args {skipSpaces(p + len, end)};
+
+		if (len == 1 && p[0] == 'v')
+		{
+			float x {parseFloat(args, end)};
+			float y {parseFloat(args = skipSpaces(args, end), end)};
+			float z {parseFloat(args = skipSpaces(args, end), end)};
+
+			raw_v.push_back(Vec3 {x, y, z});
+		}
+		else if (len == 2 && p[0] == 'v' && p[1] == 't')
+		{
+			raw_vt.push_back(parseFloat(args, end));
+			args = skipSpaces(args, end);
+			raw_vt.push_back(args < end && *args != '\n'
+				? parseFloat(args, end) : 0.0f);
+		}
+		else if (len == 2 && p[0] == 'v' && p[1] == 'n')
+		{
+			float x {parseFloat(args, end)};
+			float y {parseFloat(args = skipSpaces(args, end), end)};
+			float z {parseFloat(args = skipSpaces(args, end), end)};
+
+			raw_vn.push_back(Vec3 {x, y, z});
+		}
+		else if (len == 1 && p[0] == 'f')
+		{
+			FaceIndex idx {};
+			size_t first_new {positions.size()};
+
+			face.clear();
+			while (parseFaceIndex(args, end, idx))
+			{
+				idx.v = resolveIndex(idx.v, raw_v.size());
+				idx.vt = resolveIndex(idx.vt, raw_vt.size() / 2);
+				idx.vn = resolveIndex(idx.vn, raw_vn.size());
+				if (idx.v < 0)
+				{
+					throw (Error("Mesh::load", "face without position"));
+				}
+
+				auto [it, inserted] {welded.try_emplace(idx,
+					static_cast<uint32_t> (positions.size()))};
+
+				if (inserted)
+				{
+					Attributes attr {};
+
+					if (idx.vn >= 0)
+					{
+						attr.normal[0] = raw_vn[idx.vn].x;
+						attr.normal[1] = raw_vn[idx.vn].y;
+						attr.normal[2] = raw_vn[idx.vn].z;
+					}
+					if (idx.vt >= 0)
+					{
+						attr.uv[0] = raw_vt[2 * idx.vt];
+						attr.uv[1] = raw_vt[2 * idx.vt + 1];
+					}
+					positions.push_back(raw_v[idx.v]);
+					attributes.push_back(attr);
+					missing_normal.push_back(idx.vn < 0);
+					missing_uv.push_back(idx.vt < 0);
+				}
+				face.push_back(it->second);
+				args = skipSpaces(args, end);
+			}
+			for (size_t i {2}; i < face.size(); ++i)
+			{
+				indices.push_back(face[0]);
+				indices.push_back(face[i - 1]);
+				indices.push_back(face[i]);
+			}
+			if (stream && face.size() > 2)
+			{
+				Vec3 n {Vec3::normalize(Vec3::cross(
+					positions[face[1]] - positions[face[0]],
+					positions[face[2]] - positions[face[0]]))};
+
+				for (size_t i {first_new}; i < positions.size(); ++i)
+				{
+					if (missing_normal[i])
+					{
+						attributes[i].normal[0] = n.x;
+						attributes[i].normal[1] = n.y;
+						attributes[i].normal[2] = n.z;
+					}
+				}
+			}
+			if (stream && indices.size() - chunk.first_index
+				- chunk.indices.size() >= MESH_CHUNK_TRIANGLES * 3)
+			{
+				sendChunk(stream, chunk, static_cast<float> (args
+					- data.data()) / static_cast<float> (data.size()));
+			}
+		}
+		p = nextLine(p, end);
+	}
+	if (indices.empty())
+	{
+		throw (Error("Mesh::load", "no face in file"));
+	}
+	if (stream && indices.size() > chunk.first_index + chunk.indices.size())
+	{
+		sendChunk(stream, chunk, 1.0f);
+	}
+	generated = std::find(missing_normal.begin(), missing_normal.end(), true)
+		!= missing_normal.end() || std::find(missing_uv.begin(),
+		missing_uv.end(), true) != missing_uv.end();
+	computeNormals(missing_normal);
+	computeBounds();
+	computeTextureCoordinates(missing_uv);
+}
+
+/**
+ * Maps the binary asset at <path> and decodes its first level of detail.
+ */
+void Mesh::loadAsset(const std::string &path)
+{
+	int fd {open(path.c_str(), O_RDONLY)};
+	struct stat info {};
+	void *data {MAP_FAILED};
+
+	if (fd < 0)
+	{
+		throw (Error("Mesh::loadAsset", "failed open file"));
+	}
+	if (!fstat(fd, &info) && info.st_size > 0)
+	{
+		data = mmap(nullptr, static_cast<size_t> (info.st_size), PROT_READ,
+			MAP_PRIVATE, fd, 0);
+	}
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		throw (Error("Mesh::loadAsset", "failed to map file"));
+	}
+	try
+	{
+		decodeAsset(static_cast<const uint8_t *> (data),
+			static_cast<size_t> (info.st_size));
+	}
+	catch (...)
+	{
+		munmap(data, static_cast<size_t> (info.st_size));
+		throw ;
+	}
+	munmap(data, static_cast<size_t> (info.st_size));
+}
+
+/**
+ * Decodes the first level of detail of the asset of <size> bytes at <data>
+ * into the vertex and index streams. Throws if the asset is invalid.
+ */
+void Mesh::decodeAsset(const uint8_t *data, size_t size)
+{
+	AssetHeader header {};
+	AssetLod lod {};
+
+	if (size < sizeof(header))
+	{
+		throw (Error("Mesh::decodeAsset", "truncated asset"));
+	}
+	std::memcpy(&header, data, sizeof(header));
+	if (std::memcmp(header.magic, MESH_ASSET_MAGIC, 4)
+		|| header.version != MESH_ASSET_VERSION || !header.lod_count
+		|| (header.index_size != 2 && header.index_size != 4))
+	{
+		throw (Error("Mesh::decodeAsset", "not a mesh asset"));
+	}
+
+	size_t vertex_offset {sizeof(header) + header.lod_count * sizeof(lod)};
+	size_t index_offset {vertex_offset + static_cast<size_t> (
+		header.vertex_count) * sizeof(AssetVertex)};
+
+	if (index_offset + static_cast<size_t> (header.index_count)
+		* header.index_size > size)
+	{
+		throw (Error("Mesh::decodeAsset", "truncated asset"));
+	}
+	std::memcpy(&lod, data + sizeof(header), sizeof(lod));
+	if (!lod.index_count || lod.index_count % 3 || static_cast<uint64_t> (
+		lod.first_index) + lod.index_count > header.index_count)
+	{
+		throw (Error("Mesh::decodeAsset", "invalid level of detail"));
+	}
+
+	const float scale[3] {(header.max[0] - header.min[0]) / 65535.0f,
+		(header.max[1] - header.min[1]) / 65535.0f,
+		(header.max[2] - header.min[2]) / 65535.0f};
+	const float uv_scale[2] {(header.uv_max[0] - header.uv_min[0]) / 65535.0f,
+		(header.uv_max[1] - header.uv_min[1]) / 65535.0f};
+
+	positions.resize(header.vertex_count);
+	attributes.resize(header.vertex_count);
+	for (size_t i {0}; i < header.vertex_count; ++i)
+	{
+		AssetVertex v {};
+
+		std::memcpy(&v, data + vertex_offset + i * sizeof(v), sizeof(v));
+		positions[i] = Vec3 {header.min[0] + v.position[0] * scale[0],
+			header.min[1] + v.position[1] * scale[1],
+			header.min[2] + v.position[2] * scale[2]};
+		for (size_t j {0}; j < 3; ++j)
+		{
+			attributes[i].normal[j] = static_cast<float> (v.normal[j])
+				/ 32767.0f;
+		}
+		attributes[i].uv[0] = header.uv_min[0] + v.uv[0] * uv_scale[0];
+		attributes[i].uv[1] = header.uv_min[1] + v.uv[1] * uv_scale[1];
+	}
+	indices.resize(lod.index_count);
+	for (size_t i {0}; i < lod.index_count; ++i)
+	{
+		const uint8_t *src {data + index_offset
+			+ (lod.first_index + i) * header.index_size};
+		uint16_t narrow {0};
+
+		if (header.index_size == 2)
+		{
+			std::memcpy(&narrow, src, sizeof(narrow));
+			indices[i] = narrow;
+		}
+		else
+		{
+			std::memcpy(&indices[i], src, sizeof(indices[i]));
+		}
+		if (indices[i] >= header.vertex_count)
+		{
+			throw (Error("Mesh::decodeAsset", "index out of range"));
+		}
+	}
+	bounds.min = Vec3 {header.min[0], header.min[1], header.min[2]};
+	bounds.max = Vec3 {header.max[0], header.max[1], header.max[2]};
+	generated = header.flags & MESH_ASSET_GENERATED;
+}
+
+/**
+ * Computes smooth normals for vertices the file gave none, by accumulating
+ * the area weighted normals of every face using them.
+ */
+void Mesh::computeNormals(const std::vector<bool> &missing)
+{
+	std::vector<Vec3> sum(positions.size(), Vec3 {0.0f, 0.0f, 0.0f});
+
+	for (size_t i {0}; i + 2 < indices.size(); i += 3)
+	{
+		const Vec3 &a {positions[indices[i]]};
+		Vec3 n {Vec3::cross(positions[indices[i + 1]] - a,
+			positions[indices[i + 2]] - a)};
+
+		for (size_t j {0}; j < 3; ++j)
+		{
+			sum[indices[i + j]] = sum[indices[i + j]] + n;
+		}
+	}
+	for (size_t i {0}; i < positions.size(); ++i)
+	{
+		if (missing[i])
+		{
+			Vec3 n {Vec3::normalize(sum[i])};
+
+			attributes[i].normal[0] = n.x;
+			attributes[i].normal[1] = n.y;
+			attributes[i].normal[2] = n.z;
+		}
+	}
+}
+
+/**
+ * Computes the axis aligned bounding box of the positions.
+ */
+void Mesh::computeBounds(void)
+{
+	bounds.min = positions[0];
+	bounds.max = positions[0];
+	growBounds(bounds, positions);
+}
+
+/**
+ * Computes planar texture coordinates for vertices the file gave none, by
+ * projecting positions on the plane of the two largest extents of the bounds.
+ */
+void Mesh::computeTextureCoordinates(const std::vector<bool> &missing)
+{
+	Vec3 size {bounds.max - bounds.min};
+	float extents[3] {size.x, size.y, size.z};
+	int u {0};
+	int v {1};
+
+	if (extents[2] > extents[0] && extents[0] <= extents[1])
+	{
+		u = 2;
+	}
+	else if (extents[2] > extents[1])
+	{
+		v = 2;
+	}
+	for (size_t i {0}; i < positions.size(); ++i)
+	{
+		if (missing[i])
+		{
+			const float p[3] {positions[i].x - bounds.min.x,
+				positions[i].y - bounds.min.y, positions[i].z - bounds.min.z};
+
+			attributes[i].uv[0] = extents[u] > 0.0f ? p[u] / extents[u] : 0.0f;
+			attributes[i].uv[1] = extents[v] > 0.0f ? p[v] / extents[v] : 0.0f;
+		}
+	}
+}
+
+/**
+ * Position stream.
+ */
+const std::vector<Vec3> &Mesh::getPositions(void) const
+{
+	return (positions);
+}
+
+/**
+ * Attribute stream (normals and texture coordinates).
+ */
+const std::vector<Mesh::Attributes> &Mesh::getAttributes(void) const
+{
+	return (attributes);
+}
+
+/**
+ * Triangle list indices.
+ */
+const std::vector<uint32_t> &Mesh::getIndices(void) const
+{
+	return (indices);
+}
+
+/**
+ * Axis aligned bounding box.
+ */
+const Mesh::Bounds &Mesh::getBounds(void) const
+{
+	return (bounds);
+}
+
+/**
+ * Center of the bounding box.
+ */
+Vec3 Mesh::getCenter(void) const
+{
+	return ((bounds.min + bounds.max) * 0.5f);
+}
+
+/**
+ * Radius of the sphere enclosing the bounding box.
+ */
+float Mesh::getRadius(void) const
+{
+	return (Vec3::length(bounds.max - bounds.min) * 0.5f);
+}
+
+/**
+ * Tells if the last load computed normals or texture coordinates the file
+ * lacked, which differ from the ones its chunks carried.
+ */
+bool Mesh::hasGeneratedAttributes(void) const
+{
+	return (generated);
+}
+
+/**
+ * Grows <bounds> to enclose every one of <positions>.
+ */
+void Mesh::growBounds(Bounds &bounds, const std::vector<Vec3> &positions)
+{
+	for (const Vec3 &v : positions)
+	{
+		bounds.min = Vec3 {std::min(bounds.min.x, v.x),
+			std::min(bounds.min.y, v.y), std::min(bounds.min.z, v.z)};
+		bounds.max = Vec3 {std::max(bounds.max.x, v.x),
+			std::max(bounds.max.y, v.y), std::max(bounds.max.z, v.z)};
+	}
+}
+
+/**
+ * Loads an entire file into a string.
+ */
+std::string Mesh::readFile(const std::string &path)
+{
+	std::ifstream file {path, std::ios::ate | std::ios::binary};
+
+	if (!file.is_open())
+	{
+		throw (Error("Mesh::readFile", "failed open file"));
+	}
+
+	std::string data(static_cast<size_t> (file.tellg()), '\0');
+
+	file.seekg(0);
+	file.read(data.data(), data.size());
+	return (data);
+}
+
+/**
+ * Tells if the file at <path> is a binary asset rather than an OBJ file.
+ */
+bool Mesh::isAsset(const std::string &path)
+{
+	std::ifstream file {path, std::ios::binary};
+	char magic[4] {};
+
+	return (file.read(magic, sizeof(magic))
+		&& !std::memcmp(magic, MESH_ASSET_MAGIC, sizeof(magic)));
+}
+
+/**
+ * Skips blanks, not line feeds.
+ */
+const char *Mesh::skipSpaces(const char *p, const char *end)
+{
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+	{
+		++p;
+	}
+	return (p);
+}
+
+/**
+ * Returns the start of the next line.
+ */
+const char *Mesh::nextLine(const char *p, const char *end)
+{
+	const void *lf {p < end ? std::memchr(p, '\n', end - p) : nullptr};
+
+	return (lf ? static_cast<const char *> (lf) + 1 : end);
+}
+
+/**
+ * Parses a decimal float at <p> and advances <p> past it. Digits beyond the
+ * 19th only shift the exponent, the mantissa is scaled by exact powers of ten
+ * so common values are correctly rounded. Throws if there is no number.
+ */
+float Mesh::parseFloat(const char *&p, const char *end)
+{
+	bool negative {false};
+	bool any {false};
+	uint64_t mantissa {0};
+	int digits {0};
+	int exponent {0};
+
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		negative = (*p++ == '-');
+	}
+	for (; p < end && *p >= '0' && *p <= '9'; ++p, any = true)
+	{
+		if (digits < 19)
+		{
+			mantissa = mantissa * 10 + static_cast<uint64_t> (*p - '0');
+			digits += (mantissa != 0);
+		}
+		else
+		{
+			++exponent;
+		}
+	}
+	if (p < end && *p == '.')
+	{
+		for (++p; p < end && *p >= '0' && *p <= '9'; ++p, any = true)
+		{
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + static_cast<uint64_t> (*p - '0');
+				digits += (mantissa != 0);
+				--exponent;
+			}
+		}
+	}
+	if (!any)
+	{
+		throw (Error("Mesh::parseFloat", "invalid number"));
+	}
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		bool negative_exp {false};
+		int e {0};
+
+		++p;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negative_exp = (*p++ == '-');
+		}
+		for (; p < end && *p >= '0' && *p <= '9'; ++p)
+		{
+			e = std::min(e * 10 + (*p - '0'), 1000);
+		}
+		exponent += negative_exp ? -e : e;
+	}
+
+	double value {static_cast<double> (mantissa)};
+
+	for (; exponent < -22; exponent += 22)
+	{
+		value /= pow10_table[22];
+	}
+	for (; exponent > 22; exponent -= 22)
+	{
+		value *= pow10_table[22];
+	}
+	value = exponent < 0 ? value / pow10_table[-exponent]
+		: value * pow10_table[exponent];
+	return (static_cast<float> (negative ? -value : value));
+}
+
+/**
+ * Parses a signed integer at <p>, 0 if there are no digits.
+ */
+static inline int32_t parseIndex(const char *&p, const char *end)
+{
+	bool negative {false};
+	int64_t value {0};
+
+	if (p < end && *p == '-')
+	{
+		negative = true;
+		++p;
+	}
+	for (; p < end && *p >= '0' && *p <= '9'; ++p)
+	{
+		value = std::min<int64_t>(value * 10 + (*p - '0'), INT32_MAX);
+	}
+	return (static_cast<int32_t> (negative ? -value : value));
+}
+
+/**
+ * Parses one face vertex (v, v/vt, v//vn or v/vt/vn) at <p> into <idx> with
+ * the raw OBJ indices, 0 for the absent ones. Returns false at end of line.
+ */
+bool Mesh::parseFaceIndex(const char *&p, const char *end, FaceIndex &idx)
+{
+	if (p >= end || *p == '\n' || *p == '#')
+	{
+		return (false);
+	}
+	idx = FaceIndex {parseIndex(p, end), 0, 0};
+	if (p < end && *p == '/')
+	{
+		++p;
+		idx.vt = parseIndex(p, end);
+		if (p < end && *p == '/')
+		{
+			++p;
+			idx.vn = parseIndex(p, end);
+		}
+	}
+	if (idx.v == 0)
+	{
+		throw (Error("Mesh::parseFaceIndex", "invalid face"));
+	}
+	return (true);
+}
@@ -0,0 +1,611 @@
+#include <MeshOptimizer.hpp>
+
+/**
+ * Compares two quantized vertices.
+ */
+bool MeshOptimizer::VertexKey::operator==(const VertexKey &rhs) const
+{
+	return (low == rhs.low && high == rhs.high);
+}
+
+/**
+ * Mixes the bits of a quantized vertex into a hash.
+ */
+size_t MeshOptimizer::VertexKeyHash::operator()(const VertexKey &key) const
+{
+	uint64_t h {key.low * 0x9E3779B97F4A7C15ull};
+
+	h ^= key.high + 0x7F4A7C159E3779B9ull + (h << 6) + (h >> 2);
+	return (static_cast<size_t> (h));
+}
+
+/**
+ * Default constructor, empty asset.
+ */
+MeshOptimizer::MeshOptimizer(void) :
+	header {},
+	vertices {},
+	lods {},
+	source_vertices {0},
+	source_acmr {0.0f}
+{
+	// Empty;
+}
+
+/**
+ * Optimizes <mesh> into an asset.
+ */
+MeshOptimizer::MeshOptimizer(const Mesh &mesh) : MeshOptimizer()
+{
+	std::vector<uint32_t> indices {mesh.getIndices()};
+
+	source_vertices = mesh.getPositions().size();
+	source_acmr = computeAcmr(indices, source_vertices);
+	quantize(mesh);
+	weld(indices);
+	if (indices.empty())
+	{
+		throw (Error("MeshOptimizer::MeshOptimizer", "only degenerate faces"));
+	}
+	optimizeCache(indices, vertices.size());
+	lods.push_back(Lod {std::move(indices), 0.0f});
+	buildLods();
+	reorderVertices();
+}
+
+/**
+ * Copy constructor.
+ */
+MeshOptimizer::MeshOptimizer(const MeshOptimizer &cpy) :
+	header {cpy.header},
+	vertices {cpy.vertices},
+	lods {cpy.lods},
+	source_vertices {cpy.source_vertices},
+	source_acmr {cpy.source_acmr}
+{
+	// Empty;
+}
+
+/**
+ * Destructor.
+ */
+MeshOptimizer::~MeshOptimizer(void) noexcept
+{
+	// Empty;
+}
+
+/**
+ * Copy assignement operator.
+ */
+MeshOptimizer &MeshOptimizer::operator=(const MeshOptimizer &cpy)
+{
+	header = cpy.header;
+	vertices = cpy.vertices;
+	lods = cpy.lods;
+	source_vertices = cpy.source_vertices;
+	source_acmr = cpy.source_acmr;
+	return (*this);
+}
+
+/**
+ * Fraction of <value> between <min> and <max> on 16 bits, 0 if the range is
+ * empty.
+ */
+static inline uint16_t quantizeUnorm(float value, float min, float max)
+{
+	if (!(max > min))
+	{
+		return (0);
+	}
+	return (static_cast<uint16_t> (std::lround(std::clamp((value - min)
+		/ (max - min), 0.0f, 1.0f) * 65535.0f)));
+}
+
+/**
+ * Signed fraction of <value> on 16 bits.
+ */
+static inline int16_t quantizeSnorm(float value)
+{
+	return (static_cast<int16_t> (std::lround(std::clamp(value, -1.0f, 1.0f)
+		* 32767.0f)));
+}
+
+/**
+ * Fills the header with the bounds of <mesh> and the range of its texture
+ * coordinates, then quantizes its vertices to them.
+ */
+void MeshOptimizer::quantize(const Mesh &mesh)
+{
+	const std::vector<Vec3> &positions {mesh.getPositions()};
+	const std::vector<Mesh::Attributes> &attributes {mesh.getAttributes()};
+	const Mesh::Bounds &bounds {mesh.getBounds()};
+	float far {std::numeric_limits<float>::max()};
+
+	std::memcpy(header.magic, MESH_ASSET_MAGIC, sizeof(header.magic));
+	header.version = MESH_ASSET_VERSION;
+	header.flags = mesh.hasGeneratedAttributes() ? MESH_ASSET_GENERATED : 0;
+	header.min[0] = bounds.min.x;
+	header.min[1] = bounds.min.y;
+	header.min[2] = bounds.min.z;
+	header.max[0] = bounds.max.x;
+	header.max[1] = bounds.max.y;
+	header.max[2] = bounds.max.z;
+	header.uv_min[0] = far;
+	header.uv_min[1] = far;
+	header.uv_max[0] = -far;
+	header.uv_max[1] = -far;
+	for (const Mesh::Attributes &attr : attributes)
+	{
+		for (size_t j {0}; j < 2; ++j)
+		{
+			header.uv_min[j] = std::min(header.uv_min[j], attr.uv[j]);
+			header.uv_max[j] = std::max(header.uv_max[j], attr.uv[j]);
+		}
+	}
+	vertices.resize(positions.size());
+	for (size_t i {0}; i < positions.size(); ++i)
+	{
+		const float p[3] {positions[i].x, positions[i].y, positions[i].z};
+
+		for (size_t j {0}; j < 3; ++j)
+		{
+			vertices[i].position[j] = quantizeUnorm(p[j], header.min[j],
+				header.max[j]);
+			vertices[i].normal[j] = quantizeSnorm(attributes[i].normal[j]);
+		}
+		for (size_t j {0}; j < 2; ++j)
+		{
+			vertices[i].uv[j] = quantizeUnorm(attributes[i].uv[j],
+				header.uv_min[j], header.uv_max[j]);
+		}
+	}
+}
+
+/**
+ * Welds the vertices quantization made identical, drops the triangles of
+ * <indices> left with twice the same vertex, and the vertices no triangle
+ * uses anymore.
+ */
+void MeshOptimizer::weld(std::vector<uint32_t> &indices)
+{
+	std::unordered_map<VertexKey, uint32_t, VertexKeyHash> welded {};
+	std::vector<Mesh::AssetVertex> unique {};
+	std::vector<uint32_t> remap(vertices.size());
+	size_t kept {0};
+
+	welded.reserve(vertices.size());
+	for (size_t i {0}; i < vertices.size(); ++i)
+	{
+		VertexKey key {};
+
+		static_assert(sizeof(key) == sizeof(Mesh::AssetVertex));
+		std::memcpy(&key, &vertices[i], sizeof(key));
+
+		auto [it, inserted] {welded.try_emplace(key,
+			static_cast<uint32_t> (unique.size()))};
+
+		if (inserted)
+		{
+			unique.push_back(vertices[i]);
+		}
+		remap[i] = it->second;
+	}
+	for (size_t i {0}; i + 2 < indices.size(); i += 3)
+	{
+		uint32_t a {remap[indices[i]]};
+		uint32_t b {remap[indices[i + 1]]};
+		uint32_t c {remap[indices[i + 2]]};
+
+		if (a != b && b != c && a != c)
+		{
+			indices[kept++] = a;
+			indices[kept++] = b;
+			indices[kept++] = c;
+		}
+	}
+	indices.resize(kept);
+	vertices.swap(unique);
+}
+
+/**
+ * Simplifies the triangles of <indices> by merging the vertices sharing a
+ * cell of the quantization grid shifted right by <shift> bits into the one
+ * closest to their average. Triangles that collapse or that another one
+ * already covers are dropped.
+ */
+std::vector<uint32_t> MeshOptimizer::cluster(
+	const std::vector<uint32_t> &indices, uint32_t shift) const
+{
+	struct Cell
+	{
+		float sum[3];
+		uint32_t count;
+		uint32_t best;
+		float distance;
+	};
+
+	std::unordered_map<uint64_t, Cell> cells {};
+	std::vector<uint64_t> keys(vertices.size(), UINT64_MAX);
+	std::vector<std::array<uint32_t, 3>> triangles {};
+	std::vector<uint32_t> result {};
+
+	for (uint32_t index : indices)
+	{
+		const uint16_t *p {vertices[index].position};
+
+		if (keys[index] != UINT64_MAX)
+		{
+			continue ;
+		}
+		keys[index] = static_cast<uint64_t> (p[0] >> shift)
+			| static_cast<uint64_t> (p[1] >> shift) << 16
+			| static_cast<uint64_t> (p[2] >> shift) << 32;
+
+		Cell &cell {cells.try_emplace(keys[index], Cell {{0.0f, 0.0f, 0.0f},
+			0, index, std::numeric_limits<float>::max()}).first->second};
+
+		for (size_t j {0}; j < 3; ++j)
+		{
+			cell.sum[j] += p[j];
+		}
+		++cell.count;
+	}
+	for (size_t i {0}; i < vertices.size(); ++i)
+	{
+		if (keys[i] == UINT64_MAX)
+		{
+			continue ;
+		}
+
+		Cell &cell {cells.at(keys[i])};
+		float distance {0.0f};
+
+		for (size_t j {0}; j < 3; ++j)
+		{
+			float d {vertices[i].position[j] - cell.sum[j]
+				/ static_cast<float> (cell.count)};
+
+			distance += d * d;
+		}
+		if (distance < cell.distance)
+		{
+			cell.distance = distance;
+			cell.best = static_cast<uint32_t> (i);
+		}
+	}
+	for (size_t i {0}; i + 2 < indices.size(); i += 3)
+	{
+		std::array<uint32_t, 3> t {cells.at(keys[indices[i]]).best,
+			cells.at(keys[indices[i + 1]]).best,
+			cells.at(keys[indices[i + 2]]).best};
+
+		if (t[0] == t[1] || t[1] == t[2] || t[0] == t[2])
+		{
+			continue ;
+		}
+		std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+		triangles.push_back(t);
+	}
+	std::sort(triangles.begin(), triangles.end());
+	triangles.erase(std::unique(triangles.begin(), triangles.end()),
+		triangles.end());
+	result.reserve(triangles.size() * 3);
+	for (const std::array<uint32_t, 3> &t : triangles)
+	{
+		result.insert(result.end(), t.begin(), t.end());
+	}
+	return (result);
+}
+
+/**
+ * Adds levels of detail of at most MESHOPTIMIZER_LOD_RATIO times the
+ * triangles of the previous one, until MESHOPTIMIZER_MAX_LODS levels or fewer
+ * than MESHOPTIMIZER_MIN_TRIANGLES triangles. The error of a level is the
+ * size of its cells in model units.
+ */
+void MeshOptimizer::buildLods(void)
+{
+	float extent {std::max({header.max[0] - header.min[0],
+		header.max[1] - header.min[1], header.max[2] - header.min[2]})};
+
+	for (uint32_t shift {1}; shift < 16 && lods.size() < MESHOPTIMIZER_MAX_LODS;
+		++shift)
+	{
+		std::vector<uint32_t> indices {cluster(lods[0].indices, shift)};
+
+		if (indices.size() < MESHOPTIMIZER_MIN_TRIANGLES * 3)
+		{
+			break ;
+		}
+		if (static_cast<float> (indices.size()) > MESHOPTIMIZER_LOD_RATIO
+			* static_cast<float> (lods.back().indices.size()))
+		{
+			continue ;
+		}
+		optimizeCache(indices, vertices.size());
+		lods.push_back(Lod {std::move(indices), extent
+			* static_cast<float> (1u << shift) / 65535.0f});
+	}
+}
+
+/**
+ * Renumbers the vertices in the order the full level of detail first uses
+ * them, so that vertex fetches walk memory forward. Every other level uses a
+ * subset of them.
+ */
+void MeshOptimizer::reorderVertices(void)
+{
+	std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+	std::vector<Mesh::AssetVertex> ordered {};
+
+	ordered.reserve(vertices.size());
+	for (uint32_t &index : lods[0].indices)
+	{
+		if (remap[index] == UINT32_MAX)
+		{
+			remap[index] = static_cast<uint32_t> (ordered.size());
+			ordered.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+	for (size_t i {1}; i < lods.size(); ++i)
+	{
+		for (uint32_t &index : lods[i].indices)
+		{
+			index = remap[index];
+		}
+	}
+	vertices.swap(ordered);
+}
+
+/**
+ * Quantized vertices, in the order of the asset.
+ */
+const std::vector<Mesh::AssetVertex> &MeshOptimizer::getVertices(void) const
+{
+	return (vertices);
+}
+
+/**
+ * Levels of detail, the full mesh first.
+ */
+const std::vector<MeshOptimizer::Lod> &MeshOptimizer::getLods(void) const
+{
+	return (lods);
+}
+
+/**
+ * Vertex count of the mesh before optimization.
+ */
+size_t MeshOptimizer::getSourceVertexCount(void) const
+{
+	return (source_vertices);
+}
+
+/**
+ * Average cache miss ratio of the mesh before optimization.
+ */
+float MeshOptimizer::getSourceAcmr(void) const
+{
+	return (source_acmr);
+}
+
+/**
+ * Size of the asset file in bytes.
+ */
+size_t MeshOptimizer::getAssetSize(void) const
+{
+	size_t index_count {0};
+
+	for (const Lod &lod : lods)
+	{
+		index_count += lod.indices.size();
+	}
+	return (sizeof(Mesh::AssetHeader) + lods.size() * sizeof(Mesh::AssetLod)
+		+ vertices.size() * sizeof(Mesh::AssetVertex) + index_count
+		* (vertices.size() <= 65536 ? 2 : 4));
+}
+
+/**
+ * Writes the asset to <path>: header, levels of detail, vertices, and the
+ * indices of every level one after the other. The file is written aside then
+ * renamed, so that readers never see it partially. Returns false on failure.
+ */
+bool MeshOptimizer::write(const std::string &path) const
+{
+	std::string temporary {path + ".tmp"};
+	Mesh::AssetHeader out_header {header};
+	std::vector<Mesh::AssetLod> table {};
+	std::error_code error {};
+
+	out_header.vertex_count = static_cast<uint32_t> (vertices.size());
+	out_header.index_size = vertices.size() <= 65536 ? 2 : 4;
+	out_header.lod_count = static_cast<uint32_t> (lods.size());
+	for (const Lod &lod : lods)
+	{
+		table.push_back(Mesh::AssetLod {out_header.index_count,
+			static_cast<uint32_t> (lod.indices.size()), lod.error});
+		out_header.index_count += static_cast<uint32_t> (lod.indices.size());
+	}
+	{
+		std::ofstream file {temporary, std::ios::binary | std::ios::trunc};
+
+		file.write(reinterpret_cast<const char *> (&out_header),
+			sizeof(out_header));
+		file.write(reinterpret_cast<const char *> (table.data()),
+			static_cast<std::streamsize> (table.size() * sizeof(table[0])));
+		file.write(reinterpret_cast<const char *> (vertices.data()),
+			static_cast<std::streamsize> (vertices.size()
+			* sizeof(vertices[0])));
+		for (const Lod &lod : lods)
+		{
+			for (uint32_t index : lod.indices)
+			{
+				uint16_t narrow {static_cast<uint16_t> (index)};
+
+				file.write(out_header.index_size == 2
+					? reinterpret_cast<const char *> (&narrow)
+					: reinterpret_cast<const char *> (&index),
+					out_header.index_size);
+			}
+		}
+		if (!file)
+		{
+			return (false);
+		}
+	}
+	std::filesystem::rename(temporary, path, error);
+	return (!error);
+}
+
+/**
+ * Picks the vertex to fan around next: the live candidate that stays the
+ * longest in a cache of MESHOPTIMIZER_CACHE entries once its remaining
+ * triangles are emitted, else the last vertex still live of the dead-end
+ * stack, else the next live vertex in input order. Returns UINT32_MAX once
+ * every triangle is emitted.
+ */
+static inline uint32_t nextVertex(const std::vector<uint32_t> &candidates,
+	std::vector<uint32_t> &dead_end, const std::vector<uint32_t> &live,
+	const std::vector<uint32_t> &stamp, uint32_t time, size_t &cursor)
+{
+	uint32_t best {UINT32_MAX};
+	int64_t best_priority {-1};
+
+	for (uint32_t v : candidates)
+	{
+		int64_t age {static_cast<int64_t> (time) - stamp[v]};
+		int64_t priority {0};
+
+		if (!live[v])
+		{
+			continue ;
+		}
+		if (age + 2 * static_cast<int64_t> (live[v]) <= MESHOPTIMIZER_CACHE)
+		{
+			priority = age;
+		}
+		if (priority > best_priority)
+		{
+			best_priority = priority;
+			best = v;
+		}
+	}
+	if (best != UINT32_MAX)
+	{
+		return (best);
+	}
+	while (!dead_end.empty())
+	{
+		uint32_t v {dead_end.back()};
+
+		dead_end.pop_back();
+		if (live[v])
+		{
+			return (v);
+		}
+	}
+	for (; cursor < live.size(); ++cursor)
+	{
+		if (live[cursor])
+		{
+			return (static_cast<uint32_t> (cursor));
+		}
+	}
+	return (UINT32_MAX);
+}
+
+/**
+ * Reorders the triangles of <indices>, using <vertex_count> vertices, for the
+ * post-transform vertex cache with Tipsify: triangles are emitted in fans
+ * around a vertex, the next one chosen among the vertices just emitted so that
+ * it is still cached. Runs in linear time.
+ */
+void MeshOptimizer::optimizeCache(std::vector<uint32_t> &indices,
+	size_t vertex_count)
+{
+	std::vector<uint32_t> live(vertex_count, 0);
+	std::vector<uint32_t> offsets(vertex_count + 1, 0);
+	std::vector<uint32_t> adjacency(indices.size());
+	std::vector<uint32_t> stamp(vertex_count, 0);
+	std::vector<bool> emitted(indices.size() / 3, false);
+	std::vector<uint32_t> candidates {};
+	std::vector<uint32_t> dead_end {};
+	std::vector<uint32_t> result {};
+	uint32_t time {MESHOPTIMIZER_CACHE + 1};
+	size_t cursor {0};
+	uint32_t fanning {indices.empty() ? UINT32_MAX : indices[0]};
+
+	for (uint32_t index : indices)
+	{
+		++live[index];
+	}
+	for (size_t i {0}; i < vertex_count; ++i)
+	{
+		offsets[i + 1] = offsets[i] + live[i];
+	}
+	{
+		std::vector<uint32_t> fill {offsets.begin(), offsets.end() - 1};
+
+		for (size_t i {0}; i < indices.size(); ++i)
+		{
+			adjacency[fill[indices[i]]++] = static_cast<uint32_t> (i / 3);
+		}
+	}
+	result.reserve(indices.size());
+	while (fanning != UINT32_MAX)
+	{
+		candidates.clear();
+		for (uint32_t k {offsets[fanning]}; k < offsets[fanning + 1]; ++k)
+		{
+			uint32_t t {adjacency[k]};
+
+			if (emitted[t])
+			{
+				continue ;
+			}
+			for (size_t j {0}; j < 3; ++j)
+			{
+				uint32_t v {indices[3 * t + j]};
+
+				result.push_back(v);
+				dead_end.push_back(v);
+				candidates.push_back(v);
+				--live[v];
+				if (time - stamp[v] > MESHOPTIMIZER_CACHE)
+				{
+					stamp[v] = time++;
+				}
+			}
+			emitted[t] = true;
+		}
+		fanning = nextVertex(candidates, dead_end, live, stamp, time, cursor);
+	}
+	indices.swap(result);
+}
+
+/**
+ * Average cache miss ratio of <indices> using <vertex_count> vertices: vertex
+ * shader invocations per triangle with a first in first out cache of
+ * MESHOPTIMIZER_CACHE entries.
+ */
+float MeshOptimizer::computeAcmr(const std::vector<uint32_t> &indices,
+	size_t vertex_count)
+{
+	std::vector<uint32_t> entered(vertex_count, 0);
+	uint32_t misses {0};
+
+	if (indices.size() < 3)
+	{
+		return (0.0f);
+	}
+	for (uint32_t index : indices)
+	{
+		if (!entered[index] || misses - entered[index] >= MESHOPTIMIZER_CACHE)
+		{
+			entered[index] = ++misses;
+		}
+	}
+	return (static_cast<float> (misses)
+		/ static_cast<float> (indices.size() / 3));
+}
@@ -0,0 +1,288 @@
+#include <Options.hpp>
+
+/**
+ * Default settings.
+ */
+Options::Options(void) :
+	on_demand {false},
+	target_fps {0.0},
+	report {false},
+	depth_prepass {false},
+	model {SCOP_DEFAULT_MODEL},
+	texture {},
+	gpu_mips {false},
+	compress {true},
+	compress_mode {BlockCompressor::FAST},
+	device {},
+	device_benchmark {false},
+	startup_trace {},
+	shaders {},
+	render_pass {false},
+	budget {0},
+	record {},
+	replay {},
+	software {false},
+	capture {}
+{
+	// Empty;
+}
+
+/**
+ * Default settings overridden by the SCOP_DEVICE and SCOP_SHADERS environment
+ * variables, then by the command line arguments. An argument that isn't an
+ * option names the model to display. Throws on an unknown argument.
+ */
+Options::Options(int argc, char **argv) : Options()
+{
+	if (const char *env {std::getenv("SCOP_DEVICE")})
+	{
+		device = env;
+	}
+	if (const char *env {std::getenv("SCOP_SHADERS")})
+	{
+		shaders = env;
+	}
+	for (int i {1}; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--on-demand"))
+		{
+			on_demand = true;
+		}
+		else if (!strcmp(argv[i], "--fps"))
+		{
+			target_fps = toNumber(nextValue(argc, argv, i));
+			if (target_fps < OPTIONS_MIN_FPS)
+			{
+				throw (Error("Options::Options", "--fps too low"));
+			}
+		}
+		else if (!strcmp(argv[i], "--report"))
+		{
+			report = true;
+		}
+		else if (!strcmp(argv[i], "--depth-prepass"))
+		{
+			depth_prepass = true;
+		}
+		else if (!strcmp(argv[i], "--texture"))
+		{
+			texture = nextValue(argc, argv, i);
+		}
+		else if (!strcmp(argv[i], "--gpu-mips"))
+		{
+			gpu_mips = true;
+		}
+		else if (!strcmp(argv[i], "--bc"))
+		{
+			parseCompression(nextValue(argc, argv, i));
+		}
+		else if (!strcmp(argv[i], "--device"))
+		{
+			device = nextValue(argc, argv, i);
+		}
+		else if (!strcmp(argv[i], "--device-benchmark"))
+		{
+			device_benchmark = true;
+		}
+		else if (!strcmp(argv[i], "--startup-trace"))
+		{
+			startup_trace = nextValue(argc, argv, i);
+		}
+		else if (!strcmp(argv[i], "--shaders"))
+		{
+			shaders = nextValue(argc, argv, i);
+		}
+		else if (!strcmp(argv[i], "--render-pass"))
+		{
+			render_pass = true;
+		}
+		else if (!strcmp(argv[i], "--budget"))
+		{
+			double mib {toNumber(nextValue(argc, argv, i))};
+
+			if (mib < 1.0 || mib > OPTIONS_MAX_BUDGET
+				|| mib != std::floor(mib))
+			{
+				throw (Error("Options::Options", "invalid --budget"));
+			}
+			budget = static_cast<uint64_t> (mib);
+		}
+		else if (!strcmp(argv[i], "--record"))
+		{
+			record = nextValue(argc, argv, i);
+		}
+		else if (!strcmp(argv[i], "--replay"))
+		{
+			replay = nextValue(argc, argv, i);
+		}
+		else if (!strcmp(argv[i], "--cpu"))
+		{
+			software = true;
+		}
+		else if (!strcmp(argv[i], "--capture"))
+		{
+			capture = nextValue(argc, argv, i);
+		}
+		else if (strncmp(argv[i], "--", 2))
+		{
+			model = argv[i];
+		}
+		else
+		{
+			usage(argv[0]);
+			throw (Error("Options::Options", "unknown argument"));
+		}
+	}
+}
+
+/**
+ * Copy constructor.
+ */
+Options::Options(const Options &cpy) :
+	on_demand {cpy.on_demand},
+	target_fps {cpy.target_fps},
+	report {cpy.report},
+	depth_prepass {cpy.depth_prepass},
+	model {cpy.model},
+	texture {cpy.texture},
+	gpu_mips {cpy.gpu_mips},
+	compress {cpy.compress},
+	compress_mode {cpy.compress_mode},
+	device {cpy.device},
+	device_benchmark {cpy.device_benchmark},
+	startup_trace {cpy.startup_trace},
+	shaders {cpy.shaders},
+	render_pass {cpy.render_pass},
+	budget {cpy.budget},
+	record {cpy.record},
+	replay {cpy.replay},
+	software {cpy.software},
+	capture {cpy.capture}
+{
+	// Empty;
+}
+
+/**
+ * Destructor.
+ */
+Options::~Options(void) noexcept
+{
+	// Empty;
+}
+
+/**
+ * Copy assignement operator.
+ */
+Options &Options::operator=(const Options &cpy)
+{
+	on_demand = cpy.on_demand;
+	target_fps = cpy.target_fps;
+	report = cpy.report;
+	depth_prepass = cpy.depth_prepass;
+	model = cpy.model;
+	texture = cpy.texture;
+	gpu_mips = cpy.gpu_mips;
+	compress = cpy.compress;
+	compress_mode = cpy.compress_mode;
+	device = cpy.device;
+	device_benchmark = cpy.device_benchmark;
+	startup_trace = cpy.startup_trace;
+	shaders = cpy.shaders;
+	render_pass = cpy.render_pass;
+	budget = cpy.budget;
+	record = cpy.record;
+	replay = cpy.replay;
+	software = cpy.software;
+	capture = cpy.capture;
+	return (*this);
+}
+
+/**
+ * Prints the available arguments on the error output.
+ */
+void Options::usage(const char *name)
+{
+	std::cerr << "usage: " << name << " [options] [model.obj|model.scma]"
+		<< std::endl;
+	std::cerr << "\t--on-demand\tdraw only when the scene changes" << std::endl;
+	std::cerr << "\t--fps <n>\tpace frames to n per second, at least 1"
+		<< std::endl;
+	std::cerr << "\t--report\tprint latency and frame times" << std::endl;
+	std::cerr << "\t--depth-prepass\tlay depth down before shading"
+		<< std::endl;
+	std::cerr << "\t--texture <file>\tBMP, TGA or PPM texture" << std::endl;
+	std::cerr << "\t--gpu-mips\tgenerate mipmaps with GPU blits" << std::endl;
+	std::cerr << "\t--bc <off|fast|quality>\tblock compress textures"
+		<< std::endl;
+	std::cerr << "\t--device <index|name|uuid>\tGPU to use (or SCOP_DEVICE)"
+		<< std::endl;
+	std::cerr << "\t--device-benchmark\tpick the fastest GPU, cached"
+		<< std::endl;
+	std::cerr << "\t--startup-trace <file>\twrite a Chrome trace of startup"
+		<< std::endl;
+	std::cerr << "\t--shaders <dir>\tload .spv files over the built-in ones"
+		<< std::endl;
+	std::cerr << "\t--render-pass\tdon't use dynamic rendering" << std::endl;
+	std::cerr << "\t--budget <MiB>\tcap the device local memory budget, in"
+		" whole MiB from 1 to " << OPTIONS_MAX_BUDGET << std::endl;
+	std::cerr << "\t--record <file>\trecord the input of the session"
+		<< std::endl;
+	std::cerr << "\t--replay <file>\treplay a recorded input at a fixed step"
+		<< std::endl;
+	std::cerr << "\t--cpu\trender on the CPU (default without a Vulkan GPU)"
+		<< std::endl;
+	std::cerr << "\t--capture <prefix>\twrite every frame to <prefix>N.ppm"
+		<< std::endl;
+}
+
+/**
+ * Sets the texture block compression from <value>: off, fast or quality.
+ * Throws on anything else.
+ */
+void Options::parseCompression(const char *value)
+{
+	compress = strcmp(value, "off");
+	if (!strcmp(value, "fast"))
+	{
+		compress_mode = BlockCompressor::FAST;
+	}
+	else if (!strcmp(value, "quality"))
+	{
+		compress_mode = BlockCompressor::QUALITY;
+	}
+	else if (compress)
+	{
+		throw (Error("Options::parseCompression", "invalid compression"));
+	}
+}
+
+/**
+ * Returns the value following the argument at <i> and advances <i>. Throws if
+ * there is none.
+ */
+const char *Options::nextValue(int argc, char **argv, int &i)
+{
+	if (i + 1 >= argc)
+	{
+		usage(argv[0]);
+		throw (Error("Options::nextValue", "missing argument value"));
+	}
+	return (argv[++i]);
+}
+
+/**
+ * Converts <value> to a finite positive number or zero. Throws if it isn't
+ * one, strtod also reads nan and inf.
+ */
+double Options::toNumber(const char *value)
+{
+	char *end {nullptr};
+	double number {std::strtod(value, &end)};
+
+	if (end == value || *end != '\0' || !std::isfinite(number)
+		|| number < 0.0)
+	{
+		throw (Error("Options::toNumber", "invalid number"));
+	}
+	return (number);
+}
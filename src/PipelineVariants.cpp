@@ -0,0 +1,152 @@
+#include <PipelineVariants.hpp>
+
+/**
+ * Variants of no device.
+ */
+PipelineVariants::PipelineVariants(void) :
+	PipelineVariants(VK_NULL_HANDLE, nullptr, nullptr)
+{
+	// Empty;
+}
+
+/**
+ * Variants of <device>, each compiled by <build> on first use and destroyed
+ * with <allocator>.
+ */
+PipelineVariants::PipelineVariants(VkDevice device,
+	const VkAllocationCallbacks *allocator, Builder build) :
+	device {device},
+	allocator {allocator},
+	build {std::move(build)},
+	pipelines {},
+	mutex {},
+	compile_ms {0.0}
+{
+	// Empty;
+}
+
+/**
+ * Copy constructor, only the device and the builder are copied since the
+ * pipelines belong to their cache.
+ */
+PipelineVariants::PipelineVariants(const PipelineVariants &cpy) :
+	PipelineVariants(cpy.device, cpy.allocator, cpy.build)
+{
+	// Empty;
+}
+
+/**
+ * Destructor, the pipelines must have been cleared while the device exists.
+ */
+PipelineVariants::~PipelineVariants(void) noexcept
+{
+	// Empty;
+}
+
+/**
+ * Copy assignement operator, only the device and the builder are copied.
+ * The pipelines compiled so far must have been cleared.
+ */
+PipelineVariants &PipelineVariants::operator=(const PipelineVariants &cpy)
+{
+	std::lock_guard<std::mutex> lock {mutex};
+
+	if (!pipelines.empty())
+	{
+		throw (Error("PipelineVariants::operator=", "pipelines not cleared"));
+	}
+	device = cpy.device;
+	allocator = cpy.allocator;
+	build = cpy.build;
+	compile_ms = 0.0;
+	return (*this);
+}
+
+/**
+ * Packs <key> into a word: 1 bit of vertex layout, 2 of shading, 2 of cull
+ * mode, 1 of blending, 3 of log2 sample count and 1 of depth test. Distinct
+ * states never share a key.
+ */
+uint32_t PipelineVariants::hash(const Key &key)
+{
+	uint32_t samples {0};
+
+	while ((1u << samples) < static_cast<uint32_t> (key.samples))
+	{
+		++samples;
+	}
+	return (static_cast<uint32_t> (key.layout)
+		| static_cast<uint32_t> (key.shading) << 1
+		| (key.cull & VK_CULL_MODE_FRONT_AND_BACK) << 3
+		| static_cast<uint32_t> (key.blend) << 5
+		| samples << 6
+		| static_cast<uint32_t> (key.depth) << 9);
+}
+
+/**
+ * Returns the pipeline of <key>, compiled now if it is the first use. The
+ * lock isn't held while compiling so that distinct variants compile in
+ * parallel; if the same one raced, the duplicate is destroyed.
+ */
+VkPipeline PipelineVariants::get(const Key &key)
+{
+	uint32_t id {hash(key)};
+
+	{
+		std::lock_guard<std::mutex> lock {mutex};
+		auto it {pipelines.find(id)};
+
+		if (it != pipelines.end())
+		{
+			return (it->second);
+		}
+	}
+
+	std::chrono::steady_clock::time_point start {
+		std::chrono::steady_clock::now()};
+	VkPipeline pipeline {build(key)};
+	std::lock_guard<std::mutex> lock {mutex};
+	auto [it, inserted] {pipelines.emplace(id, pipeline)};
+
+	if (!inserted)
+	{
+		vkDestroyPipeline(device, pipeline, allocator);
+	}
+	compile_ms += std::chrono::duration<double, std::milli> (
+		std::chrono::steady_clock::now() - start).count();
+	return (it->second);
+}
+
+/**
+ * Destroys every compiled pipeline.
+ */
+void PipelineVariants::clear(void)
+{
+	std::lock_guard<std::mutex> lock {mutex};
+
+	for (const auto &[id, pipeline] : pipelines)
+	{
+		vkDestroyPipeline(device, pipeline, allocator);
+	}
+	pipelines.clear();
+}
+
+/**
+ * Number of compiled pipelines.
+ */
+size_t PipelineVariants::size(void)
+{
+	std::lock_guard<std::mutex> lock {mutex};
+
+	return (pipelines.size());
+}
+
+/**
+ * Total time spent compiling pipelines, in milliseconds.
+ */
+double PipelineVariants::getCompileTime(void)
+{
+	std::lock_guard<std::mutex> lock {mutex};
+
+	return (compile_ms);
+}
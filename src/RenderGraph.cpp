@@ -0,0 +1,684 @@
+#include <RenderGraph.hpp>
+
+/**
+ * Write bits of <access>, the only ones a barrier has to make available.
+ */
+static inline VkAccessFlags2KHR writes(VkAccessFlags2KHR access)
+{
+	return (access & (VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR
+		| VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR
+		| VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR));
+}
+
+/**
+ * Graph of no device.
+ */
+RenderGraph::RenderGraph(void) :
+	RenderGraph(VK_NULL_HANDLE, nullptr, nullptr, nullptr)
+{
+	// Empty;
+}
+
+/**
+ * Empty graph creating its transients on <device> with <allocator>, their
+ * memory coming from <memory_budget>. Barriers are recorded with
+ * <pipeline_barrier2> when VK_KHR_synchronization2 is enabled, with
+ * vkCmdPipelineBarrier if it is null.
+ */
+RenderGraph::RenderGraph(VkDevice device,
+	const VkAllocationCallbacks *allocator, MemoryBudget *memory_budget,
+	PFN_vkCmdPipelineBarrier2KHR pipeline_barrier2) :
+	device {device},
+	allocator {allocator},
+	memory_budget {memory_budget},
+	pipeline_barrier2 {pipeline_barrier2},
+	resources {},
+	passes {},
+	order {},
+	barriers {},
+	exports {},
+	blocks {},
+	unaliased_size {0}
+{
+	// Empty;
+}
+
+/**
+ * Copy constructor, only the device is copied since the resources and passes
+ * belong to their graph.
+ */
+RenderGraph::RenderGraph(const RenderGraph &cpy) :
+	RenderGraph(cpy.device, cpy.allocator, cpy.memory_budget,
+		cpy.pipeline_barrier2)
+{
+	// Empty;
+}
+
+/**
+ * Destructor, the transients must have been released while the device exists.
+ */
+RenderGraph::~RenderGraph(void) noexcept
+{
+	// Empty;
+}
+
+/**
+ * Copy assignement operator, only the device is copied and the graph is left
+ * empty. Its transients must have been released.
+ */
+RenderGraph &RenderGraph::operator=(const RenderGraph &cpy)
+{
+	if (!blocks.empty())
+	{
+		throw (Error("RenderGraph::operator=", "transients not released"));
+	}
+	device = cpy.device;
+	allocator = cpy.allocator;
+	memory_budget = cpy.memory_budget;
+	pipeline_barrier2 = cpy.pipeline_barrier2;
+	resources.clear();
+	passes.clear();
+	order.clear();
+	barriers.clear();
+	exports.clear();
+	unaliased_size = 0;
+	return (*this);
+}
+
+/**
+ * Imports <images> and their <views> of <format>, one per swapchain image,
+ * left in the state of <final> at the end of the frame. Returns the resource.
+ */
+size_t RenderGraph::importImages(const std::string &name, VkFormat format,
+	VkImageAspectFlags aspect, const std::vector<VkImage> &images,
+	const std::vector<VkImageView> &views, Access final)
+{
+	resources.push_back(Resource {
+		.name = name,
+		.format = format,
+		.aspect = aspect,
+		.transient = false,
+		.exported = true,
+		.final = final,
+		.images = images,
+		.views = views,
+		.usage = 0,
+		.first = SIZE_MAX,
+		.last = 0,
+		.block = SIZE_MAX
+	});
+	return (resources.size() - 1);
+}
+
+/**
+ * Declares an image of <format> the size of the frame, created by the graph
+ * and only valid during it. Returns the resource.
+ */
+size_t RenderGraph::addTransient(const std::string &name, VkFormat format,
+	VkImageAspectFlags aspect)
+{
+	resources.push_back(Resource {
+		.name = name,
+		.format = format,
+		.aspect = aspect,
+		.transient = true,
+		.exported = false,
+		.final = ACCESS_COUNT,
+		.images = {},
+		.views = {},
+		.usage = 0,
+		.first = SIZE_MAX,
+		.last = 0,
+		.block = SIZE_MAX
+	});
+	return (resources.size() - 1);
+}
+
+/**
+ * Declares a pass using each resource of <uses> once, recorded by <record>
+ * with the command buffer and swapchain image index. Passes run in the order
+ * they are added. A pass with <side_effects> is never culled.
+ */
+void RenderGraph::addPass(const std::string &name,
+	const std::vector<Use> &uses, Record record, bool side_effects)
+{
+	for (size_t i {0}; i < uses.size(); ++i)
+	{
+		if (uses[i].resource >= resources.size())
+		{
+			throw (Error("RenderGraph::addPass", "unknown resource"));
+		}
+		for (size_t j {0}; j < i; ++j)
+		{
+			if (uses[j].resource == uses[i].resource)
+			{
+				throw (Error("RenderGraph::addPass", "resource used twice"));
+			}
+		}
+	}
+	passes.push_back(Pass {name, uses, record, side_effects});
+}
+
+/**
+ * Stages, accesses and layout of an image used for <access>.
+ */
+RenderGraph::State RenderGraph::getState(Access access)
+{
+	switch (access)
+	{
+		case COLOR_WRITE:
+			return (State {VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR,
+				VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT_KHR
+				| VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR,
+				VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+		case DEPTH_WRITE:
+			return (State {VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR
+				| VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR,
+				VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR
+				| VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR,
+				VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL});
+		case DEPTH_READ:
+			return (State {VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR
+				| VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR,
+				VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR,
+				VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL});
+		case SAMPLED:
+			return (State {VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR,
+				VK_ACCESS_2_SHADER_READ_BIT_KHR,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL});
+		case TRANSFER_SRC:
+			return (State {VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR,
+				VK_ACCESS_2_TRANSFER_READ_BIT_KHR,
+				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL});
+		case TRANSFER_DST:
+			return (State {VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR,
+				VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL});
+		default:
+			return (State {VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT_KHR,
+				VK_ACCESS_2_NONE_KHR, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR});
+	}
+}
+
+/**
+ * Usage an image needs to be used for <access>.
+ */
+VkImageUsageFlags RenderGraph::getUsage(Access access)
+{
+	switch (access)
+	{
+		case COLOR_WRITE:
+			return (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+		case DEPTH_WRITE:
+		case DEPTH_READ:
+			return (VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
+		case SAMPLED:
+			return (VK_IMAGE_USAGE_SAMPLED_BIT);
+		case TRANSFER_SRC:
+			return (VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+		case TRANSFER_DST:
+			return (VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+		default:
+			return (0);
+	}
+}
+
+/**
+ * Tells if going from <src> to <dst> needs a barrier: the layout changes or
+ * either side writes. Reads following reads in the same layout don't.
+ */
+bool RenderGraph::needsBarrier(const State &src, const State &dst)
+{
+	return (src.layout != dst.layout || writes(src.access)
+		|| writes(dst.access));
+}
+
+/**
+ * Tells which passes contribute to an exported resource, walking back from the
+ * last one: a pass is kept if it has side effects or writes a resource needed
+ * after it, and then everything it uses is needed too.
+ */
+std::vector<bool> RenderGraph::cull(void) const
+{
+	std::vector<bool> alive(passes.size(), false);
+	std::vector<bool> needed(resources.size(), false);
+
+	for (size_t i {0}; i < resources.size(); ++i)
+	{
+		needed[i] = resources[i].exported;
+	}
+	for (size_t i {passes.size()}; i-- > 0;)
+	{
+		alive[i] = passes[i].side_effects;
+		for (const Use &use : passes[i].uses)
+		{
+			if (needed[use.resource] && writes(getState(use.access).access))
+			{
+				alive[i] = true;
+			}
+		}
+		if (!alive[i])
+		{
+			continue ;
+		}
+		for (const Use &use : passes[i].uses)
+		{
+			needed[use.resource] = true;
+		}
+	}
+	return (alive);
+}
+
+/**
+ * Creates the transients used by the kept passes at <extent>. Each one goes to
+ * the first memory block whose occupants are all done before its first use,
+ * so that images living in different passes share their memory.
+ */
+void RenderGraph::allocateTransients(VkExtent2D extent)
+{
+	std::vector<size_t> transients {};
+
+	for (size_t i {0}; i < resources.size(); ++i)
+	{
+		if (resources[i].transient && resources[i].first != SIZE_MAX)
+		{
+			transients.push_back(i);
+		}
+	}
+	std::sort(transients.begin(), transients.end(), [this](size_t a, size_t b)
+		{
+			return (resources[a].first < resources[b].first);
+		});
+	unaliased_size = 0;
+	for (size_t id : transients)
+	{
+		Resource &resource {resources[id]};
+		VkImageCreateInfo create_info {};
+		VkMemoryRequirements requirements {};
+		VkImage image {VK_NULL_HANDLE};
+		size_t b {0};
+
+		create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		create_info.imageType = VK_IMAGE_TYPE_2D;
+		create_info.format = resource.format;
+		create_info.extent = {extent.width, extent.height, 1};
+		create_info.mipLevels = 1;
+		create_info.arrayLayers = 1;
+		create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+		create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+		create_info.usage = resource.usage;
+		create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		if (vkCreateImage(device, &create_info, allocator, &image)
+			!= VK_SUCCESS)
+		{
+			throw (Error("RenderGraph::allocateTransients",
+				"failed to create transient image"));
+		}
+		resource.images.assign(1, image);
+		vkGetImageMemoryRequirements(device, image, &requirements);
+		unaliased_size += requirements.size;
+		while (b < blocks.size() && (resources[blocks[b].resources.back()].last
+			>= resource.first || !(blocks[b].requirements.memoryTypeBits
+			& requirements.memoryTypeBits)))
+		{
+			++b;
+		}
+		if (b == blocks.size())
+		{
+			blocks.push_back(Block {requirements, VK_NULL_HANDLE, {}});
+		}
+		else
+		{
+			VkMemoryRequirements &shared {blocks[b].requirements};
+
+			shared.size = std::max(shared.size, requirements.size);
+			shared.alignment = std::max(shared.alignment,
+				requirements.alignment);
+			shared.memoryTypeBits &= requirements.memoryTypeBits;
+		}
+		blocks[b].resources.push_back(id);
+		resource.block = b;
+	}
+	for (Block &block : blocks)
+	{
+		if (memory_budget->allocate(block.requirements,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, block.memory) != VK_SUCCESS)
+		{
+			throw (Error("RenderGraph::allocateTransients",
+				"failed to allocate transient memory"));
+		}
+		for (size_t id : block.resources)
+		{
+			Resource &resource {resources[id]};
+			VkImageViewCreateInfo view_info {};
+			VkImageView view {VK_NULL_HANDLE};
+
+			vkBindImageMemory(device, resource.images[0], block.memory, 0);
+			view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			view_info.image = resource.images[0];
+			view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			view_info.format = resource.format;
+			view_info.subresourceRange = {resource.aspect, 0, 1, 0, 1};
+			if (vkCreateImageView(device, &view_info, allocator, &view)
+				!= VK_SUCCESS)
+			{
+				throw (Error("RenderGraph::allocateTransients",
+					"failed to create transient view"));
+			}
+			resource.views.assign(1, view);
+		}
+	}
+}
+
+/**
+ * Follows every resource through the kept passes and records a transition
+ * before each use that changes its layout or touches a write. Reads in the
+ * same layout merge into one state so that the next write waits for all of
+ * them. Imported images start undefined, a transient starts where the previous
+ * occupant of its memory ends, in this frame or the one before.
+ */
+void RenderGraph::createTransitions(void)
+{
+	std::vector<State> ends(resources.size(), State {
+		VK_PIPELINE_STAGE_2_NONE_KHR, VK_ACCESS_2_NONE_KHR,
+		VK_IMAGE_LAYOUT_UNDEFINED});
+	auto advance {[](State &state, const State &next)
+		{
+			if (needsBarrier(state, next))
+			{
+				state = next;
+				return (true);
+			}
+			state.stage |= next.stage;
+			state.access |= next.access;
+			return (false);
+		}};
+
+	for (size_t index : order)
+	{
+		for (const Use &use : passes[index].uses)
+		{
+			advance(ends[use.resource], getState(use.access));
+		}
+	}
+
+	std::vector<State> states(resources.size());
+
+	for (size_t i {0}; i < resources.size(); ++i)
+	{
+		const Resource &resource {resources[i]};
+
+		if (resource.first == SIZE_MAX)
+		{
+			continue ;
+		}
+		states[i].layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		states[i].access = VK_ACCESS_2_NONE_KHR;
+		if (!resource.transient)
+		{
+			const Pass &pass {passes[order[resource.first]]};
+
+			for (const Use &use : pass.uses)
+			{
+				if (use.resource == i)
+				{
+					states[i].stage = getState(use.access).stage;
+				}
+			}
+			continue ;
+		}
+
+		const std::vector<size_t> &occupants {blocks[resource.block]
+			.resources};
+		size_t slot {static_cast<size_t> (std::find(occupants.begin(),
+			occupants.end(), i) - occupants.begin())};
+		const State &previous {ends[occupants[(slot + occupants.size() - 1)
+			% occupants.size()]]};
+
+		states[i].stage = previous.stage;
+		states[i].access = previous.access;
+	}
+	barriers.assign(order.size(), {});
+	for (size_t k {0}; k < order.size(); ++k)
+	{
+		for (const Use &use : passes[order[k]].uses)
+		{
+			State src {states[use.resource]};
+			State dst {getState(use.access)};
+
+			if (advance(states[use.resource], dst))
+			{
+				barriers[k].push_back(Transition {use.resource, src, dst});
+			}
+		}
+	}
+	exports.clear();
+	for (size_t i {0}; i < resources.size(); ++i)
+	{
+		State dst {getState(resources[i].final)};
+
+		if (resources[i].exported && resources[i].first != SIZE_MAX
+			&& needsBarrier(states[i], dst))
+		{
+			exports.push_back(Transition {i, states[i], dst});
+		}
+	}
+}
+
+/**
+ * Culls the passes, creates the transients at <extent> and derives the
+ * barriers of the frame. Called once per swapchain, after every declaration.
+ */
+void RenderGraph::compile(VkExtent2D extent)
+{
+	std::vector<bool> alive {cull()};
+
+	order.clear();
+	for (size_t i {0}; i < passes.size(); ++i)
+	{
+		if (alive[i])
+		{
+			order.push_back(i);
+		}
+	}
+	for (Resource &resource : resources)
+	{
+		resource.first = SIZE_MAX;
+		resource.last = 0;
+		resource.usage = 0;
+	}
+	for (size_t k {0}; k < order.size(); ++k)
+	{
+		for (const Use &use : passes[order[k]].uses)
+		{
+			Resource &resource {resources[use.resource]};
+
+			resource.first = std::min(resource.first, k);
+			resource.last = k;
+			resource.usage |= getUsage(use.access);
+		}
+	}
+	allocateTransients(extent);
+	createTransitions();
+}
+
+/**
+ * Records <transitions> into <buf> as a single barrier, on the images of
+ * swapchain image <index>. Without VK_KHR_synchronization2 the stages of
+ * every transition are merged into one vkCmdPipelineBarrier.
+ */
+void RenderGraph::emit(VkCommandBuffer buf, uint32_t index,
+	const std::vector<Transition> &transitions) const
+{
+	std::vector<VkImageMemoryBarrier2KHR> image_barriers(transitions.size());
+
+	if (transitions.empty())
+	{
+		return ;
+	}
+	for (size_t i {0}; i < transitions.size(); ++i)
+	{
+		const Transition &transition {transitions[i]};
+		const Resource &resource {resources[transition.resource]};
+		VkImageMemoryBarrier2KHR &barrier {image_barriers[i]};
+
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+		barrier.srcStageMask = transition.src.stage;
+		barrier.srcAccessMask = writes(transition.src.access);
+		barrier.dstStageMask = transition.dst.stage;
+		barrier.dstAccessMask = transition.dst.access;
+		barrier.oldLayout = transition.src.layout;
+		barrier.newLayout = transition.dst.layout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = resource.images[resource.transient ? 0 : index];
+		barrier.subresourceRange = {resource.aspect, 0,
+			VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+	}
+	if (pipeline_barrier2)
+	{
+		VkDependencyInfoKHR dependency {};
+
+		dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+		dependency.imageMemoryBarrierCount = image_barriers.size();
+		dependency.pImageMemoryBarriers = image_barriers.data();
+		pipeline_barrier2(buf, &dependency);
+		return ;
+	}
+
+	std::vector<VkImageMemoryBarrier> legacy(image_barriers.size());
+	VkPipelineStageFlags src_stages {0};
+	VkPipelineStageFlags dst_stages {0};
+
+	for (size_t i {0}; i < image_barriers.size(); ++i)
+	{
+		const VkImageMemoryBarrier2KHR &barrier {image_barriers[i]};
+
+		legacy[i].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		legacy[i].srcAccessMask = static_cast<VkAccessFlags> (
+			barrier.srcAccessMask);
+		legacy[i].dstAccessMask = static_cast<VkAccessFlags> (
+			barrier.dstAccessMask);
+		legacy[i].oldLayout = barrier.oldLayout;
+		legacy[i].newLayout = barrier.newLayout;
+		legacy[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		legacy[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		legacy[i].image = barrier.image;
+		legacy[i].subresourceRange = barrier.subresourceRange;
+		src_stages |= static_cast<VkPipelineStageFlags> (barrier.srcStageMask);
+		dst_stages |= static_cast<VkPipelineStageFlags> (barrier.dstStageMask);
+	}
+	if (!src_stages)
+	{
+		src_stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+	}
+	if (!dst_stages)
+	{
+		dst_stages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+	}
+	vkCmdPipelineBarrier(buf, src_stages, dst_stages, 0, 0, nullptr, 0,
+		nullptr, legacy.size(), legacy.data());
+}
+
+/**
+ * Records the kept passes into <buf> for swapchain image <index>, each behind
+ * its barrier, then moves the exported images to their final state.
+ */
+void RenderGraph::execute(VkCommandBuffer buf, uint32_t index) const
+{
+	for (size_t k {0}; k < order.size(); ++k)
+	{
+		emit(buf, index, barriers[k]);
+		passes[order[k]].record(buf, index);
+	}
+	emit(buf, index, exports);
+}
+
+/**
+ * View of <resource> for swapchain image <index>, transients have only one.
+ */
+VkImageView RenderGraph::getView(size_t resource, uint32_t index) const
+{
+	const Resource &r {resources.at(resource)};
+
+	return (r.views.at(r.transient ? 0 : index));
+}
+
+/**
+ * Hands the transients over to the returned function, which destroys them
+ * once the GPU is done with them. Their memory stops counting against the
+ * budget right away. The graph is left empty.
+ */
+std::function<void(void)> RenderGraph::release(void)
+{
+	std::vector<VkImageView> views {};
+	std::vector<VkImage> images {};
+	std::vector<VkDeviceMemory> memories {};
+
+	for (Resource &resource : resources)
+	{
+		if (resource.transient)
+		{
+			views.insert(views.end(), resource.views.begin(),
+				resource.views.end());
+			images.insert(images.end(), resource.images.begin(),
+				resource.images.end());
+		}
+	}
+	for (const Block &block : blocks)
+	{
+		memories.push_back(block.memory);
+		if (memory_budget)
+		{
+			memory_budget->retire(block.memory);
+		}
+	}
+	blocks.clear();
+	resources.clear();
+	passes.clear();
+	order.clear();
+	barriers.clear();
+	exports.clear();
+	return ([device = device, allocator = allocator,
+		memory_budget = memory_budget, views, images, memories](void)
+		{
+			for (VkImageView view : views)
+			{
+				vkDestroyImageView(device, view, allocator);
+			}
+			for (VkImage image : images)
+			{
+				vkDestroyImage(device, image, allocator);
+			}
+			for (VkDeviceMemory memory : memories)
+			{
+				memory_budget->free(memory);
+			}
+		});
+}
+
+/**
+ * Writes the kept passes with their barrier count, and the memory of the
+ * transients against what it would be without aliasing, in KiB.
+ */
+void RenderGraph::writeSummary(std::ostream &out) const
+{
+	VkDeviceSize aliased_size {0};
+
+	for (const Block &block : blocks)
+	{
+		aliased_size += block.requirements.size;
+	}
+	out << "render graph: " << order.size() << "/" << passes.size()
+		<< " passes kept" << std::endl;
+	for (size_t k {0}; k < order.size(); ++k)
+	{
+		out << std::setw(6) << barriers[k].size() << " barriers  "
+			<< passes[order[k]].name << std::endl;
+	}
+	out << std::setw(6) << exports.size() << " barriers  exports" << std::endl
+		<< "transients: " << (aliased_size >> 10) << " KiB in "
+		<< blocks.size() << " blocks, " << (unaliased_size >> 10)
+		<< " KiB unaliased" << std::endl;
+}
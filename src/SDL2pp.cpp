@@ -102,6 +102,14 @@ void SDL2pp::getWindowPixelResolution(int *width, int *height)
 	SDL_GL_GetDrawableSize(window, width, height);
 }
 
+/**
+ * Sets the title of the window to <title>.
+ */
+void SDL2pp::setWindowTitle(char const *title)
+{
+	SDL_SetWindowTitle(window, title);
+}
+
 /**
  * SDL_Vulkan
  */
@@ -113,6 +121,36 @@ void SDL2pp::vkCreateSurface(VkInstance &instance, VkSurfaceKHR &surface)
 	}
 }
 
+/**
+ * Copies the 32 bits ARGB <pixels> of a <width> by <height> image, <pitch>
+ * bytes apart from one row to the next, to the window surface and shows it.
+ * The image is scaled if the surface has another size. Returns 0 on success
+ * or a negative error code, the window surface being recreated when the
+ * window is resized.
+ */
+int SDL2pp::presentPixels(const uint32_t *pixels, int width, int height,
+	int pitch)
+{
+	SDL_Surface *target {SDL_GetWindowSurface(window)};
+	SDL_Surface *image {SDL_CreateRGBSurfaceWithFormatFrom(
+		const_cast<uint32_t *> (pixels), width, height, 32, pitch,
+		SDL_PIXELFORMAT_ARGB8888)};
+	int result {-1};
+
+	if (target && image)
+	{
+		result = target->w == width && target->h == height
+			? SDL_BlitSurface(image, nullptr, target, nullptr)
+			: SDL_BlitScaled(image, nullptr, target, nullptr);
+	}
+	SDL_FreeSurface(image);
+	if (result == 0)
+	{
+		result = SDL_UpdateWindowSurface(window);
+	}
+	return (result);
+}
+
 /**
  * Destroys window
  */
@@ -129,6 +167,22 @@ int SDL2pp::pollEvent(SDL_Event *event)
 	return (SDL_PollEvent(event));
 }
 
+/**
+ * Waits at most <timeout> milliseconds for the next SDL Event
+ */
+int SDL2pp::waitEventTimeout(SDL_Event *event, int timeout)
+{
+	return (SDL_WaitEventTimeout(event, timeout));
+}
+
+/**
+ * Pushes an SDL Event to the queue, safe to call from any thread
+ */
+int SDL2pp::pushEvent(SDL_Event *event)
+{
+	return (SDL_PushEvent(event));
+}
+
 /**
  * Fills vector <names> with Vulkan extenstions names needed to create a
  * VkInstance
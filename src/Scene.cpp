@@ -0,0 +1,139 @@
+#include <Scene.hpp>
+
+/**
+ * Empty scene.
+ */
+Scene::Scene(void) :
+	parents {},
+	locals {},
+	worlds {},
+	dirty {},
+	first_dirty {0}
+{
+	// Empty;
+}
+
+/**
+ * Copy constructor.
+ */
+Scene::Scene(const Scene &cpy) :
+	parents {cpy.parents},
+	locals {cpy.locals},
+	worlds {cpy.worlds},
+	dirty {cpy.dirty},
+	first_dirty {cpy.first_dirty}
+{
+	// Empty;
+}
+
+/**
+ * Destructor.
+ */
+Scene::~Scene(void) noexcept
+{
+	// Empty;
+}
+
+/**
+ * Copy assignement operator.
+ */
+Scene &Scene::operator=(const Scene &cpy)
+{
+	parents = cpy.parents;
+	locals = cpy.locals;
+	worlds = cpy.worlds;
+	dirty = cpy.dirty;
+	first_dirty = cpy.first_dirty;
+	return (*this);
+}
+
+/**
+ * Appends a node with the transform <local> relative to <parent>, or to the
+ * world if SCENE_NO_PARENT, and returns its index. Appending keeps parents
+ * before their children.
+ */
+uint32_t Scene::addNode(uint32_t parent, const Mat4 &local)
+{
+	if (parent != SCENE_NO_PARENT && parent >= parents.size())
+	{
+		throw (Error("Scene::addNode", "unknown parent"));
+	}
+	parents.push_back(parent);
+	locals.push_back(local);
+	worlds.push_back(local);
+	dirty.push_back(1);
+	first_dirty = std::min(first_dirty, parents.size() - 1);
+	return (static_cast<uint32_t> (parents.size() - 1));
+}
+
+/**
+ * Sets the transform of <node> relative to its parent. Its world transform
+ * and its descendants' are updated on the next update().
+ */
+void Scene::setLocal(uint32_t node, const Mat4 &local)
+{
+	locals[node] = local;
+	dirty[node] = 1;
+	first_dirty = std::min(first_dirty, static_cast<size_t> (node));
+}
+
+/**
+ * Recomputes the world transforms of the dirty nodes and their descendants.
+ * Since parents come first, a node's parent is final by the time the node is
+ * reached, and dirtiness flows down in the same pass. Nothing before the
+ * first dirty node is visited.
+ */
+void Scene::update(void)
+{
+	size_t count {parents.size()};
+
+	for (size_t i {first_dirty}; i < count; ++i)
+	{
+		uint32_t parent {parents[i]};
+
+		if (parent != SCENE_NO_PARENT && parent >= first_dirty)
+		{
+			dirty[i] |= dirty[parent];
+		}
+		if (dirty[i])
+		{
+			worlds[i] = parent == SCENE_NO_PARENT ? locals[i]
+				: worlds[parent] * locals[i];
+		}
+	}
+	std::fill(dirty.begin() + static_cast<std::ptrdiff_t> (
+		std::min(first_dirty, count)), dirty.end(), 0);
+	first_dirty = count;
+}
+
+/**
+ * Number of nodes.
+ */
+size_t Scene::size(void) const
+{
+	return (parents.size());
+}
+
+/**
+ * Parent of <node>, SCENE_NO_PARENT for a root.
+ */
+uint32_t Scene::getParent(uint32_t node) const
+{
+	return (parents[node]);
+}
+
+/**
+ * Transform of <node> relative to its parent.
+ */
+const Mat4 &Scene::getLocal(uint32_t node) const
+{
+	return (locals[node]);
+}
+
+/**
+ * Transform of <node> relative to the world, as of the last update().
+ */
+const Mat4 &Scene::getWorld(uint32_t node) const
+{
+	return (worlds[node]);
+}
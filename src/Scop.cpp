@@ -1,4 +1,5 @@
 #include <Scop.hpp>
+#include <Shaders.hpp>
 
 /**
  * Checks if the structure has a value.
@@ -11,31 +12,116 @@ bool Scop::QueueFamilyIndices::isComplete(void)
 /**
  * Default standard constructor.
  */
-Scop::Scop(void) :
+Scop::Scop(void) : Scop(Options())
+{
+	// Empty;
+}
+
+/**
+ * Constructor with command line settings.
+ */
+Scop::Scop(const Options &options) :
 	sdl {SDL_INIT_EVERYTHING},
+	options {options},
+	mesh {},
+	scene {},
+	turntable {scene.addNode(SCENE_NO_PARENT, Mat4::identity())},
+	model_node {scene.addNode(turntable, Mat4::identity())},
+	host_allocator {},
+	allocator {host_allocator.getCallbacks()},
 	width {SCOP_WINDOW_WIDTH},
 	height {SCOP_WINDOW_HEIGHT},
 	max_frame_in_flight {2},
 	validation_layers {"VK_LAYER_KHRONOS_validation"},
 	device_extensions {VK_KHR_SWAPCHAIN_EXTENSION_NAME,
-		VK_KHR_PORTABILITY_SUBSET_EXTENSION_NAME},
+		VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME},
 	physical_device {VK_NULL_HANDLE},
+	swapchain {VK_NULL_HANDLE},
+	swapchain_readable {false},
+	capture_pass {false},
+	render_pass {VK_NULL_HANDLE},
+	dynamic_rendering {false},
+	cmd_begin_rendering {nullptr},
+	cmd_end_rendering {nullptr},
+	synchronization2 {false},
+	cmd_pipeline_barrier2 {nullptr},
+	memory_budget_ext {false},
+	memory_budget {},
+	pipelines {},
+	variant {PipelineVariants::FULL, PipelineVariants::LIT,
+		VK_CULL_MODE_BACK_BIT, PipelineVariants::OPAQUE, VK_SAMPLE_COUNT_1_BIT,
+		options.depth_prepass ? PipelineVariants::EQUAL : PipelineVariants::LESS},
+	vert_code {},
+	frag_code {},
+	depth_code {},
+	vert_module {VK_NULL_HANDLE},
+	frag_module {VK_NULL_HANDLE},
+	depth_module {VK_NULL_HANDLE},
+	render_graph {},
+	depth_image_view {VK_NULL_HANDLE},
+	position_buffer {VK_NULL_HANDLE},
+	position_memory {VK_NULL_HANDLE},
+	attribute_buffer {VK_NULL_HANDLE},
+	attribute_memory {VK_NULL_HANDLE},
+	index_buffer {VK_NULL_HANDLE},
+	index_memory {VK_NULL_HANDLE},
+	mesh_resident {false},
+	mesh_page_in {false},
+	index_count {0},
+	mesh_radius {1.0f},
+	evicted_texture {0},
+	sampler {VK_NULL_HANDLE},
+	descriptor_pool {VK_NULL_HANDLE},
+	placeholder {},
+	texture {},
+	texture_cache {},
+	texture_upload {},
+	streaming {false},
+	mesh_load {},
+	mesh_chunks {},
+	mesh_stream {},
+	mesh_cancel {false},
+	load_percent {100},
+	deletion_queue {},
+	staging_ring {VK_NULL_HANDLE},
+	staging_ring_memory {VK_NULL_HANDLE},
+	staging_ring_data {nullptr},
+	frame_capture {},
+	timeline {VK_NULL_HANDLE},
+	timeline_value {0},
+	wait_semaphores {nullptr},
+	get_semaphore_counter {nullptr},
+	query_pool {VK_NULL_HANDLE},
+	timestamp_period {0.0},
+	software {options.software || !hasVulkanDevice()},
+	rasterizer {pool},
+	soft_texture {},
+	soft_back {},
+	soft_pending {},
+	soft_front {},
+	soft_ready {false},
+	soft_mutex {},
 	curr_frame {0},
+	frame_count {0},
+	framebuffer_resized {false},
+	scene_dirty {true},
+	minimized {false},
+	animating {!options.on_demand},
+	rotation {0.0f},
+	last_animation {std::chrono::steady_clock::now()},
+	startup {std::chrono::steady_clock::now()},
+	pacer {options.target_fps, static_cast<size_t> (max_frame_in_flight)},
+	input_log {options.record, options.replay},
+	drawable_width {0},
+	drawable_height {0},
+	running {false},
 #ifdef NDEBUG
 	enableValidationLayers(false)
 #else
 	enableValidationLayers(true)
 #endif
 {
-	sdl.addWindow(
-		"scop",
-		SDL_WINDOWPOS_CENTERED,
-		SDL_WINDOWPOS_CENTERED,
-		SCOP_WINDOW_WIDTH,
-		SCOP_WINDOW_HEIGHT,
-		SDL_WINDOW_VULKAN | SDL_WINDOW_ALLOW_HIGHDPI | SDL_WINDOW_RESIZABLE
-	);
-	initVulkan();
+	initRenderer();
 }
 
 /**
@@ -43,28 +129,104 @@ Scop::Scop(void) :
  */
 Scop::Scop(const Scop &cpy) :
 	sdl{cpy.sdl},
+	options {cpy.options},
+	mesh {cpy.mesh},
+	scene {cpy.scene},
+	turntable {cpy.turntable},
+	model_node {cpy.model_node},
+	pool {cpy.pool},
+	host_allocator {cpy.host_allocator},
+	allocator {host_allocator.getCallbacks()},
 	width{cpy.width},
 	height{cpy.height},
 	max_frame_in_flight {cpy.max_frame_in_flight},
 	validation_layers{cpy.validation_layers},
 	device_extensions {cpy.device_extensions},
 	physical_device {VK_NULL_HANDLE},
+	swapchain {VK_NULL_HANDLE},
+	swapchain_readable {false},
+	capture_pass {false},
+	render_pass {VK_NULL_HANDLE},
+	dynamic_rendering {false},
+	cmd_begin_rendering {nullptr},
+	cmd_end_rendering {nullptr},
+	synchronization2 {false},
+	cmd_pipeline_barrier2 {nullptr},
+	memory_budget_ext {false},
+	memory_budget {},
+	pipelines {},
+	variant {cpy.variant},
+	vert_code {},
+	frag_code {},
+	depth_code {},
+	vert_module {VK_NULL_HANDLE},
+	frag_module {VK_NULL_HANDLE},
+	depth_module {VK_NULL_HANDLE},
+	render_graph {},
+	depth_image_view {VK_NULL_HANDLE},
+	position_buffer {VK_NULL_HANDLE},
+	position_memory {VK_NULL_HANDLE},
+	attribute_buffer {VK_NULL_HANDLE},
+	attribute_memory {VK_NULL_HANDLE},
+	index_buffer {VK_NULL_HANDLE},
+	index_memory {VK_NULL_HANDLE},
+	mesh_resident {false},
+	mesh_page_in {false},
+	index_count {0},
+	mesh_radius {1.0f},
+	evicted_texture {0},
+	sampler {VK_NULL_HANDLE},
+	descriptor_pool {VK_NULL_HANDLE},
+	placeholder {},
+	texture {},
+	texture_cache {},
+	texture_upload {},
+	streaming {false},
+	mesh_load {},
+	mesh_chunks {},
+	mesh_stream {},
+	mesh_cancel {false},
+	load_percent {100},
+	deletion_queue {},
+	staging_ring {VK_NULL_HANDLE},
+	staging_ring_memory {VK_NULL_HANDLE},
+	staging_ring_data {nullptr},
+	frame_capture {},
+	timeline {VK_NULL_HANDLE},
+	timeline_value {0},
+	wait_semaphores {nullptr},
+	get_semaphore_counter {nullptr},
+	query_pool {VK_NULL_HANDLE},
+	timestamp_period {0.0},
+	software {cpy.software},
+	rasterizer {pool},
+	soft_texture {},
+	soft_back {},
+	soft_pending {},
+	soft_front {},
+	soft_ready {false},
+	soft_mutex {},
 	curr_frame {cpy.curr_frame},
+	frame_count {0},
+	framebuffer_resized {false},
+	scene_dirty {true},
+	minimized {false},
+	animating {cpy.animating},
+	rotation {cpy.rotation},
+	last_animation {std::chrono::steady_clock::now()},
+	startup {std::chrono::steady_clock::now()},
+	pacer {cpy.pacer},
+	input_log {cpy.input_log},
+	drawable_width {0},
+	drawable_height {0},
+	running {false},
 #ifdef NDEBUG
 	enableValidationLayers(false)
 #else
 	enableValidationLayers(true)
 #endif
 {
-	sdl.addWindow(
-		"scop",
-		SDL_WINDOWPOS_CENTERED,
-		SDL_WINDOWPOS_CENTERED,
-		SCOP_WINDOW_WIDTH,
-		SCOP_WINDOW_HEIGHT,
-		SDL_WINDOW_VULKAN | SDL_WINDOW_ALLOW_HIGHDPI | SDL_WINDOW_RESIZABLE
-	);
-	initVulkan();
+	initRenderer();
 }
 
 /**
@@ -84,65 +246,508 @@ Scop &Scop::operator=(const Scop &cpy)
 {
 	cleanup();
 	sdl = cpy.sdl;
+	options = cpy.options;
+	input_log = cpy.input_log;
+	mesh = cpy.mesh;
+	scene = cpy.scene;
+	turntable = cpy.turntable;
+	model_node = cpy.model_node;
 	validation_layers = cpy.validation_layers;
 	device_extensions = cpy.device_extensions;
 	physical_device = cpy.physical_device;
-	initVulkan();
+	software = cpy.software;
+	if (software)
+	{
+		initSoftware();
+	}
+	else
+	{
+		initVulkan();
+	}
 	return (*this);
 }
 
 /**
- * Management of keyboard events
+ * Management of keyboard events, space toggles the rotation of the model. S
+ * cycles the shading mode, C the culled faces (none, front, back) and B
+ * toggles alpha blending: the matching pipeline variant is compiled on its
+ * first use. P takes a screenshot of the next frame.
  */
-static inline bool keyboardEvent(SDL_Keycode &key)
+bool Scop::keyboardEvent(SDL_Keycode &key)
 {
 	if (key == SDLK_ESCAPE)
 	{
 		return (false);
 	}
+	if (key == SDLK_SPACE)
+	{
+		animating = !animating;
+		last_animation = std::chrono::steady_clock::now();
+	}
+	if (key == SDLK_s)
+	{
+		variant.shading = static_cast<PipelineVariants::Shading> (
+			(variant.shading + 1) % PipelineVariants::SHADING_COUNT);
+	}
+	if (key == SDLK_c)
+	{
+		variant.cull = (variant.cull + 1) % VK_CULL_MODE_FRONT_AND_BACK;
+	}
+	if (key == SDLK_b)
+	{
+		variant.blend = variant.blend == PipelineVariants::OPAQUE
+			? PipelineVariants::ALPHA : PipelineVariants::OPAQUE;
+	}
+	if (key == SDLK_p)
+	{
+		frame_capture.requestShot();
+	}
 	return (true);
 }
 
 /**
- * Management of events
+ * Management of window events. The event thread stores the new drawable size
+ * in pixels in data1 and data2 of size change events.
+ */
+void Scop::windowEvent(SDL_WindowEvent &window)
+{
+	switch (window.event)
+	{
+		case SDL_WINDOWEVENT_SIZE_CHANGED:
+			drawable_width = window.data1;
+			drawable_height = window.data2;
+			framebuffer_resized = true;
+			break ;
+		case SDL_WINDOWEVENT_MINIMIZED:
+			minimized = true;
+			break ;
+		case SDL_WINDOWEVENT_RESTORED:
+		case SDL_WINDOWEVENT_MAXIMIZED:
+		case SDL_WINDOWEVENT_SHOWN:
+			minimized = false;
+			break ;
+		default:
+			break ;
+	}
+}
+
+/**
+ * Handles a single event, any event other than quitting marks the scene as
+ * dirty. Returns false if the program should stop.
+ */
+bool Scop::handleEvent(SDL_Event &event)
+{
+	switch (event.type)
+	{
+		case SDL_QUIT:
+			return (false);
+		case SDL_KEYDOWN:
+			scene_dirty = true;
+			return (keyboardEvent(event.key.keysym.sym));
+		case SDL_WINDOWEVENT:
+			scene_dirty = true;
+			windowEvent(event.window);
+			return (true);
+		default:
+			scene_dirty = true;
+			return (true);
+	}
+}
+
+/**
+ * Tells if there is nothing to draw: the window is minimized, or on-demand
+ * mode is enabled and the scene did not change since the last frame. A
+ * rotating model always changes, and a replay draws every frame. So does a
+ * mesh being streamed or paged in, and a texture being loaded or streamed,
+ * since nothing else would wake the render thread up when they progress.
+ */
+bool Scop::isIdle(void)
+{
+	return (minimized || (options.on_demand && !scene_dirty && !animating
+		&& !mesh_stream.active && !mesh_page_in && !streaming
+		&& !texture_load.valid() && input_log.getMode() != InputLog::REPLAY));
+}
+
+/**
+ * Advances the rotation of the turntable the model sits on by the time elapsed
+ * since the last call. A replay advances it by SCOP_REPLAY_DT instead, so that
+ * every replay of a log shows the same frames whatever their duration.
+ */
+void Scop::animate(void)
+{
+	std::chrono::steady_clock::time_point now {
+		std::chrono::steady_clock::now()};
+	std::chrono::duration<float> elapsed {now - last_animation};
+
+	last_animation = now;
+	if (input_log.getMode() == InputLog::REPLAY)
+	{
+		elapsed = std::chrono::duration<float> (SCOP_REPLAY_DT);
+	}
+	if (animating)
+	{
+		rotation = std::fmod(rotation + elapsed.count() * SCOP_ROTATION_SPEED,
+			2.0f * static_cast<float> (M_PI));
+		scene.setLocal(turntable,
+			Mat4::rotation(rotation, Vec3 {0.0f, 1.0f, 0.0f}));
+		scene_dirty = true;
+	}
+}
+
+/**
+ * Computes the transforms of the current frame. The model node centers the
+ * mesh on the turntable rotating around the vertical axis, the camera is
+ * placed far enough to see its whole bounding sphere.
+ */
+Scop::Transform Scop::computeTransform(void)
+{
+	float radius {mesh_radius};
+	float aspect {static_cast<float> (swapchain_extent.width)
+		/ static_cast<float> (swapchain_extent.height)};
+	Mat4 view {Mat4::lookAt(Vec3 {0.0f, 0.0f, 2.5f * radius},
+		Vec3 {0.0f, 0.0f, 0.0f}, Vec3 {0.0f, 1.0f, 0.0f})};
+	Mat4 projection {Mat4::perspective(static_cast<float> (M_PI) / 4.0f,
+		aspect, 0.1f * radius, 10.0f * radius)};
+
+	scene.update();
+	return (Transform {
+		.mvp = projection * view * scene.getWorld(model_node),
+		.model = scene.getWorld(model_node)
+	});
+}
+
+/**
+ * Management of events on the render thread, drains every event forwarded by
+ * the event thread. When idle, settles the frames in flight then blocks until
+ * the next one arrives so that nothing spins. Handled events are kept by the
+ * input log when recording.
  */
 bool Scop::manageEvent()
 {
 	SDL_Event event;
+	bool alive {true};
+
+	if (input_log.getMode() == InputLog::REPLAY)
+	{
+		return (replayEvents());
+	}
+	if (isIdle())
+	{
+		settle();
+		events.wait();
+	}
+	while (alive && events.pop(event))
+	{
+		input_log.record(event);
+		alive = handleEvent(event);
+	}
+	input_log.endFrame();
+	return (alive);
+}
+
+/**
+ * Management of events when replaying: the events of the next recorded frame
+ * are handled instead of the keys pressed now. Window events still come from
+ * the actual window, which the swapchain follows, and closing it still stops
+ * the replay, which pauses while the window is minimized. Returns false at the
+ * end of the log.
+ */
+bool Scop::replayEvents(void)
+{
+	SDL_Event event;
+	std::vector<SDL_Event> recorded {};
+	bool alive {true};
 
-	while (sdl.pollEvent(&event))
+	if (minimized)
 	{
-		switch (event.type)
+		events.wait();
+	}
+	while (events.pop(event))
+	{
+		if (event.type == SDL_QUIT || event.type == SDL_WINDOWEVENT)
 		{
-			case SDL_QUIT:
-				return (false);
-			case SDL_KEYDOWN:
-				return (keyboardEvent(event.key.keysym.sym));
-			default:
-				return (true);
+			alive = handleEvent(event) && alive;
 		}
 	}
-	return (true);
+	if (!alive || minimized)
+	{
+		return (alive);
+	}
+	alive = input_log.replay(recorded);
+	for (SDL_Event &replayed : recorded)
+	{
+		if (alive && replayed.type != SDL_WINDOWEVENT)
+		{
+			alive = handleEvent(replayed);
+		}
+	}
+	return (alive);
+}
+
+/**
+ * Creates the window, a Vulkan one unless rendering on the CPU, then
+ * initializes the renderer drawing into it.
+ */
+void Scop::initRenderer(void)
+{
+	Uint32 flags {SDL_WINDOW_ALLOW_HIGHDPI | SDL_WINDOW_RESIZABLE};
+
+	if (!software)
+	{
+		flags |= SDL_WINDOW_VULKAN;
+	}
+	sdl.addWindow(
+		"scop",
+		SDL_WINDOWPOS_CENTERED,
+		SDL_WINDOWPOS_CENTERED,
+		SCOP_WINDOW_WIDTH,
+		SCOP_WINDOW_HEIGHT,
+		flags
+	);
+	sdl.getWindowPixelResolution(&drawable_width, &drawable_height);
+	if (software)
+	{
+		initSoftware();
+	}
+	else
+	{
+		initVulkan();
+	}
 }
 
 /**
- * Initialization of Vulkan
+ * Initialization of Vulkan, expressed as a task graph so that independent
+ * steps overlap: the mesh and shaders load while the instance and device are
+ * created, the texture decodes while the swapchain and pipelines are built,
+ * and both pipelines compile concurrently. Tasks touching SDL stay on the
+ * calling thread. Steps sharing the graphic queue or the command pool are
+ * chained.
  */
 void Scop::initVulkan(void)
 {
-	createInstance();
-	setupDebugMessenger();
-	createSurface();
-	pickPhysicalDevice();
-	createLogicalDevice();
-	createSwapChain();
-	createImageViews();
-	createRenderPass();
-	createGraphicsPipeline();
-	createFramebuffers();
-	createCommandPool();
-	createCommandBuffers();
-	createSyncObjects();
+	TaskGraph graph {};
+	size_t mesh_node {graph.add("mesh", [this](void) { loadMesh(); })};
+	size_t shaders {graph.add("shaders", [this](void) { loadShaders(); })};
+	size_t inst {graph.add("instance", [this](void) { createInstance(); },
+		{}, true)};
+	size_t surf {graph.add("surface", [this](void) { createSurface(); },
+		{inst}, true)};
+	size_t pick {graph.add("physical device",
+		[this](void) { pickPhysicalDevice(); }, {surf})};
+	size_t dev {graph.add("logical device",
+		[this](void) { createLogicalDevice(); }, {pick})};
+	size_t swap {graph.add("swapchain", [this](void) { createSwapChain(); },
+		{dev})};
+	size_t views {graph.add("image views",
+		[this](void) { createImageViews(); }, {swap})};
+	size_t frame {graph.add("render graph", [this](void)
+		{
+			depth_format = findDepthFormat();
+			buildRenderGraph();
+		}, {views})};
+	size_t pass {graph.add("render pass", [this](void) { createRenderPass(); },
+		{frame})};
+	size_t set_layout {graph.add("descriptor set layout",
+		[this](void) { createDescriptorSetLayout(); }, {dev})};
+	size_t layout {graph.add("pipeline layout",
+		[this](void) { createPipelineLayout(); }, {set_layout})};
+	size_t cmd_pool {graph.add("command pool",
+		[this](void) { createCommandPool(); }, {dev})};
+	size_t sync {graph.add("sync objects",
+		[this](void) { createSyncObjects(); }, {dev})};
+	size_t buffers {graph.add("vertex buffers",
+		[this](void) { createVertexBuffers(); }, {cmd_pool, mesh_node, sync})};
+	size_t smp {graph.add("sampler", [this](void) { createSampler(); },
+		{dev})};
+	size_t ring {graph.add("staging ring",
+		[this](void) { createStagingRing(); }, {dev})};
+	size_t holder {graph.add("placeholder texture",
+		[this](void) { createPlaceholderTexture(); }, {buffers, ring})};
+	size_t desc_pool {graph.add("descriptor pool",
+		[this](void) { createDescriptorPool(); }, {dev})};
+
+	size_t modules {graph.add("shader modules",
+		[this](void) { createShaderModules(); }, {dev, shaders})};
+
+	graph.add("debug messenger", [this](void) { setupDebugMessenger(); },
+		{inst});
+	graph.add("graphics pipeline", [this](void) { pipelines.get(variant); },
+		{pass, layout, modules});
+	graph.add("depth pipeline", [this](void)
+		{
+			if (options.depth_prepass)
+			{
+				pipelines.get(getDepthVariant());
+			}
+		}, {pass, layout, modules});
+	graph.add("framebuffers", [this](void) { createFramebuffers(); },
+		{frame, pass});
+	graph.add("descriptor sets", [this](void) { createDescriptorSets(); },
+		{desc_pool, set_layout, holder, smp});
+	graph.add("command buffers", [this](void) { createCommandBuffers(); },
+		{holder});
+	graph.add("query pool", [this](void) { createQueryPool(); }, {dev});
+	graph.add("texture", [this](void)
+		{
+			if (!options.texture.empty())
+			{
+				loadTexture(options.texture);
+			}
+		}, {dev});
+	graph.run(pool);
+	if (options.report)
+	{
+		std::cerr << "startup " << graph.getDuration() << " ms:" << std::endl;
+		graph.writeSummary(std::cerr);
+		std::cerr << pipelines.size() << " pipeline variants compiled in "
+			<< pipelines.getCompileTime() << " ms" << std::endl;
+		render_graph.writeSummary(std::cerr);
+		host_allocator.writeReport(std::cerr);
+		memory_budget.writeReport(std::cerr);
+	}
+	if (!options.startup_trace.empty())
+	{
+		std::ofstream trace {options.startup_trace};
+
+		graph.writeTrace(trace);
+	}
+}
+
+/**
+ * Initialization of the software renderer, used with --cpu or when Vulkan
+ * has no suitable device: the texture decodes on the pool while the mesh loads.
+ */
+void Scop::initSoftware(void)
+{
+	std::future<void> decoded {pool.submit([this](void)
+		{
+			loadSoftwareTexture();
+		})};
+
+	loadMesh();
+	decoded.get();
+	if (options.report)
+	{
+		std::cerr << "software rasterizer on " << pool.size() + 1
+			<< " threads" << std::endl;
+	}
+}
+
+/**
+ * Decodes the texture for the software renderer, or a single white texel
+ * without --texture.
+ */
+void Scop::loadSoftwareTexture(void)
+{
+	soft_texture = SoftRasterizer::Texture {1, 1, {0xff, 0xff, 0xff, 0xff}};
+	if (options.texture.empty())
+	{
+		return ;
+	}
+
+	Image image {options.texture};
+
+	soft_texture.width = image.getWidth();
+	soft_texture.height = image.getHeight();
+	soft_texture.texels.resize(static_cast<size_t> (soft_texture.width)
+		* soft_texture.height * 4);
+	image.decode(soft_texture.texels.data());
+}
+
+/**
+ * Loads the model, unless a copy already brought it, and centers it on the
+ * turntable. OBJ files of at least SCOP_PROGRESSIVE_SIZE bytes are parsed in
+ * the background instead: their chunks are streamed to the GPU as they come,
+ * so the first frames already show the part parsed so far. Binary assets are
+ * only decoded, which is fast enough to do at once.
+ */
+void Scop::loadMesh(void)
+{
+	std::error_code error {};
+	uintmax_t size {std::filesystem::file_size(options.model, error)};
+
+	if (mesh.getIndices().empty() && !error && size >= SCOP_PROGRESSIVE_SIZE
+		&& !software && !Mesh::isAsset(options.model))
+	{
+		mesh_stream.active = true;
+		mesh_resident = true;
+		load_percent.store(0, std::memory_order_relaxed);
+		mesh_load = std::async(std::launch::async, [this](void)
+			{
+				mesh.load(options.model, [this](const Mesh::Chunk &chunk)
+					{
+						while (!mesh_cancel.load(std::memory_order_relaxed))
+						{
+							if (mesh_chunks.push(chunk))
+							{
+								return ;
+							}
+							std::this_thread::sleep_for(
+								std::chrono::milliseconds(1));
+						}
+						throw (Error("Scop::loadMesh", "load cancelled"));
+					});
+			});
+		return ;
+	}
+	if (mesh.getIndices().empty())
+	{
+		mesh.load(options.model);
+	}
+	frameBounds(mesh.getBounds());
+}
+
+/**
+ * Centers <bounds> on the turntable and moves the camera back to fit them.
+ */
+void Scop::frameBounds(const Mesh::Bounds &bounds)
+{
+	scene.setLocal(model_node, Mat4::translation((bounds.min + bounds.max)
+		* -0.5f));
+	mesh_radius = Vec3::length(bounds.max - bounds.min) * 0.5f;
+	scene_dirty = true;
+}
+
+/**
+ * Takes the SPIR-V of every shader stage, built in or from the --shaders
+ * directory.
+ */
+void Scop::loadShaders(void)
+{
+	vert_code = loadShader("vert", SHADER_VERT, std::size(SHADER_VERT));
+	frag_code = loadShader("frag", SHADER_FRAG, std::size(SHADER_FRAG));
+	depth_code = loadShader("depth", SHADER_DEPTH, std::size(SHADER_DEPTH));
+}
+
+/**
+ * Returns the SPIR-V <name>.spv of the override directory if there is one,
+ * the <size> words of the built-in <code> otherwise, which are used in place.
+ * Throws if the override isn't SPIR-V.
+ */
+Scop::ShaderCode Scop::loadShader(const std::string &name,
+	const uint32_t *code, size_t size)
+{
+	std::string path {options.shaders + "/" + name + ".spv"};
+
+	if (options.shaders.empty() || !std::filesystem::exists(path))
+	{
+		return (ShaderCode {code, size, {}});
+	}
+
+	std::vector<char> file {readFile(path)};
+	ShaderCode shader {nullptr, file.size() / sizeof(uint32_t), {}};
+
+	if (file.size() % sizeof(uint32_t) || !shader.size)
+	{
+		throw (Error("Scop::loadShader", "invalid SPIR-V size"));
+	}
+	shader.file.resize(shader.size);
+	std::memcpy(shader.file.data(), file.data(), file.size());
+	if (shader.file[0] != 0x07230203)
+	{
+		throw (Error("Scop::loadShader", "invalid SPIR-V magic"));
+	}
+	return (shader);
 }
 
 /**
@@ -152,57 +757,128 @@ void Scop::destroySemaphores(void)
 {
 	for (const VkSemaphore &sem : image_sem)
 	{
-		vkDestroySemaphore(device, sem, nullptr);
+		vkDestroySemaphore(device, sem, allocator);
 	}
 	for (const VkSemaphore &sem : render_sem)
 	{
-		vkDestroySemaphore(device, sem, nullptr);
+		vkDestroySemaphore(device, sem, allocator);
 	}
+	vkDestroySemaphore(device, timeline, allocator);
 }
 
 /**
- * Destroys every fences.
+ * Destroys a swapchain along with its image views and framebuffers.
  */
-void Scop::destroyFences(void)
+static inline void destroySwapChain(VkDevice device,
+	const VkAllocationCallbacks *allocator, VkSwapchainKHR swapchain,
+	const std::vector<VkImageView> &image_views,
+	const std::vector<VkFramebuffer> &framebuffers)
 {
-	for (const VkFence &fence : frame_fence)
+	for (const auto &framebuffer : framebuffers)
+	{
+		vkDestroyFramebuffer(device, framebuffer, allocator);
+	}
+	for (const auto &image_view : image_views)
 	{
-		vkDestroyFence(device, fence, nullptr);
+		vkDestroyImageView(device, image_view, allocator);
 	}
+	vkDestroySwapchainKHR(device, swapchain, allocator);
 }
 
+/**
+ * Destroys the current swapchain and the transients of the render graph. The
+ * device must be idle.
+ */
 void Scop::cleanupSwapChain(void)
 {
-	for (const auto &framebuffer : swapchain_framebuffers)
-	{
-		vkDestroyFramebuffer(device, framebuffer, nullptr);
-	}
-	for (const auto &image_view : swapchain_image_view)
-	{
-		vkDestroyImageView(device, image_view, nullptr);
-	}
-	vkDestroySwapchainKHR(device, swapchain, nullptr);
+	destroySwapChain(device, allocator, swapchain, swapchain_image_view,
+		swapchain_framebuffers);
+	render_graph.release()();
+	swapchain = VK_NULL_HANDLE;
+	depth_image_view = VK_NULL_HANDLE;
+}
+
+/**
+ * Destroys the vertex and index buffers of the mesh.
+ */
+void Scop::destroyBuffers(void)
+{
+	vkDestroyBuffer(device, index_buffer, allocator);
+	memory_budget.free(index_memory);
+	vkDestroyBuffer(device, attribute_buffer, allocator);
+	memory_budget.free(attribute_memory);
+	vkDestroyBuffer(device, position_buffer, allocator);
+	memory_budget.free(position_memory);
+}
+
+/**
+ * Queues <destroy> to run once the frame being recorded, the last that may
+ * use what it destroys, is done on the GPU.
+ */
+void Scop::retire(std::function<void(void)> destroy)
+{
+	deletion_queue.push(timeline_value + 1, std::move(destroy));
+}
+
+/**
+ * Retires the current swapchain and its dependent objects, transients of the
+ * render graph included. The handle is kept in <swapchain> so the next
+ * swapchain can be created with it as oldSwapchain, letting the presentation
+ * engine hand images over.
+ */
+void Scop::retireSwapChain(void)
+{
+	retire([this, swapchain = swapchain,
+		image_views = std::move(swapchain_image_view),
+		framebuffers = std::move(swapchain_framebuffers)](void)
+		{
+			destroySwapChain(device, allocator, swapchain, image_views,
+				framebuffers);
+		});
+	retire(render_graph.release());
+	depth_image_view = VK_NULL_HANDLE;
+	swapchain_image_view.clear();
+	swapchain_framebuffers.clear();
 }
 
 /**
- * Cleans Vulkan application up before exit or reinitialisation
+ * Cleans Vulkan application up before exit or reinitialisation, starting with
+ * a background parse of the mesh and every retired object. The device must be
+ * idle.
  */
 void Scop::cleanup(void)
 {
+	mesh_cancel.store(true, std::memory_order_relaxed);
+	if (mesh_load.valid())
+	{
+		mesh_load.wait();
+	}
+	if (software)
+	{
+		return ;
+	}
+	deletion_queue.flush(UINT64_MAX);
+	frame_capture.release();
+	cleanupTextures();
 	cleanupSwapChain();
 	destroySemaphores();
-	destroyFences();
-	vkDestroyCommandPool(device, command_pool, nullptr);
-	vkDestroyPipeline(device, graphics_pipeline, nullptr);
-	vkDestroyPipelineLayout(device, pipeline_layout, nullptr);
-	vkDestroyRenderPass(device, render_pass, nullptr);
-	vkDestroyDevice(device, nullptr);
+	destroyBuffers();
+	vkDestroyQueryPool(device, query_pool, allocator);
+	vkDestroyCommandPool(device, command_pool, allocator);
+	pipelines.clear();
+	vkDestroyShaderModule(device, depth_module, allocator);
+	vkDestroyShaderModule(device, frag_module, allocator);
+	vkDestroyShaderModule(device, vert_module, allocator);
+	vkDestroyPipelineLayout(device, pipeline_layout, allocator);
+	vkDestroyDescriptorSetLayout(device, descriptor_layout, allocator);
+	vkDestroyRenderPass(device, render_pass, allocator);
+	vkDestroyDevice(device, allocator);
 	vkDestroySurfaceKHR(instance, surface, nullptr);
 	if (enableValidationLayers)
 	{
-		destroyDebugUtilsMessengerEXT(instance, debug_messenger, nullptr);
+		destroyDebugUtilsMessengerEXT(instance, debug_messenger, allocator);
 	}
-	vkDestroyInstance(instance, nullptr);
+	vkDestroyInstance(instance, allocator);
 }
 
 /**
@@ -215,7 +891,7 @@ static inline void setAppInfo(VkApplicationInfo &app_info)
 	app_info.applicationVersion = VK_MAKE_API_VERSION(1, 0, 0, 0);
 	app_info.pEngineName = "No Engine";
 	app_info.engineVersion = VK_MAKE_API_VERSION(1, 0, 0, 0);
-	app_info.apiVersion = VK_API_VERSION_1_0;
+	app_info.apiVersion = VK_API_VERSION_1_1;
 }
 
 /**
@@ -281,7 +957,68 @@ void Scop::createInstance(void)
 		create_info.pNext =
 			reinterpret_cast<VkDebugUtilsMessengerCreateInfoEXT *> (&debug);
 	}
-	createVkInstance(create_info, nullptr, instance);
+	createVkInstance(create_info, allocator, instance);
+}
+
+/**
+ * Tells if Vulkan has at least one physical device that can be suitable,
+ * through an instance of its own since the window has to be created before
+ * the actual instance: one with a graphic queue and the required extensions.
+ * Presentation needs the window surface, pickPhysicalDevice checks it later.
+ * Portability drivers are enumerated when the loader supports them.
+ */
+bool Scop::hasVulkanDevice(void)
+{
+	const char *extensions[] {VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME};
+	VkApplicationInfo app_info {};
+	VkInstanceCreateInfo create_info {};
+	VkInstance probe {VK_NULL_HANDLE};
+	uint32_t count {0};
+
+	setAppInfo(app_info);
+	create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+	create_info.pApplicationInfo = &app_info;
+	create_info.enabledExtensionCount = 1;
+	create_info.ppEnabledExtensionNames = extensions;
+	create_info.flags |= VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
+	if (vkCreateInstance(&create_info, nullptr, &probe) != VK_SUCCESS)
+	{
+		create_info.enabledExtensionCount = 0;
+		create_info.flags = 0;
+		if (vkCreateInstance(&create_info, nullptr, &probe) != VK_SUCCESS)
+		{
+			return (false);
+		}
+	}
+	vkEnumeratePhysicalDevices(probe, &count, nullptr);
+
+	std::vector<VkPhysicalDevice> devices(count);
+	bool found {false};
+
+	vkEnumeratePhysicalDevices(probe, &count, devices.data());
+	for (VkPhysicalDevice device : devices)
+	{
+		uint32_t family_count {0};
+
+		vkGetPhysicalDeviceQueueFamilyProperties(device, &family_count,
+			nullptr);
+
+		std::vector<VkQueueFamilyProperties> families(family_count);
+
+		vkGetPhysicalDeviceQueueFamilyProperties(device, &family_count,
+			families.data());
+		for (const VkQueueFamilyProperties &family : families)
+		{
+			found = found || (family.queueFlags & VK_QUEUE_GRAPHICS_BIT);
+		}
+		found = found && checkDeviceExtensionSupport(device);
+		if (found)
+		{
+			break ;
+		}
+	}
+	vkDestroyInstance(probe, nullptr);
+	return (found);
 }
 
 /**
@@ -296,7 +1033,7 @@ void Scop::setupDebugMessenger(void)
 
 		setDebugMessengerCreateInfo(create_info);
 		if (createDebugUtilsMessengerEXT(instance, &create_info,
-			nullptr, &debug_messenger) != VK_SUCCESS)
+			allocator, &debug_messenger) != VK_SUCCESS)
 		{
 			throw (Error("Scop::setupDebugMessenger",
 				"failed to set up debug messenger"));
@@ -384,33 +1121,245 @@ static inline void checkPresentSupport(const VkPhysicalDevice &device,
 }
 
 /**
- * Picks adapted physical graphic device
+ * Lowercase hexadecimal UUID of <device>: its device UUID when it supports
+ * Vulkan 1.1, otherwise its pipeline cache UUID.
  */
-void Scop::pickPhysicalDevice(void)
+static inline std::string deviceUuid(VkPhysicalDevice device)
 {
-	uint32_t count {0};
+	VkPhysicalDeviceProperties properties {};
+	VkPhysicalDeviceIDProperties id {};
+	VkPhysicalDeviceProperties2 properties2 {};
+	char hex[2 * VK_UUID_SIZE + 1] {};
 
-	vkEnumeratePhysicalDevices(instance, &count, nullptr);
-	if (count == 0)
-	{
-		throw (Error("Scop::pickPhysicalDevice", "No GPU with Vulkan support"));
-	}
+	vkGetPhysicalDeviceProperties(device, &properties);
 
-	std::vector<VkPhysicalDevice> devices(count);
+	const uint8_t *uuid {properties.pipelineCacheUUID};
 
-	vkEnumeratePhysicalDevices(instance, &count, devices.data());
-	for (const auto &dev : devices)
+	if (properties.apiVersion >= VK_API_VERSION_1_1)
 	{
-		if (isDeviceSuitable(dev))
-		{
-			physical_device = dev;
-			break ;
-		}
+		id.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &id;
+		vkGetPhysicalDeviceProperties2(device, &properties2);
+		uuid = id.deviceUUID;
 	}
-	if (physical_device == VK_NULL_HANDLE)
+	for (uint32_t i {0}; i < VK_UUID_SIZE; ++i)
 	{
-		throw (Error("Scop::pickPhysicalDevice", "No suitable GPU"));
+		std::snprintf(hex + 2 * i, 3, "%02x", uuid[i]);
 	}
+	return (std::string(hex));
+}
+
+/**
+ * Scores <device>: its type first (discrete, integrated, virtual, other,
+ * then CPU), then its device local memory, then its largest 2D image.
+ */
+static inline uint64_t scoreDevice(VkPhysicalDevice device)
+{
+	VkPhysicalDeviceProperties properties {};
+	VkPhysicalDeviceMemoryProperties memory {};
+	uint64_t score {0};
+
+	vkGetPhysicalDeviceProperties(device, &properties);
+	vkGetPhysicalDeviceMemoryProperties(device, &memory);
+	switch (properties.deviceType)
+	{
+		case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+			score = 4000000;
+			break ;
+		case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+			score = 3000000;
+			break ;
+		case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+			score = 2000000;
+			break ;
+		case VK_PHYSICAL_DEVICE_TYPE_OTHER:
+			score = 1000000;
+			break ;
+		default:
+			break ;
+	}
+	for (uint32_t i {0}; i < memory.memoryHeapCount; ++i)
+	{
+		if (memory.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+		{
+			score += (memory.memoryHeaps[i].size >> 20) * 10;
+		}
+	}
+	return (score + properties.limits.maxImageDimension2D / 1024);
+}
+
+/**
+ * Tells if <device>, enumerated at <index>, is designated by <spec>: its
+ * index, its UUID (dashes ignored) or a case insensitive part of its name.
+ */
+static inline bool matchesDevice(VkPhysicalDevice device, size_t index,
+	const std::string &spec)
+{
+	VkPhysicalDeviceProperties properties {};
+	std::string lower {};
+	std::string name {};
+
+	if (!spec.empty() && std::all_of(spec.begin(), spec.end(), ::isdigit))
+	{
+		return (std::strtoull(spec.c_str(), nullptr, 10) == index);
+	}
+	for (char c : spec)
+	{
+		if (c != '-')
+		{
+			lower += static_cast<char> (std::tolower(c));
+		}
+	}
+	if (lower == deviceUuid(device))
+	{
+		return (true);
+	}
+	vkGetPhysicalDeviceProperties(device, &properties);
+	for (const char *c {properties.deviceName}; *c; ++c)
+	{
+		name += static_cast<char> (std::tolower(*c));
+	}
+	lower.clear();
+	for (char c : spec)
+	{
+		lower += static_cast<char> (std::tolower(c));
+	}
+	return (name.find(lower) != std::string::npos);
+}
+
+/**
+ * Picks the physical device: the one designated by --device (or SCOP_DEVICE),
+ * which must be suitable, else the fastest suitable one by benchmark if
+ * requested, else the best scored suitable one.
+ */
+void Scop::pickPhysicalDevice(void)
+{
+	uint32_t count {0};
+
+	vkEnumeratePhysicalDevices(instance, &count, nullptr);
+	if (count == 0)
+	{
+		throw (Error("Scop::pickPhysicalDevice", "No GPU with Vulkan support"));
+	}
+
+	std::vector<VkPhysicalDevice> devices(count);
+	std::vector<VkPhysicalDevice> candidates {};
+
+	vkEnumeratePhysicalDevices(instance, &count, devices.data());
+	for (size_t i {0}; i < devices.size() && !options.device.empty(); ++i)
+	{
+		if (matchesDevice(devices[i], i, options.device))
+		{
+			candidates.push_back(devices[i]);
+			break ;
+		}
+	}
+	if (!options.device.empty() && candidates.empty())
+	{
+		throw (Error("Scop::pickPhysicalDevice", "No GPU matches --device"));
+	}
+	for (size_t i {0}; i < devices.size() && options.device.empty(); ++i)
+	{
+		if (isDeviceSuitable(devices[i]))
+		{
+			candidates.push_back(devices[i]);
+		}
+	}
+	if (candidates.empty() || !isDeviceSuitable(candidates.front()))
+	{
+		throw (Error("Scop::pickPhysicalDevice", "No suitable GPU"));
+	}
+	physical_device = *std::max_element(candidates.begin(), candidates.end(),
+		[](VkPhysicalDevice a, VkPhysicalDevice b)
+		{
+			return (scoreDevice(a) < scoreDevice(b));
+		});
+	if (options.device_benchmark && candidates.size() > 1)
+	{
+		physical_device = benchmarkDevices(candidates);
+	}
+	if (options.report)
+	{
+		VkPhysicalDeviceProperties properties {};
+
+		vkGetPhysicalDeviceProperties(physical_device, &properties);
+		std::cerr << "device: " << properties.deviceName << " ("
+			<< deviceUuid(physical_device) << "), score "
+			<< scoreDevice(physical_device) << std::endl;
+	}
+}
+
+/**
+ * Runs the device benchmark on every candidate and returns the fastest. The
+ * winner is cached with the set of candidates and their driver versions, so
+ * the benchmark only runs again when those change.
+ */
+VkPhysicalDevice Scop::benchmarkDevices(
+	const std::vector<VkPhysicalDevice> &candidates)
+{
+	std::string key {};
+	std::string cached_key {};
+	std::string cached_uuid {};
+	VkPhysicalDevice best {candidates.front()};
+	double best_score {-1.0};
+
+	for (VkPhysicalDevice candidate : candidates)
+	{
+		VkPhysicalDeviceProperties properties {};
+
+		vkGetPhysicalDeviceProperties(candidate, &properties);
+		key += deviceUuid(candidate) + ":"
+			+ std::to_string(properties.driverVersion) + ";";
+	}
+	{
+		std::ifstream cache {SCOP_DEVICE_CACHE};
+
+		if (std::getline(cache, cached_key) && cached_key == key
+			&& std::getline(cache, cached_uuid))
+		{
+			for (VkPhysicalDevice candidate : candidates)
+			{
+				if (deviceUuid(candidate) == cached_uuid)
+				{
+					return (candidate);
+				}
+			}
+		}
+	}
+	for (VkPhysicalDevice candidate : candidates)
+	{
+		DeviceBenchmark benchmark {candidate,
+			findQueueFamilies(candidate).graphic_family.value(),
+			getDeviceExtensions(candidate)};
+		DeviceBenchmark::Result result {benchmark.run()};
+
+		if (options.report)
+		{
+			VkPhysicalDeviceProperties properties {};
+
+			vkGetPhysicalDeviceProperties(candidate, &properties);
+			std::cerr << "benchmark " << properties.deviceName << ": fill "
+				<< result.fill_rate << " Gpix/s, vertices "
+				<< result.vertex_rate << " Gvert/s, bandwidth "
+				<< result.bandwidth << " GB/s" << std::endl;
+		}
+		if (DeviceBenchmark::score(result) > best_score)
+		{
+			best_score = DeviceBenchmark::score(result);
+			best = candidate;
+		}
+	}
+
+	std::error_code error {};
+
+	std::filesystem::create_directories(
+		std::filesystem::path(SCOP_DEVICE_CACHE).parent_path(), error);
+
+	std::ofstream cache {SCOP_DEVICE_CACHE, std::ios::trunc};
+
+	cache << key << std::endl << deviceUuid(best) << std::endl;
+	return (best);
 }
 
 /**
@@ -482,6 +1431,35 @@ bool Scop::checkDeviceExtensionSupport(const VkPhysicalDevice &tested_device)
 	return (required_extensions.empty());
 }
 
+/**
+ * Device extensions to enable on <device>: the required ones, and
+ * VK_KHR_portability_subset when the device lists it, as the specification
+ * asks of portability drivers such as MoltenVK. Other drivers don't have it.
+ */
+std::vector<const char *> Scop::getDeviceExtensions(
+	const VkPhysicalDevice &device)
+{
+	std::vector<const char *> extensions {device_extensions};
+	uint32_t count {0};
+
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &count, nullptr);
+
+	std::vector<VkExtensionProperties> available {count};
+
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &count,
+		available.data());
+	for (const VkExtensionProperties &extension : available)
+	{
+		if (!strcmp(extension.extensionName,
+			VK_KHR_PORTABILITY_SUBSET_EXTENSION_NAME))
+		{
+			extensions.push_back(VK_KHR_PORTABILITY_SUBSET_EXTENSION_NAME);
+			break ;
+		}
+	}
+	return (extensions);
+}
+
 /**
  * Fills the SwapChainSupportDetails structure with information about available
  * features of the device swap chains
@@ -576,14 +1554,9 @@ VkExtent2D Scop::chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities)
 		return (capabilities.currentExtent);
 	}
 	
-	int width {0};
-	int height {0};
-
-	sdl.getWindowPixelResolution(&width, &height);
-
 	VkExtent2D actual_extent {
-		static_cast<uint32_t> (width),
-		static_cast<uint32_t> (height)
+		static_cast<uint32_t> (drawable_width),
+		static_cast<uint32_t> (drawable_height)
 	};
 
 	actual_extent.width = clampValue(actual_extent.width,
@@ -615,6 +1588,11 @@ static inline void setSwapchainCreateInfo(
 	create_info.imageExtent = extent;
 	create_info.imageArrayLayers = 1;
 	create_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	if (support.capabilities.supportedUsageFlags
+		& VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
+	{
+		create_info.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	}
 
 	if (indices.graphic_family.value() != indices.present_family.value())
 	{
@@ -630,7 +1608,6 @@ static inline void setSwapchainCreateInfo(
 	create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 	create_info.presentMode = present_mode;
 	create_info.clipped = VK_TRUE;
-	create_info.oldSwapchain = VK_NULL_HANDLE;
 }
 
 /**
@@ -649,7 +1626,9 @@ static inline void getImagesHandles(VkDevice &device, VkSwapchainKHR swapchain,
 }
 
 /**
- * Creates the swapchain to manage images display.
+ * Creates the swapchain to manage images display. If a swapchain already
+ * exists it is passed as oldSwapchain so presentation is not interrupted, the
+ * caller is responsible for retiring it.
  */
 void Scop::createSwapChain(void)
 {
@@ -671,7 +1650,10 @@ void Scop::createSwapChain(void)
 	}
 	setSwapchainCreateInfo(create_info, support, format, present_mode,
 		swapchain_extent, image_count, indices, queue_indices, surface);
-	if (vkCreateSwapchainKHR(device, &create_info, nullptr, &swapchain)
+	create_info.oldSwapchain = swapchain;
+	swapchain_readable = create_info.imageUsage
+		& VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	if (vkCreateSwapchainKHR(device, &create_info, allocator, &swapchain)
 		!= VK_SUCCESS)
 	{
 		throw (Error("Scop::createSwapChain", "failed swapchain creation"));
@@ -738,7 +1720,126 @@ static inline void setDeviceCreateInfo(
 }
 
 /**
- * Creates an instance of a logical device.
+ * Tells if the device supports VK_KHR_dynamic_rendering, along with the
+ * extensions it depends on, and has the feature.
+ */
+bool Scop::supportsDynamicRendering(void)
+{
+	VkPhysicalDeviceProperties properties {};
+	VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamic_features {};
+	VkPhysicalDeviceFeatures2 features {};
+	uint32_t count {0};
+
+	vkGetPhysicalDeviceProperties(physical_device, &properties);
+	if (properties.apiVersion < VK_API_VERSION_1_1)
+	{
+		return (false);
+	}
+	vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &count,
+		nullptr);
+
+	std::vector<VkExtensionProperties> available {count};
+	std::set<std::string> required {VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME,
+		VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME,
+		VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME};
+
+	vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &count,
+		available.data());
+	for (const VkExtensionProperties &extension : available)
+	{
+		required.erase(extension.extensionName);
+	}
+	if (!required.empty())
+	{
+		return (false);
+	}
+	dynamic_features.sType =
+		VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+	features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features.pNext = &dynamic_features;
+	vkGetPhysicalDeviceFeatures2(physical_device, &features);
+	return (dynamic_features.dynamicRendering);
+}
+
+/**
+ * Tells if the device reports its memory budget: VK_EXT_memory_budget, queried
+ * through Vulkan 1.1 physical device properties.
+ */
+bool Scop::supportsMemoryBudget(void)
+{
+	VkPhysicalDeviceProperties properties {};
+	uint32_t count {0};
+
+	vkGetPhysicalDeviceProperties(physical_device, &properties);
+	if (properties.apiVersion < VK_API_VERSION_1_1)
+	{
+		return (false);
+	}
+	vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &count,
+		nullptr);
+
+	std::vector<VkExtensionProperties> available {count};
+
+	vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &count,
+		available.data());
+	for (const VkExtensionProperties &extension : available)
+	{
+		if (!strcmp(extension.extensionName,
+			VK_EXT_MEMORY_BUDGET_EXTENSION_NAME))
+		{
+			return (true);
+		}
+	}
+	return (false);
+}
+
+/**
+ * Tells if the device supports VK_KHR_synchronization2, queried through
+ * Vulkan 1.1 physical device features, and has the feature.
+ */
+bool Scop::supportsSynchronization2(void)
+{
+	VkPhysicalDeviceProperties properties {};
+	VkPhysicalDeviceSynchronization2FeaturesKHR sync_features {};
+	VkPhysicalDeviceFeatures2 features {};
+	uint32_t count {0};
+	bool found {false};
+
+	vkGetPhysicalDeviceProperties(physical_device, &properties);
+	if (properties.apiVersion < VK_API_VERSION_1_1)
+	{
+		return (false);
+	}
+	vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &count,
+		nullptr);
+
+	std::vector<VkExtensionProperties> available {count};
+
+	vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &count,
+		available.data());
+	for (const VkExtensionProperties &extension : available)
+	{
+		found = found || !strcmp(extension.extensionName,
+			VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+	}
+	if (!found)
+	{
+		return (false);
+	}
+	sync_features.sType =
+		VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+	features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features.pNext = &sync_features;
+	vkGetPhysicalDeviceFeatures2(physical_device, &features);
+	return (sync_features.synchronization2);
+}
+
+/**
+ * Creates an instance of a logical device with timeline semaphores. Dynamic
+ * rendering is enabled when supported, unless --render-pass asks for the
+ * render pass path, and so are the memory budget and synchronization2, with
+ * which the render graph records its barriers. Device memory is then
+ * allocated through the budget, capped by --budget.
  */
 void Scop::createLogicalDevice(void)
 {
@@ -746,15 +1847,72 @@ void Scop::createLogicalDevice(void)
 	std::vector<VkDeviceQueueCreateInfo> queue_create_info {};
 	VkPhysicalDeviceFeatures features {};
 	Scop::QueueFamilyIndices indices {findQueueFamilies(physical_device)};
-
+	std::vector<const char *> extensions {
+		getDeviceExtensions(physical_device)};
+	VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timeline_features {};
+	VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamic_features {};
+	VkPhysicalDeviceSynchronization2FeaturesKHR sync_features {};
+	void *chain {nullptr};
+
+	dynamic_rendering = !options.render_pass && supportsDynamicRendering();
+	if (dynamic_rendering)
+	{
+		extensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+		extensions.push_back(VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME);
+		extensions.push_back(VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME);
+		dynamic_features.sType =
+			VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+		dynamic_features.dynamicRendering = VK_TRUE;
+		chain = &dynamic_features;
+	}
+	synchronization2 = supportsSynchronization2();
+	if (synchronization2)
+	{
+		extensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+		sync_features.sType =
+			VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+		sync_features.pNext = chain;
+		sync_features.synchronization2 = VK_TRUE;
+		chain = &sync_features;
+	}
+	memory_budget_ext = supportsMemoryBudget();
+	if (memory_budget_ext)
+	{
+		extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	}
 	setDeviceCreateInfo(create_info, queue_create_info, features, indices,
-		physical_device, device_extensions, validation_layers,
+		physical_device, extensions, validation_layers,
 		enableValidationLayers);
-	if (vkCreateDevice(physical_device, &create_info, nullptr, &device)
+	timeline_features.sType =
+		VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+	timeline_features.pNext = chain;
+	timeline_features.timelineSemaphore = VK_TRUE;
+	create_info.pNext = &timeline_features;
+	if (vkCreateDevice(physical_device, &create_info, allocator, &device)
 		 != VK_SUCCESS)
 	{
 		throw (Error("Scop::createLogicalDevice", "failed creation"));
 	}
+	wait_semaphores = reinterpret_cast<PFN_vkWaitSemaphoresKHR> (
+		vkGetDeviceProcAddr(device, "vkWaitSemaphoresKHR"));
+	get_semaphore_counter = reinterpret_cast<PFN_vkGetSemaphoreCounterValueKHR>
+		(vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValueKHR"));
+	if (dynamic_rendering)
+	{
+		cmd_begin_rendering = reinterpret_cast<PFN_vkCmdBeginRenderingKHR> (
+			vkGetDeviceProcAddr(device, "vkCmdBeginRenderingKHR"));
+		cmd_end_rendering = reinterpret_cast<PFN_vkCmdEndRenderingKHR> (
+			vkGetDeviceProcAddr(device, "vkCmdEndRenderingKHR"));
+	}
+	if (synchronization2)
+	{
+		cmd_pipeline_barrier2 = reinterpret_cast<PFN_vkCmdPipelineBarrier2KHR>
+			(vkGetDeviceProcAddr(device, "vkCmdPipelineBarrier2KHR"));
+	}
+	memory_budget = MemoryBudget(physical_device, device, allocator,
+		memory_budget_ext, static_cast<VkDeviceSize> (options.budget) << 20);
+	frame_capture = FrameCapture(device, allocator, &memory_budget, pool,
+		options.capture);
 	vkGetDeviceQueue(device, indices.graphic_family.value(), 0, &graphic_queue);
 	vkGetDeviceQueue(device, indices.present_family.value(), 0, &present_queue);
 }
@@ -782,7 +1940,7 @@ void Scop::createImageViews(void)
 		create_info.subresourceRange.levelCount = 1;
 		create_info.subresourceRange.baseArrayLayer = 0;
 		create_info.subresourceRange.layerCount = 1;
-		if (vkCreateImageView(device, &create_info, nullptr,
+		if (vkCreateImageView(device, &create_info, allocator,
 			&swapchain_image_view[i]) != VK_SUCCESS)
 		{
 			throw (Error("Scop::createImageViews", "failed image creation"));
@@ -791,7 +1949,8 @@ void Scop::createImageViews(void)
 }
 
 /**
- * Sets attachment description.
+ * Sets attachment description. The render graph moves the image in and out
+ * of the attachment layout, the render pass leaves it there.
  */
 VkAttachmentDescription Scop::setAttachmentDescription(void)
 {
@@ -802,8 +1961,8 @@ VkAttachmentDescription Scop::setAttachmentDescription(void)
 		.storeOp = VK_ATTACHMENT_STORE_OP_STORE,
 		.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
 		.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-		.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+		.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+		.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
 	});
 }
 
@@ -819,51 +1978,73 @@ VkAttachmentReference Scop::setAttachmentReference(void)
 }
 
 /**
- * Sets render subpass description.
+ * Sets depth attachment description. Depth is only needed during the pass so
+ * it is never stored. Its layout is set by the render graph.
  */
-VkSubpassDescription Scop::setSubpassDescription(VkAttachmentReference *ref)
+VkAttachmentDescription Scop::setDepthAttachmentDescription(void)
 {
-	return (VkSubpassDescription {
-		.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
-		.colorAttachmentCount = 1,
-		.pColorAttachments = ref
+	return (VkAttachmentDescription {
+		.format = depth_format,
+		.samples = VK_SAMPLE_COUNT_1_BIT,
+		.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+		.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+		.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+		.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+		.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+		.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+	});
+}
+
+/**
+ * Sets depth attachment reference.
+ */
+VkAttachmentReference Scop::setDepthAttachmentReference(void)
+{
+	return (VkAttachmentReference {
+		.attachment = 1,
+		.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
 	});
 }
 
 /**
- * Sets subpass dependency structure.
+ * Sets render subpass description.
  */
-VkSubpassDependency Scop::setSubpassDependency(void)
+VkSubpassDescription Scop::setSubpassDescription(VkAttachmentReference *ref,
+	VkAttachmentReference *depth_ref)
 {
-	return (VkSubpassDependency {
-		.srcSubpass = VK_SUBPASS_EXTERNAL,
-		.dstSubpass = 0,
-		.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-		.srcAccessMask = 0,
-		.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-		.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+	return (VkSubpassDescription {
+		.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+		.colorAttachmentCount = 1,
+		.pColorAttachments = ref,
+		.pDepthStencilAttachment = depth_ref
 	});
 }
 
 /**
- * Creates render pass.
+ * Creates render pass, only used without dynamic rendering. It has no
+ * dependency of its own, the barriers around it come from the render graph.
  */
 void Scop::createRenderPass(void)
 {
-	VkAttachmentDescription attachment {setAttachmentDescription()};
+	if (dynamic_rendering)
+	{
+		return ;
+	}
+
+	VkAttachmentDescription attachments[2] {setAttachmentDescription(),
+		setDepthAttachmentDescription()};
 	VkAttachmentReference color_attachment_ref {setAttachmentReference()};
-	VkSubpassDescription subpass {setSubpassDescription(&color_attachment_ref)};
-	VkSubpassDependency dependency {setSubpassDependency()};
+	VkAttachmentReference depth_attachment_ref {setDepthAttachmentReference()};
+	VkSubpassDescription subpass {setSubpassDescription(&color_attachment_ref,
+		&depth_attachment_ref)};
 	VkRenderPassCreateInfo create_info {};
 
-	create_info.dependencyCount = 1;
-	create_info.pDependencies = &dependency;
 	create_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-	create_info.attachmentCount = 1;
-	create_info.pAttachments = &attachment;
+	create_info.attachmentCount = 2;
+	create_info.pAttachments = attachments;
 	create_info.subpassCount = 1;
 	create_info.pSubpasses = &subpass;
-	if (vkCreateRenderPass(device, &create_info, nullptr, &render_pass)
+	if (vkCreateRenderPass(device, &create_info, allocator, &render_pass)
 		!= VK_SUCCESS)
 	{
 		throw (Error("Scop::createRenderPass", "failed creation"));
@@ -884,29 +2065,36 @@ VkPipelineShaderStageCreateInfo Scop::setVertexInfo(VkShaderModule &module)
 }
 
 /**
- * Sets the creation information for the fragment shader stage
+ * Sets the creation information for the fragment shader stage, with the
+ * values of its <specialization> constants.
  */
-VkPipelineShaderStageCreateInfo Scop::setFragmentInfo(VkShaderModule &module)
+VkPipelineShaderStageCreateInfo Scop::setFragmentInfo(VkShaderModule &module,
+	const VkSpecializationInfo *specialization)
 {
 	return (VkPipelineShaderStageCreateInfo {
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
 		.stage = VK_SHADER_STAGE_FRAGMENT_BIT,
 		.module = module,
-		.pName = "main"
+		.pName = "main",
+		.pSpecializationInfo = specialization
 	});
 }
 
 /**
  * Sets the vertex input state create info structure.
  */
-VkPipelineVertexInputStateCreateInfo Scop::setVertexInput(void)
+VkPipelineVertexInputStateCreateInfo Scop::setVertexInput(
+	std::vector<VkVertexInputBindingDescription> &bindings,
+	std::vector<VkVertexInputAttributeDescription> &attributes)
 {
 	return (VkPipelineVertexInputStateCreateInfo {
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-		.vertexBindingDescriptionCount = 0,
-		.pVertexBindingDescriptions = nullptr,
-		.vertexAttributeDescriptionCount = 0,
-		.pVertexAttributeDescriptions = nullptr
+		.vertexBindingDescriptionCount =
+			static_cast<uint32_t> (bindings.size()),
+		.pVertexBindingDescriptions = bindings.data(),
+		.vertexAttributeDescriptionCount =
+			static_cast<uint32_t> (attributes.size()),
+		.pVertexAttributeDescriptions = attributes.data()
 	});
 }
 
@@ -960,9 +2148,11 @@ VkPipelineViewportStateCreateInfo Scop::setViewportState(void)
 }
 
 /**
- * Sets the rasterization state create info structure.
+ * Sets the rasterization state create info structure, culling the <cull>
+ * faces.
  */
-VkPipelineRasterizationStateCreateInfo Scop::setRasterizer(void)
+VkPipelineRasterizationStateCreateInfo Scop::setRasterizer(
+	VkCullModeFlags cull)
 {
 	return (VkPipelineRasterizationStateCreateInfo {
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
@@ -970,8 +2160,8 @@ VkPipelineRasterizationStateCreateInfo Scop::setRasterizer(void)
 		.rasterizerDiscardEnable = VK_FALSE,
 		.polygonMode = VK_POLYGON_MODE_FILL,
 		.lineWidth = 1.0f,
-		.cullMode = VK_CULL_MODE_BACK_BIT,
-		.frontFace = VK_FRONT_FACE_CLOCKWISE,
+		.cullMode = cull,
+		.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
 		.depthBiasEnable = VK_FALSE,
 		.depthBiasConstantFactor = 0.0f,
 		.depthBiasClamp = 0.0f,
@@ -980,14 +2170,15 @@ VkPipelineRasterizationStateCreateInfo Scop::setRasterizer(void)
 }
 
 /**
- * Sets the multisampling create info structure.
+ * Sets the multisampling create info structure for <samples> per pixel.
  */
-VkPipelineMultisampleStateCreateInfo Scop::setMultisampling(void)
+VkPipelineMultisampleStateCreateInfo Scop::setMultisampling(
+	VkSampleCountFlagBits samples)
 {
 	return (VkPipelineMultisampleStateCreateInfo {
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
 		.sampleShadingEnable = VK_FALSE,
-		.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+		.rasterizationSamples = samples,
 		.minSampleShading = 1.0f,
 		.pSampleMask = nullptr,
 		.alphaToCoverageEnable = VK_FALSE,
@@ -996,18 +2187,39 @@ VkPipelineMultisampleStateCreateInfo Scop::setMultisampling(void)
 }
 
 /**
- * Sets the color blend attachment state structure.
+ * Sets the depth stencil state create info structure.
+ */
+VkPipelineDepthStencilStateCreateInfo Scop::setDepthStencil(
+	VkCompareOp compare, bool write)
+{
+	return (VkPipelineDepthStencilStateCreateInfo {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+		.depthTestEnable = VK_TRUE,
+		.depthWriteEnable = write ? VK_TRUE : VK_FALSE,
+		.depthCompareOp = compare,
+		.depthBoundsTestEnable = VK_FALSE,
+		.stencilTestEnable = VK_FALSE,
+		.minDepthBounds = 0.0f,
+		.maxDepthBounds = 1.0f
+	});
+}
+
+/**
+ * Sets the color blend attachment state structure, with alpha blending if
+ * <blend> is set.
  */
-VkPipelineColorBlendAttachmentState Scop::setColorBlendAttachment(void)
+VkPipelineColorBlendAttachmentState Scop::setColorBlendAttachment(bool blend)
 {
 	return (VkPipelineColorBlendAttachmentState {
 		.colorWriteMask = VK_COLOR_COMPONENT_R_BIT
 			| VK_COLOR_COMPONENT_G_BIT
 			| VK_COLOR_COMPONENT_B_BIT
 			| VK_COLOR_COMPONENT_A_BIT,
-		.blendEnable = VK_FALSE,
-		.srcColorBlendFactor = VK_BLEND_FACTOR_ONE,
-		.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO,
+		.blendEnable = blend ? VK_TRUE : VK_FALSE,
+		.srcColorBlendFactor = blend ? VK_BLEND_FACTOR_SRC_ALPHA
+			: VK_BLEND_FACTOR_ONE,
+		.dstColorBlendFactor = blend ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA
+			: VK_BLEND_FACTOR_ZERO,
 		.colorBlendOp = VK_BLEND_OP_ADD,
 		.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
 		.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
@@ -1035,19 +2247,20 @@ VkPipelineColorBlendStateCreateInfo Scop::setColorBlend(
 }
 
 /**
- * Creates shader module based on compiled shader bytecode.
+ * Creates shader module based on compiled shader bytecode, read from the
+ * override file it was loaded from or straight from the built-in words.
  */
-VkShaderModule Scop::createShaderModule(const std::vector<char> &code)
+VkShaderModule Scop::createShaderModule(const ShaderCode &code)
 {
 	VkShaderModuleCreateInfo create_info {};
 
 	create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	create_info.codeSize = code.size();
-	create_info.pCode = reinterpret_cast<const uint32_t *> (code.data());
+	create_info.codeSize = code.size * sizeof(uint32_t);
+	create_info.pCode = code.file.empty() ? code.words : code.file.data();
 
 	VkShaderModule shader_module {};
 
-	if (vkCreateShaderModule(device, &create_info, nullptr, &shader_module)
+	if (vkCreateShaderModule(device, &create_info, allocator, &shader_module)
 		!= VK_SUCCESS)
 	{
 		throw (Error("Scop::createSaderModule", "failed creation"));
@@ -1056,18 +2269,23 @@ VkShaderModule Scop::createShaderModule(const std::vector<char> &code)
 }
 
 /**
- * Creates pipeline layout and sets the handle.
+ * Creates pipeline layout and sets the handle. The transforms are pushed as
+ * constants to the vertex stage, the texture is in descriptor set 0.
  */
 void Scop::createPipelineLayout(void)
 {
 	VkPipelineLayoutCreateInfo pipeline_layout_info {};
+	VkPushConstantRange range {};
 
+	range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	range.offset = 0;
+	range.size = sizeof(Transform);
 	pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipeline_layout_info.setLayoutCount = 0;
-	pipeline_layout_info.pSetLayouts = nullptr;
-	pipeline_layout_info.pushConstantRangeCount = 0;
-	pipeline_layout_info.pPushConstantRanges = nullptr;
-	if (vkCreatePipelineLayout(device, &pipeline_layout_info, nullptr,
+	pipeline_layout_info.setLayoutCount = 1;
+	pipeline_layout_info.pSetLayouts = &descriptor_layout;
+	pipeline_layout_info.pushConstantRangeCount = 1;
+	pipeline_layout_info.pPushConstantRanges = &range;
+	if (vkCreatePipelineLayout(device, &pipeline_layout_info, allocator,
 		&pipeline_layout) != VK_SUCCESS)
 	{
 		throw (Error("Scop::createGraphicsPipeline", "failed pipeline layout"));
@@ -1076,7 +2294,8 @@ void Scop::createPipelineLayout(void)
 
 /**
  * Assembles the graphics pipeline create info with all previously created
- * structures and create the actual pipeline.
+ * structures and create the actual pipeline. With dynamic rendering, the
+ * attachment formats replace the render pass.
  */
 void Scop::assembleGraphicsPipeline(
 	VkPipelineShaderStageCreateInfo        *shader_stages,
@@ -1086,20 +2305,28 @@ void Scop::assembleGraphicsPipeline(
 	VkPipelineViewportStateCreateInfo      &viewport_state,
 	VkPipelineRasterizationStateCreateInfo &rasterizer,
 	VkPipelineMultisampleStateCreateInfo   &multisampling,
-	VkPipelineColorBlendStateCreateInfo    &color_blend)
+	VkPipelineDepthStencilStateCreateInfo  &depth_stencil,
+	VkPipelineColorBlendStateCreateInfo    &color_blend,
+	uint32_t                               stage_count,
+	VkPipeline                             &pipeline)
 {
 	VkGraphicsPipelineCreateInfo pipeline_info {};
+	VkPipelineRenderingCreateInfoKHR rendering_info {};
 
-	createPipelineLayout();
+	rendering_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+	rendering_info.colorAttachmentCount = 1;
+	rendering_info.pColorAttachmentFormats = &swapchain_image_format;
+	rendering_info.depthAttachmentFormat = depth_format;
 	pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-	pipeline_info.stageCount = 2;
+	pipeline_info.pNext = dynamic_rendering ? &rendering_info : nullptr;
+	pipeline_info.stageCount = stage_count;
 	pipeline_info.pStages = shader_stages;
 	pipeline_info.pVertexInputState = &vertex_input;
 	pipeline_info.pInputAssemblyState = &input_assembly;
 	pipeline_info.pViewportState = &viewport_state;
 	pipeline_info.pRasterizationState = &rasterizer;
 	pipeline_info.pMultisampleState = &multisampling;
-	pipeline_info.pDepthStencilState = nullptr;
+	pipeline_info.pDepthStencilState = &depth_stencil;
 	pipeline_info.pColorBlendState = &color_blend;
 	pipeline_info.pDynamicState = &dynamic_state;
 	pipeline_info.layout = pipeline_layout;
@@ -1108,59 +2335,184 @@ void Scop::assembleGraphicsPipeline(
 	pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
 	pipeline_info.basePipelineIndex = -1;
 	if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipeline_info,
-		nullptr, &graphics_pipeline) != VK_SUCCESS)
+		allocator, &pipeline) != VK_SUCCESS)
 	{
 		throw (Error("Scop::assembleGraphicsPipeline", "failed pipeline"));
 	}
 }
 
 /**
- * Creates the graphic pipeline used to process images.
+ * Vertex bindings: positions alone in binding 0 so the depth pre-pass fetches
+ * as little as possible, the other attributes in binding 1.
+ */
+std::vector<VkVertexInputBindingDescription> Scop::getBindingDescriptions(
+	bool position_only)
+{
+	std::vector<VkVertexInputBindingDescription> bindings {
+		VkVertexInputBindingDescription {
+			.binding = 0,
+			.stride = sizeof(Vec3),
+			.inputRate = VK_VERTEX_INPUT_RATE_VERTEX
+		}
+	};
+
+	if (!position_only)
+	{
+		bindings.push_back(VkVertexInputBindingDescription {
+			.binding = 1,
+			.stride = sizeof(Mesh::Attributes),
+			.inputRate = VK_VERTEX_INPUT_RATE_VERTEX
+		});
+	}
+	return (bindings);
+}
+
+/**
+ * Vertex attributes matching the bindings: position, normal and texture
+ * coordinates.
+ */
+std::vector<VkVertexInputAttributeDescription> Scop::getAttributeDescriptions(
+	bool position_only)
+{
+	std::vector<VkVertexInputAttributeDescription> attributes {
+		VkVertexInputAttributeDescription {
+			.location = 0,
+			.binding = 0,
+			.format = VK_FORMAT_R32G32B32_SFLOAT,
+			.offset = 0
+		}
+	};
+
+	if (!position_only)
+	{
+		attributes.push_back(VkVertexInputAttributeDescription {
+			.location = 1,
+			.binding = 1,
+			.format = VK_FORMAT_R32G32B32_SFLOAT,
+			.offset = offsetof(Mesh::Attributes, normal)
+		});
+		attributes.push_back(VkVertexInputAttributeDescription {
+			.location = 2,
+			.binding = 1,
+			.format = VK_FORMAT_R32G32_SFLOAT,
+			.offset = offsetof(Mesh::Attributes, uv)
+		});
+	}
+	return (attributes);
+}
+
+/**
+ * Creates the shader modules every pipeline variant is compiled from, and
+ * the variant cache itself.
+ */
+void Scop::createShaderModules(void)
+{
+	vert_module = createShaderModule(vert_code);
+	frag_module = createShaderModule(frag_code);
+	depth_module = createShaderModule(depth_code);
+	pipelines = PipelineVariants(device, allocator, [this](
+		const PipelineVariants::Key &key) { return (createPipeline(key)); });
+}
+
+/**
+ * Compiles the pipeline of the variant <key>. The fragment stage is a single
+ * uber-shader whose shading mode and blending are specialization constants,
+ * so each variant only keeps its own path. The position layout is the
+ * depth-only pipeline of the pre-pass: vertex stage only, position stream
+ * only and no color writes. Its vertex shader computes gl_Position exactly
+ * as the main one so that EQUAL tests pass.
  */
-void Scop::createGraphicsPipeline(void)
+VkPipeline Scop::createPipeline(const PipelineVariants::Key &key)
 {
-	std::vector<char> vert_shader_code {readFile("shaders/vert.spv")};
-	std::vector<char> frag_shader_code {readFile("shaders/frag.spv")};
-	VkShaderModule vert_module {createShaderModule(vert_shader_code)};
-	VkShaderModule frag_module {createShaderModule(frag_shader_code)};
-	VkPipelineShaderStageCreateInfo vert_info {setVertexInfo(vert_module)};
-	VkPipelineShaderStageCreateInfo frag_info {setFragmentInfo(frag_module)};
-	VkPipelineShaderStageCreateInfo shader_stages[2] {vert_info, frag_info};
-	VkPipelineVertexInputStateCreateInfo vertex_input {setVertexInput()};
+	bool position_only {key.layout == PipelineVariants::POSITION};
+	FragmentConstants constants {
+		.shading = static_cast<int32_t> (key.shading),
+		.blend = key.blend == PipelineVariants::ALPHA ? VK_TRUE : VK_FALSE
+	};
+	VkSpecializationMapEntry entries[2] {
+		{0, offsetof(FragmentConstants, shading), sizeof(int32_t)},
+		{1, offsetof(FragmentConstants, blend), sizeof(VkBool32)}
+	};
+	VkSpecializationInfo specialization {2, entries, sizeof(constants),
+		&constants};
+	VkPipelineShaderStageCreateInfo shader_stages[2] {
+		setVertexInfo(position_only ? depth_module : vert_module),
+		setFragmentInfo(frag_module, &specialization)};
+	std::vector<VkVertexInputBindingDescription> bindings {
+		getBindingDescriptions(position_only)};
+	std::vector<VkVertexInputAttributeDescription> attributes {
+		getAttributeDescriptions(position_only)};
+	VkPipelineVertexInputStateCreateInfo vertex_input {
+		setVertexInput(bindings, attributes)};
 	VkPipelineInputAssemblyStateCreateInfo input_assembly {setInputAssembly()};
 	std::vector<VkDynamicState> states {setDynamicStates()};
 	VkPipelineDynamicStateCreateInfo dynamic_state {setDynamicState(states)};
 	VkPipelineViewportStateCreateInfo viewport_state {setViewportState()};
-	VkPipelineRasterizationStateCreateInfo rasterizer {setRasterizer()};
-	VkPipelineMultisampleStateCreateInfo multisampling {setMultisampling()};
-	VkPipelineColorBlendAttachmentState blend {setColorBlendAttachment()};
+	VkPipelineRasterizationStateCreateInfo rasterizer {
+		setRasterizer(key.cull)};
+	VkPipelineMultisampleStateCreateInfo multisampling {
+		setMultisampling(key.samples)};
+	VkPipelineColorBlendAttachmentState blend {setColorBlendAttachment(
+		key.blend == PipelineVariants::ALPHA)};
+
+	if (position_only)
+	{
+		blend.colorWriteMask = 0;
+	}
+
 	VkPipelineColorBlendStateCreateInfo color_blend {setColorBlend(blend)};
-	
+	VkPipelineDepthStencilStateCreateInfo depth_stencil {
+		key.depth == PipelineVariants::EQUAL
+		? setDepthStencil(VK_COMPARE_OP_EQUAL, false)
+		: setDepthStencil(VK_COMPARE_OP_LESS, true)};
+	VkPipeline pipeline {VK_NULL_HANDLE};
+
 	assembleGraphicsPipeline(shader_stages, vertex_input, input_assembly,
-		dynamic_state, viewport_state, rasterizer, multisampling, color_blend);
-	vkDestroyShaderModule(device, vert_module, nullptr);
-	vkDestroyShaderModule(device, frag_module, nullptr);
+		dynamic_state, viewport_state, rasterizer, multisampling, depth_stencil,
+		color_blend, position_only ? 1 : 2, pipeline);
+	return (pipeline);
+}
+
+/**
+ * Variant of the depth pre-pass matching the current one: same culling and
+ * sample count, so that both passes rasterize the same fragments.
+ */
+PipelineVariants::Key Scop::getDepthVariant(void)
+{
+	return (PipelineVariants::Key {
+		.layout = PipelineVariants::POSITION,
+		.shading = PipelineVariants::LIT,
+		.cull = variant.cull,
+		.blend = PipelineVariants::OPAQUE,
+		.samples = variant.samples,
+		.depth = PipelineVariants::LESS
+	});
 }
 
 /**
  * Creates framebuffers linked to swapchain image views from the render pass.
+ * Dynamic rendering binds the views directly and needs none.
  */
 void Scop::createFramebuffers(void)
 {
+	if (dynamic_rendering)
+	{
+		return ;
+	}
 	swapchain_framebuffers.resize(swapchain_image_view.size());
 	for (size_t i = 0; i < swapchain_image_view.size(); ++i)
 	{
-		VkImageView attachments[] {swapchain_image_view[i]};
+		VkImageView attachments[] {swapchain_image_view[i], depth_image_view};
 		VkFramebufferCreateInfo create_info {};
 
 		create_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
 		create_info.renderPass = render_pass;
-		create_info.attachmentCount = 1;
+		create_info.attachmentCount = 2;
 		create_info.pAttachments = attachments;
 		create_info.width = swapchain_extent.width;
 		create_info.height = swapchain_extent.height;
 		create_info.layers = 1;
-		if (vkCreateFramebuffer(device, &create_info, nullptr,
+		if (vkCreateFramebuffer(device, &create_info, allocator,
 			&swapchain_framebuffers[i]) != VK_SUCCESS)
 		{
 			throw (Error("Scop::createFramebuffers", "failed creation"));
@@ -1179,7 +2531,7 @@ void Scop::createCommandPool(void)
 	create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
 	create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 	create_info.queueFamilyIndex = indices.graphic_family.value();
-	if (vkCreateCommandPool(device, &create_info, nullptr, &command_pool)
+	if (vkCreateCommandPool(device, &create_info, allocator, &command_pool)
 		!= VK_SUCCESS)
 	{
 		throw (Error("Scop::createCommandPool", "failed creation"));
@@ -1187,13 +2539,1415 @@ void Scop::createCommandPool(void)
 }
 
 /**
- * Creates a command buffer.
+ * Creates a buffer of <size> bytes and binds it to newly allocated memory.
  */
-void Scop::createCommandBuffers(void)
+void Scop::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
+	VkMemoryPropertyFlags properties, VkBuffer &buffer, VkDeviceMemory &memory)
 {
-	VkCommandBufferAllocateInfo info {};
-
-	command_buffer.resize(max_frame_in_flight);
+	VkBufferCreateInfo create_info {};
+	VkMemoryRequirements requirements {};
+
+	create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	create_info.size = size;
+	create_info.usage = usage;
+	create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	if (vkCreateBuffer(device, &create_info, allocator, &buffer) != VK_SUCCESS)
+	{
+		throw (Error("Scop::createBuffer", "failed creation"));
+	}
+	vkGetBufferMemoryRequirements(device, buffer, &requirements);
+	if (memory_budget.allocate(requirements, properties, memory)
+		!= VK_SUCCESS)
+	{
+		throw (Error("Scop::createBuffer", "failed allocation"));
+	}
+	vkBindBufferMemory(device, buffer, memory, 0);
+}
+
+/**
+ * Allocates and begins a one time command buffer.
+ */
+VkCommandBuffer Scop::beginSingleTimeCommands(void)
+{
+	VkCommandBufferAllocateInfo alloc_info {};
+	VkCommandBuffer buf {};
+	VkCommandBufferBeginInfo begin_info {setBufferBeginInfo()};
+
+	alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	alloc_info.commandPool = command_pool;
+	alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	alloc_info.commandBufferCount = 1;
+	if (vkAllocateCommandBuffers(device, &alloc_info, &buf) != VK_SUCCESS)
+	{
+		throw (Error("Scop::beginSingleTimeCommands", "failed allocation"));
+	}
+	begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(buf, &begin_info);
+	return (buf);
+}
+
+/**
+ * Ends and submits the one time command buffer <buf>, waits for it to be done
+ * and frees it. Only meant for loading time. The submission signals the next
+ * timeline value so only this work is waited for, not the whole queue.
+ */
+void Scop::endSingleTimeCommands(VkCommandBuffer buf)
+{
+	VkSubmitInfo submit {};
+	VkTimelineSemaphoreSubmitInfoKHR values {};
+	uint64_t value {timeline_value + 1};
+
+	vkEndCommandBuffer(buf);
+	values.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+	values.signalSemaphoreValueCount = 1;
+	values.pSignalSemaphoreValues = &value;
+	submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit.pNext = &values;
+	submit.commandBufferCount = 1;
+	submit.pCommandBuffers = &buf;
+	submit.signalSemaphoreCount = 1;
+	submit.pSignalSemaphores = &timeline;
+	if (vkQueueSubmit(graphic_queue, 1, &submit, VK_NULL_HANDLE) != VK_SUCCESS)
+	{
+		throw (Error("Scop::endSingleTimeCommands", "failed submition"));
+	}
+	timeline_value = value;
+	waitTimeline(value);
+	vkFreeCommandBuffers(device, command_pool, 1, &buf);
+}
+
+/**
+ * Copies <size> bytes from <src> to <dst> and waits for the copy to be done.
+ */
+void Scop::copyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size)
+{
+	VkCommandBuffer buf {beginSingleTimeCommands()};
+	VkBufferCopy region {};
+
+	region.size = size;
+	vkCmdCopyBuffer(buf, src, dst, 1, &region);
+	endSingleTimeCommands(buf);
+}
+
+/**
+ * Creates a device local buffer filled with <size> bytes of <data> through a
+ * host visible staging buffer.
+ */
+void Scop::createDeviceLocalBuffer(const void *data, VkDeviceSize size,
+	VkBufferUsageFlags usage, VkBuffer &buffer, VkDeviceMemory &memory)
+{
+	VkBuffer staging {};
+	VkDeviceMemory staging_memory {};
+	void *mapped {nullptr};
+
+	createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+			| VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging, staging_memory);
+	vkMapMemory(device, staging_memory, 0, size, 0, &mapped);
+	std::memcpy(mapped, data, static_cast<size_t> (size));
+	vkUnmapMemory(device, staging_memory);
+	createBuffer(size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, memory);
+	copyBuffer(staging, buffer, size);
+	vkDestroyBuffer(device, staging, allocator);
+	memory_budget.free(staging_memory);
+}
+
+/**
+ * Creates a host visible buffer filled with <size> bytes of <data>, which the
+ * GPU reads over the bus, or copies from once it pages back in.
+ */
+void Scop::createHostBuffer(const void *data, VkDeviceSize size,
+	VkBufferUsageFlags usage, VkBuffer &buffer, VkDeviceMemory &memory)
+{
+	void *mapped {nullptr};
+
+	createBuffer(size, usage | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+		| VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, buffer, memory);
+	if (vkMapMemory(device, memory, 0, size, 0, &mapped) != VK_SUCCESS)
+	{
+		throw (Error("Scop::createHostBuffer", "failed mapping"));
+	}
+	std::memcpy(mapped, data, static_cast<size_t> (size));
+	vkUnmapMemory(device, memory);
+}
+
+/**
+ * Uploads the mesh: the position stream, the attribute stream and the indices
+ * each get their own buffer, device local if <device_local> is set or left in
+ * host memory otherwise.
+ */
+void Scop::uploadMesh(bool device_local)
+{
+	const std::vector<Vec3> &positions {mesh.getPositions()};
+	const std::vector<Mesh::Attributes> &attributes {mesh.getAttributes()};
+	const std::vector<uint32_t> &indices {mesh.getIndices()};
+	auto upload {device_local ? &Scop::createDeviceLocalBuffer
+		: &Scop::createHostBuffer};
+
+	(this->*upload)(positions.data(), positions.size() * sizeof(Vec3),
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, position_buffer, position_memory);
+	(this->*upload)(attributes.data(),
+		attributes.size() * sizeof(Mesh::Attributes),
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, attribute_buffer, attribute_memory);
+	(this->*upload)(indices.data(), indices.size() * sizeof(uint32_t),
+		VK_BUFFER_USAGE_INDEX_BUFFER_BIT, index_buffer, index_memory);
+	mesh_resident = device_local;
+	index_count = static_cast<uint32_t> (indices.size());
+}
+
+/**
+ * Retires the buffers of the mesh, so that a new upload replaces them while
+ * frames in flight still draw from the old ones.
+ */
+void Scop::retireMesh(void)
+{
+	VkBuffer buffers[] {position_buffer, attribute_buffer, index_buffer};
+	VkDeviceMemory memories[] {position_memory, attribute_memory,
+		index_memory};
+
+	for (VkDeviceMemory memory : memories)
+	{
+		memory_budget.retire(memory);
+	}
+	retire([this, buffers, memories](void)
+		{
+			for (size_t i {0}; i < 3; ++i)
+			{
+				vkDestroyBuffer(device, buffers[i], allocator);
+				memory_budget.free(memories[i]);
+			}
+		});
+}
+
+/**
+ * Uploads the mesh to device local buffers. A mesh still being parsed gets
+ * them from its stream instead.
+ */
+void Scop::createVertexBuffers(void)
+{
+	if (mesh_stream.active)
+	{
+		return ;
+	}
+	uploadMesh(true);
+}
+
+/**
+ * Copies <size> bytes of <data> to the staging ring at <ring_offset> and
+ * records their copy to <dst> at <dst_offset>.
+ */
+void Scop::stageUpload(VkCommandBuffer buf, const void *data,
+	VkDeviceSize size, VkDeviceSize ring_offset, VkBuffer dst,
+	VkDeviceSize dst_offset)
+{
+	VkBufferCopy region {ring_offset, dst_offset, size};
+
+	if (size == 0)
+	{
+		return ;
+	}
+	std::memcpy(staging_ring_data + ring_offset, data, size);
+	vkCmdCopyBuffer(buf, staging_ring, dst, 1, &region);
+}
+
+/**
+ * Makes the device local <buffer> hold at least <size> bytes, doubling its
+ * <capacity> if it doesn't. The <used> bytes it holds are copied over on the
+ * GPU and the previous buffer is retired.
+ */
+void Scop::growMeshBuffer(VkCommandBuffer buf, VkDeviceSize size,
+	VkDeviceSize used, VkBufferUsageFlags usage, VkBuffer &buffer,
+	VkDeviceMemory &memory, VkDeviceSize &capacity)
+{
+	VkBuffer grown {VK_NULL_HANDLE};
+	VkDeviceMemory grown_memory {VK_NULL_HANDLE};
+
+	if (size <= capacity)
+	{
+		return ;
+	}
+	capacity = std::max(size, capacity * 2);
+	createBuffer(capacity, usage | VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+		| VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, grown, grown_memory);
+	if (used)
+	{
+		VkMemoryBarrier barrier {};
+		VkBufferCopy region {0, 0, used};
+
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0,
+			nullptr);
+		vkCmdCopyBuffer(buf, buffer, grown, 1, &region);
+	}
+	if (buffer != VK_NULL_HANDLE)
+	{
+		memory_budget.retire(memory);
+		retire([this, buffer = buffer, memory = memory](void)
+			{
+				vkDestroyBuffer(device, buffer, allocator);
+				memory_budget.free(memory);
+			});
+	}
+	buffer = grown;
+	memory = grown_memory;
+}
+
+/**
+ * Records the upload of the chunks parsed so far, as many whole ones as fit
+ * in the staging ring slice of the frame, appended to the mesh buffers which
+ * grow as needed. Draws cover every uploaded index, whose vertices always
+ * come in the same chunk or before. Once the parse is over, the attributes
+ * the mesh computed replace the provisional ones the same way, after the
+ * vertex input of the frames in flight drawing them. Returns the bytes of
+ * the slice used, the rest is left to the texture.
+ */
+VkDeviceSize Scop::pollMesh(VkCommandBuffer buf)
+{
+	VkDeviceSize ring_offset {static_cast<VkDeviceSize> (SCOP_UPLOAD_BUDGET)
+		* curr_frame};
+	VkDeviceSize used {0};
+
+	if (!mesh_stream.active)
+	{
+		return (0);
+	}
+
+	bool parsed {!mesh_load.valid() || mesh_load.wait_for(
+		std::chrono::seconds(0)) == std::future_status::ready};
+
+	while (mesh_stream.pending || mesh_chunks.pop(mesh_stream.chunk))
+	{
+		const Mesh::Chunk &chunk {mesh_stream.chunk};
+		VkDeviceSize position_size {chunk.positions.size() * sizeof(Vec3)};
+		VkDeviceSize attribute_size {chunk.attributes.size()
+			* sizeof(Mesh::Attributes)};
+		VkDeviceSize index_size {chunk.indices.size() * sizeof(uint32_t)};
+
+		mesh_stream.pending = true;
+		if (position_size + attribute_size + index_size > SCOP_UPLOAD_BUDGET)
+		{
+			throw (Error("Scop::pollMesh", "chunk larger than upload budget"));
+		}
+		if (used + position_size + attribute_size + index_size
+			> SCOP_UPLOAD_BUDGET)
+		{
+			break ;
+		}
+		growMeshBuffer(buf, chunk.first_vertex * sizeof(Vec3) + position_size,
+			chunk.first_vertex * sizeof(Vec3),
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, position_buffer,
+			position_memory, mesh_stream.position_capacity);
+		growMeshBuffer(buf, chunk.first_vertex * sizeof(Mesh::Attributes)
+			+ attribute_size, chunk.first_vertex * sizeof(Mesh::Attributes),
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, attribute_buffer,
+			attribute_memory, mesh_stream.attribute_capacity);
+		growMeshBuffer(buf, chunk.first_index * sizeof(uint32_t) + index_size,
+			chunk.first_index * sizeof(uint32_t),
+			VK_BUFFER_USAGE_INDEX_BUFFER_BIT, index_buffer, index_memory,
+			mesh_stream.index_capacity);
+		stageUpload(buf, chunk.positions.data(), position_size,
+			ring_offset + used, position_buffer,
+			chunk.first_vertex * sizeof(Vec3));
+		used += position_size;
+		stageUpload(buf, chunk.attributes.data(), attribute_size,
+			ring_offset + used, attribute_buffer,
+			chunk.first_vertex * sizeof(Mesh::Attributes));
+		used += attribute_size;
+		stageUpload(buf, chunk.indices.data(), index_size,
+			ring_offset + used, index_buffer,
+			chunk.first_index * sizeof(uint32_t));
+		used += index_size;
+		if (index_count == 0)
+		{
+			mesh_stream.first_ms = std::chrono::duration<double, std::milli> (
+				std::chrono::steady_clock::now() - startup).count();
+		}
+		mesh_stream.vertex_count = chunk.first_vertex
+			+ chunk.positions.size();
+		index_count = chunk.first_index + chunk.indices.size();
+		load_percent.store(std::min(static_cast<uint32_t> (chunk.progress
+			* 100.0f), 99u), std::memory_order_relaxed);
+		frameBounds(chunk.bounds);
+		mesh_stream.pending = false;
+	}
+	if (!mesh_stream.pending && parsed)
+	{
+		if (mesh_load.valid())
+		{
+			mesh_load.get();
+			frameBounds(mesh.getBounds());
+			mesh_stream.refreshed = mesh.hasGeneratedAttributes() ? 0
+				: mesh_stream.vertex_count;
+		}
+
+		uint32_t count {static_cast<uint32_t> (std::min<VkDeviceSize> (
+			mesh_stream.vertex_count - mesh_stream.refreshed,
+			(SCOP_UPLOAD_BUDGET - used) / sizeof(Mesh::Attributes)))};
+
+		if (count)
+		{
+			VkMemoryBarrier barrier {};
+
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0,
+				nullptr);
+		}
+		stageUpload(buf, mesh.getAttributes().data() + mesh_stream.refreshed,
+			count * sizeof(Mesh::Attributes), ring_offset + used,
+			attribute_buffer, mesh_stream.refreshed * sizeof(Mesh::Attributes));
+		used += count * sizeof(Mesh::Attributes);
+		mesh_stream.refreshed += count;
+		if (mesh_stream.refreshed == mesh_stream.vertex_count)
+		{
+			mesh_stream.active = false;
+			load_percent.store(100, std::memory_order_relaxed);
+			reportMesh();
+		}
+	}
+	if (used)
+	{
+		VkMemoryBarrier barrier {};
+
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT
+			| VK_ACCESS_INDEX_READ_BIT;
+		vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0, nullptr, 0,
+			nullptr);
+	}
+	return (used);
+}
+
+/**
+ * Records the page in of the mesh evicted to host memory, if one is due: its
+ * host buffers are copied to new device local ones on the GPU, which this
+ * frame already draws from, and retired with the frame, so the render thread
+ * never waits for the copy.
+ */
+void Scop::pageInMesh(VkCommandBuffer buf)
+{
+	VkBuffer *buffers[] {&position_buffer, &attribute_buffer, &index_buffer};
+	VkDeviceMemory *memories[] {&position_memory, &attribute_memory,
+		&index_memory};
+	VkBuffer sources[] {position_buffer, attribute_buffer, index_buffer};
+	VkDeviceSize sizes[] {mesh.getPositions().size() * sizeof(Vec3),
+		mesh.getAttributes().size() * sizeof(Mesh::Attributes),
+		mesh.getIndices().size() * sizeof(uint32_t)};
+	VkBufferUsageFlags usages[] {VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_BUFFER_USAGE_INDEX_BUFFER_BIT};
+	VkMemoryBarrier barrier {};
+
+	if (!mesh_page_in)
+	{
+		return ;
+	}
+	mesh_page_in = false;
+	retireMesh();
+	for (size_t i {0}; i < 3; ++i)
+	{
+		VkBufferCopy region {0, 0, sizes[i]};
+
+		createBuffer(sizes[i], usages[i] | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, *buffers[i], *memories[i]);
+		vkCmdCopyBuffer(buf, sources[i], *buffers[i], 1, &region);
+	}
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT
+		| VK_ACCESS_INDEX_READ_BIT;
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0, nullptr, 0,
+		nullptr);
+	mesh_resident = true;
+	if (options.report)
+	{
+		std::cerr << "mesh paged in" << std::endl;
+	}
+}
+
+/**
+ * With --report, writes when the first triangles of a streamed mesh were
+ * drawn and when all of them were.
+ */
+void Scop::reportMesh(void)
+{
+	if (!options.report)
+	{
+		return ;
+	}
+	std::cerr << "mesh " << index_count / 3 << " triangles streamed, first "
+		<< "drawn after " << mesh_stream.first_ms << " ms, all after "
+		<< std::chrono::duration<double, std::milli> (
+			std::chrono::steady_clock::now() - startup).count() << " ms"
+		<< std::endl;
+}
+
+/**
+ * Picks the first depth format usable as an optimal tiling depth attachment,
+ * preferring plain 32 bits float depth.
+ */
+VkFormat Scop::findDepthFormat(void)
+{
+	const VkFormat candidates[] {VK_FORMAT_D32_SFLOAT,
+		VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT};
+
+	for (const VkFormat &format : candidates)
+	{
+		VkFormatProperties properties {};
+
+		vkGetPhysicalDeviceFormatProperties(physical_device, format,
+			&properties);
+		if (properties.optimalTilingFeatures
+			& VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
+		{
+			return (format);
+		}
+	}
+	throw (Error("Scop::findDepthFormat", "no supported depth format"));
+}
+
+/**
+ * Creates a 2D optimal tiling image of <mip_levels> levels bound to newly
+ * allocated device local memory, or host memory once device local memory is
+ * exhausted.
+ */
+void Scop::createImage(uint32_t width, uint32_t height, VkFormat format,
+	uint32_t mip_levels, VkImageUsageFlags usage, VkImage &image,
+	VkDeviceMemory &memory)
+{
+	VkImageCreateInfo create_info {};
+	VkMemoryRequirements requirements {};
+
+	create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	create_info.imageType = VK_IMAGE_TYPE_2D;
+	create_info.format = format;
+	create_info.extent = VkExtent3D {width, height, 1};
+	create_info.mipLevels = mip_levels;
+	create_info.arrayLayers = 1;
+	create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+	create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+	create_info.usage = usage;
+	create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	if (vkCreateImage(device, &create_info, allocator, &image) != VK_SUCCESS)
+	{
+		throw (Error("Scop::createImage", "failed creation"));
+	}
+	vkGetImageMemoryRequirements(device, image, &requirements);
+	if (memory_budget.allocate(requirements,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, memory) != VK_SUCCESS)
+	{
+		throw (Error("Scop::createImage", "failed allocation"));
+	}
+	vkBindImageMemory(device, image, memory, 0);
+}
+
+/**
+ * Creates a 2D view of <level_count> levels of <image> from <base_level>.
+ */
+VkImageView Scop::createImageView(VkImage image, VkFormat format,
+	VkImageAspectFlags aspect, uint32_t base_level, uint32_t level_count)
+{
+	VkImageViewCreateInfo create_info {};
+	VkImageView view {};
+
+	create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	create_info.image = image;
+	create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	create_info.format = format;
+	create_info.subresourceRange.aspectMask = aspect;
+	create_info.subresourceRange.baseMipLevel = base_level;
+	create_info.subresourceRange.levelCount = level_count;
+	create_info.subresourceRange.baseArrayLayer = 0;
+	create_info.subresourceRange.layerCount = 1;
+	if (vkCreateImageView(device, &create_info, allocator, &view) != VK_SUCCESS)
+	{
+		throw (Error("Scop::createImageView", "failed creation"));
+	}
+	return (view);
+}
+
+/**
+ * Declares the frame to the render graph for the current swapchain: the scene
+ * pass draws into the swapchain image, presented afterwards, and into a
+ * transient depth buffer the graph creates at the swapchain extent. While
+ * frames are captured, a capture pass follows, which copies them. The graph
+ * derives every layout transition and barrier of the frame from it.
+ */
+void Scop::buildRenderGraph(void)
+{
+	VkImageAspectFlags depth_aspect {VK_IMAGE_ASPECT_DEPTH_BIT};
+
+	if (depth_format != VK_FORMAT_D32_SFLOAT)
+	{
+		depth_aspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+	}
+	render_graph = RenderGraph(device, allocator, &memory_budget,
+		cmd_pipeline_barrier2);
+
+	size_t color {render_graph.importImages("swapchain",
+		swapchain_image_format, VK_IMAGE_ASPECT_COLOR_BIT, swapchain_images,
+		swapchain_image_view, RenderGraph::PRESENT)};
+	size_t depth {render_graph.addTransient("depth", depth_format,
+		depth_aspect)};
+
+	render_graph.addPass("scene", {{color, RenderGraph::COLOR_WRITE},
+		{depth, RenderGraph::DEPTH_WRITE}},
+		[this](VkCommandBuffer buf, uint32_t image_index)
+		{
+			recordScene(buf, image_index);
+		});
+	capture_pass = needsCapturePass();
+	if (capture_pass)
+	{
+		render_graph.addPass("capture", {{color, RenderGraph::TRANSFER_SRC}},
+			[this](VkCommandBuffer buf, uint32_t image_index)
+			{
+				frame_capture.record(buf, swapchain_images[image_index],
+					swapchain_extent, swapchain_image_format,
+					timeline_value + 1, frame_count);
+			}, true);
+		frame_capture.reserve(swapchain_extent);
+	}
+	render_graph.compile(swapchain_extent);
+	depth_image_view = render_graph.getView(depth);
+}
+
+/**
+ * Tells if the frame needs the capture pass: every frame is captured or a
+ * screenshot is pending, and the swapchain images can be copied from. Frames
+ * without it skip the transitions the copy needs.
+ */
+bool Scop::needsCapturePass(void) const
+{
+	return (swapchain_readable && FrameCapture::supports(swapchain_image_format)
+		&& (frame_capture.isRecording() || frame_capture.isShotPending()));
+}
+
+/**
+ * Rebuilds the render graph and the framebuffers using its depth buffer for
+ * the current swapchain, retiring the previous ones, when the capture pass
+ * is added for a screenshot or removed once it is taken.
+ */
+void Scop::rebuildRenderGraph(void)
+{
+	retire([this, framebuffers = std::move(swapchain_framebuffers)](void)
+		{
+			for (VkFramebuffer framebuffer : framebuffers)
+			{
+				vkDestroyFramebuffer(device, framebuffer, allocator);
+			}
+		});
+	retire(render_graph.release());
+	swapchain_framebuffers.clear();
+	buildRenderGraph();
+	createFramebuffers();
+}
+
+/**
+ * Creates the descriptor set layout: the texture as a combined image sampler
+ * read by the fragment stage.
+ */
+void Scop::createDescriptorSetLayout(void)
+{
+	VkDescriptorSetLayoutBinding binding {};
+	VkDescriptorSetLayoutCreateInfo create_info {};
+
+	binding.binding = 0;
+	binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	binding.descriptorCount = 1;
+	binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	create_info.bindingCount = 1;
+	create_info.pBindings = &binding;
+	if (vkCreateDescriptorSetLayout(device, &create_info, allocator,
+		&descriptor_layout) != VK_SUCCESS)
+	{
+		throw (Error("Scop::createDescriptorSetLayout", "failed creation"));
+	}
+}
+
+/**
+ * Creates the trilinear repeating texture sampler.
+ */
+void Scop::createSampler(void)
+{
+	VkSamplerCreateInfo create_info {};
+
+	create_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	create_info.magFilter = VK_FILTER_LINEAR;
+	create_info.minFilter = VK_FILTER_LINEAR;
+	create_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	create_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	create_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	create_info.anisotropyEnable = VK_FALSE;
+	create_info.maxAnisotropy = 1.0f;
+	create_info.compareEnable = VK_FALSE;
+	create_info.minLod = 0.0f;
+	create_info.maxLod = VK_LOD_CLAMP_NONE;
+	create_info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+	if (vkCreateSampler(device, &create_info, allocator, &sampler)
+		!= VK_SUCCESS)
+	{
+		throw (Error("Scop::createSampler", "failed creation"));
+	}
+}
+
+/**
+ * Creates the descriptor pool holding one set per frame in flight.
+ */
+void Scop::createDescriptorPool(void)
+{
+	VkDescriptorPoolSize size {};
+	VkDescriptorPoolCreateInfo create_info {};
+
+	size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	size.descriptorCount = static_cast<uint32_t> (max_frame_in_flight);
+	create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	create_info.maxSets = static_cast<uint32_t> (max_frame_in_flight);
+	create_info.poolSizeCount = 1;
+	create_info.pPoolSizes = &size;
+	if (vkCreateDescriptorPool(device, &create_info, allocator,
+		&descriptor_pool) != VK_SUCCESS)
+	{
+		throw (Error("Scop::createDescriptorPool", "failed creation"));
+	}
+}
+
+/**
+ * Allocates one descriptor set per frame in flight. A set is only written
+ * once its frame is done, so the texture can be swapped without waiting for
+ * the GPU. They are written on first use.
+ */
+void Scop::createDescriptorSets(void)
+{
+	std::vector<VkDescriptorSetLayout> layouts(max_frame_in_flight,
+		descriptor_layout);
+	VkDescriptorSetAllocateInfo alloc_info {};
+
+	descriptor_sets.resize(max_frame_in_flight);
+	descriptor_views.assign(max_frame_in_flight, VK_NULL_HANDLE);
+	alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	alloc_info.descriptorPool = descriptor_pool;
+	alloc_info.descriptorSetCount = static_cast<uint32_t> (layouts.size());
+	alloc_info.pSetLayouts = layouts.data();
+	if (vkAllocateDescriptorSets(device, &alloc_info, descriptor_sets.data())
+		!= VK_SUCCESS)
+	{
+		throw (Error("Scop::createDescriptorSets", "failed allocation"));
+	}
+}
+
+/**
+ * Points the descriptor set of the current frame to the current texture if it
+ * doesn't already. The frame must have been waited for.
+ */
+void Scop::updateDescriptorSet(void)
+{
+	if (descriptor_views[curr_frame] == texture.view)
+	{
+		return ;
+	}
+
+	VkDescriptorImageInfo image_info {};
+	VkWriteDescriptorSet write {};
+
+	image_info.sampler = sampler;
+	image_info.imageView = texture.view;
+	image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = descriptor_sets[curr_frame];
+	write.dstBinding = 0;
+	write.dstArrayElement = 0;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write.pImageInfo = &image_info;
+	vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+	descriptor_views[curr_frame] = texture.view;
+}
+
+/**
+ * Size in bytes of a <width> by <height> level of a texture in <format>:
+ * block compressed, or RGBA8.
+ */
+static inline VkDeviceSize textureLevelSize(VkFormat format, uint32_t width,
+	uint32_t height)
+{
+	switch (format)
+	{
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			return (BlockCompressor::levelSize(BlockCompressor::BC1, width,
+				height));
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+			return (BlockCompressor::levelSize(BlockCompressor::BC3, width,
+				height));
+		default:
+			return (Image::mipChainSize(width, height, 1));
+	}
+}
+
+/**
+ * Creates a texture of <mip_levels> levels in the sRGB <format> and the
+ * memory holding the data to stream to it: the whole mip chain, or only the
+ * first level when the GPU generates the others. No level is resident yet,
+ * so the texture has no view.
+ */
+Scop::TextureUpload Scop::createTextureUpload(uint32_t width, uint32_t height,
+	uint32_t mip_levels, VkFormat format, bool gpu_mips)
+{
+	TextureUpload upload {};
+	VkDeviceSize size {0};
+
+	if (textureLevelSize(format, width, 4) > SCOP_UPLOAD_BUDGET)
+	{
+		throw (Error("Scop::createTextureUpload", "texture too wide"));
+	}
+	upload.width = width;
+	upload.height = height;
+	upload.mip_levels = mip_levels;
+	upload.format = format;
+	upload.gpu_mips = gpu_mips;
+	upload.level = gpu_mips ? 0 : mip_levels - 1;
+	upload.resident = mip_levels;
+	for (uint32_t i {0}; i < (gpu_mips ? 1 : mip_levels); ++i)
+	{
+		size += textureLevelSize(format, std::max(width >> i, 1u),
+			std::max(height >> i, 1u));
+	}
+	upload.data.resize(size);
+	createImage(width, height, format, mip_levels,
+		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT
+			| (gpu_mips ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0),
+		upload.texture.image, upload.texture.memory);
+	return (upload);
+}
+
+/**
+ * Destroys the image, memory and view of <texture>.
+ */
+void Scop::destroyTexture(Texture &texture)
+{
+	vkDestroyImageView(device, texture.view, allocator);
+	vkDestroyImage(device, texture.image, allocator);
+	memory_budget.free(texture.memory);
+	texture = Texture {};
+}
+
+/**
+ * Creates the persistently mapped staging ring textures are streamed through:
+ * one slice of SCOP_UPLOAD_BUDGET bytes per frame in flight, reused once the
+ * timeline reached the value of the frame.
+ */
+void Scop::createStagingRing(void)
+{
+	void *mapped {nullptr};
+
+	createBuffer(static_cast<VkDeviceSize> (SCOP_UPLOAD_BUDGET)
+		* max_frame_in_flight, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+			| VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging_ring,
+		staging_ring_memory);
+	if (vkMapMemory(device, staging_ring_memory, 0, VK_WHOLE_SIZE, 0, &mapped)
+		!= VK_SUCCESS)
+	{
+		throw (Error("Scop::createStagingRing", "failed mapping"));
+	}
+	staging_ring_data = static_cast<uint8_t *> (mapped);
+}
+
+/**
+ * Uploads a single white texel texture, bound until the real texture has a
+ * resident level so that the first frame never waits for it.
+ */
+void Scop::createPlaceholderTexture(void)
+{
+	TextureUpload upload {createTextureUpload(1, 1, 1,
+		VK_FORMAT_R8G8B8A8_SRGB, false)};
+
+	std::memset(upload.data.data(), 0xff, upload.data.size());
+
+	VkCommandBuffer buf {beginSingleTimeCommands()};
+
+	recordTextureStream(buf, upload, 0, SCOP_UPLOAD_BUDGET);
+	endSingleTimeCommands(buf);
+	placeholder = upload.texture;
+	texture = placeholder;
+}
+
+/**
+ * Tells if <format> can be blitted with linear filtering.
+ */
+bool Scop::supportsLinearBlit(VkFormat format)
+{
+	VkFormatProperties properties {};
+	VkFormatFeatureFlags needed {VK_FORMAT_FEATURE_BLIT_SRC_BIT
+		| VK_FORMAT_FEATURE_BLIT_DST_BIT
+		| VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT};
+
+	vkGetPhysicalDeviceFormatProperties(physical_device, format, &properties);
+	return ((properties.optimalTilingFeatures & needed) == needed);
+}
+
+/**
+ * Tells if the device enabled BC textures (every supported feature is) and can
+ * filter the sRGB BC1 and BC3 formats.
+ */
+bool Scop::supportsBlockCompression(void)
+{
+	VkPhysicalDeviceFeatures features {};
+	VkFormatFeatureFlags needed {VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT
+		| VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT};
+
+	vkGetPhysicalDeviceFeatures(physical_device, &features);
+	if (!features.textureCompressionBC)
+	{
+		return (false);
+	}
+	for (VkFormat format : {VK_FORMAT_BC1_RGB_SRGB_BLOCK,
+		VK_FORMAT_BC3_SRGB_BLOCK})
+	{
+		VkFormatProperties properties {};
+
+		vkGetPhysicalDeviceFormatProperties(physical_device, format,
+			&properties);
+		if ((properties.optimalTilingFeatures & needed) != needed)
+		{
+			return (false);
+		}
+	}
+	return (true);
+}
+
+/**
+ * Worker side of the texture loading: reads the image at <path>, decodes it
+ * straight into the upload data, and unless the GPU does it, generates the
+ * mip chain in place on the pool. Block compressed when enabled
+ * and supported.
+ */
+Scop::TextureUpload Scop::prepareTexture(const std::string &path)
+{
+	std::chrono::steady_clock::time_point start {
+		std::chrono::steady_clock::now()};
+	Image image {path};
+
+	if (options.compress && supportsBlockCompression())
+	{
+		return (prepareCompressedTexture(image, start));
+	}
+
+	bool gpu_mips {options.gpu_mips
+		&& supportsLinearBlit(VK_FORMAT_R8G8B8A8_SRGB)};
+	TextureUpload upload {createTextureUpload(image.getWidth(),
+		image.getHeight(), image.getMipLevels(), VK_FORMAT_R8G8B8A8_SRGB,
+		gpu_mips)};
+
+	try
+	{
+		image.decode(upload.data.data());
+
+		std::chrono::steady_clock::time_point decoded {
+			std::chrono::steady_clock::now()};
+
+		upload.decode_ms = std::chrono::duration<double, std::milli> (
+			decoded - start).count();
+		if (!gpu_mips)
+		{
+			Image::generateMips(upload.data.data(), upload.width,
+				upload.height, upload.mip_levels, pool);
+			upload.mip_ms = std::chrono::duration<double, std::milli> (
+				std::chrono::steady_clock::now() - decoded).count();
+		}
+	}
+	catch (...)
+	{
+		destroyTexture(upload.texture);
+		throw ;
+	}
+	return (upload);
+}
+
+/**
+ * Block compressed side of prepareTexture: the mip chain of <image> is read
+ * from the texture cache, or decoded, mipmapped and encoded on the pool then
+ * cached. BC1 is used for opaque images, BC3 otherwise. GPU mips don't apply
+ * since compressed formats can't be blitted to.
+ */
+Scop::TextureUpload Scop::prepareCompressedTexture(const Image &image,
+	std::chrono::steady_clock::time_point start)
+{
+	BlockCompressor compressor {options.compress_mode};
+	uint64_t hash {image.hash()};
+	TextureCache::Header header {};
+	std::vector<uint8_t> blocks {};
+	bool cached {texture_cache.read(hash, compressor.getMode(),
+		image.getWidth(), image.getHeight(), image.getMipLevels(), header,
+		blocks)};
+	double decode_ms {0.0};
+	double mip_ms {0.0};
+
+	if (!cached)
+	{
+		std::vector<uint8_t> chain(Image::mipChainSize(image.getWidth(),
+			image.getHeight(), image.getMipLevels()));
+
+		image.decode(chain.data());
+
+		std::chrono::steady_clock::time_point decoded {
+			std::chrono::steady_clock::now()};
+
+		Image::generateMips(chain.data(), image.getWidth(), image.getHeight(),
+			image.getMipLevels(), pool);
+
+		std::chrono::steady_clock::time_point mipped {
+			std::chrono::steady_clock::now()};
+
+		decode_ms = std::chrono::duration<double, std::milli> (
+			decoded - start).count();
+		mip_ms = std::chrono::duration<double, std::milli> (
+			mipped - decoded).count();
+		start = mipped;
+		std::memcpy(header.magic, "SCBC", 4);
+		header.version = TEXTURECACHE_VERSION;
+		header.format = BlockCompressor::hasAlpha(chain.data(),
+			static_cast<size_t> (image.getWidth()) * image.getHeight())
+			? BlockCompressor::BC3 : BlockCompressor::BC1;
+		header.width = image.getWidth();
+		header.height = image.getHeight();
+		header.levels = image.getMipLevels();
+		header.size = BlockCompressor::chainSize(
+			static_cast<BlockCompressor::Format> (header.format),
+			header.width, header.height, header.levels);
+		blocks.resize(header.size);
+		compressor.encodeChain(chain.data(), header.width, header.height,
+			header.levels, static_cast<BlockCompressor::Format> (
+				header.format), blocks.data(), pool);
+		texture_cache.write(hash, compressor.getMode(), header,
+			blocks.data());
+	}
+
+	TextureUpload upload {createTextureUpload(header.width, header.height,
+		header.levels, header.format == BlockCompressor::BC1
+			? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC3_SRGB_BLOCK, false)};
+
+	upload.data = std::move(blocks);
+	upload.cached = cached;
+	upload.decode_ms = decode_ms;
+	upload.mip_ms = mip_ms;
+	upload.encode_ms = std::chrono::duration<double, std::milli> (
+		std::chrono::steady_clock::now() - start).count();
+	return (upload);
+}
+
+/**
+ * Starts loading the texture at <path> on the pool. The placeholder stays
+ * bound until the upload is recorded by a later frame.
+ */
+void Scop::loadTexture(const std::string &path)
+{
+	texture_load = pool.submit([this, path](void) {
+		return (prepareTexture(path));
+	});
+}
+
+/**
+ * Sets an image memory barrier on <count> levels of the color <image> from
+ * <base>.
+ */
+static inline VkImageMemoryBarrier setImageBarrier(VkImage image,
+	uint32_t base, uint32_t count, VkImageLayout old_layout,
+	VkImageLayout new_layout, VkAccessFlags src_access,
+	VkAccessFlags dst_access)
+{
+	VkImageMemoryBarrier barrier {};
+
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcAccessMask = src_access;
+	barrier.dstAccessMask = dst_access;
+	barrier.oldLayout = old_layout;
+	barrier.newLayout = new_layout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = base;
+	barrier.subresourceRange.levelCount = count;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+	return (barrier);
+}
+
+/**
+ * Records the copy of up to <budget> bytes of the data of <upload> through
+ * the staging ring slice at <ring_offset>, smallest level first and
+ * in whole block rows. Each finished level is made readable by the fragment
+ * stage and the view moved down to it. With GPU mips, the first level is
+ * streamed then blitted down. Returns true once every level is resident.
+ */
+bool Scop::recordTextureStream(VkCommandBuffer buf, TextureUpload &upload,
+	VkDeviceSize ring_offset, VkDeviceSize budget)
+{
+	VkImage image {upload.texture.image};
+	uint32_t block {upload.format == VK_FORMAT_R8G8B8A8_SRGB ? 1u : 4u};
+	uint32_t resident {upload.resident};
+	VkDeviceSize used {0};
+
+	if (upload.row == 0 && upload.resident == upload.mip_levels
+		&& upload.level == (upload.gpu_mips ? 0 : upload.mip_levels - 1))
+	{
+		VkImageMemoryBarrier barrier {setImageBarrier(image, 0,
+			upload.mip_levels, VK_IMAGE_LAYOUT_UNDEFINED,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0,
+			VK_ACCESS_TRANSFER_WRITE_BIT)};
+
+		vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1,
+			&barrier);
+	}
+	while (upload.resident != 0)
+	{
+		uint32_t width {std::max(upload.width >> upload.level, 1u)};
+		uint32_t height {std::max(upload.height >> upload.level, 1u)};
+		uint32_t rows {(height + block - 1) / block};
+		VkDeviceSize row_size {textureLevelSize(upload.format, width, block)};
+		uint32_t count {static_cast<uint32_t> (std::min<VkDeviceSize> (
+			rows - upload.row, (budget - used) / row_size))};
+		VkDeviceSize offset {0};
+		VkBufferImageCopy region {};
+
+		if (count == 0)
+		{
+			break ;
+		}
+		for (uint32_t i {0}; i < upload.level; ++i)
+		{
+			offset += textureLevelSize(upload.format,
+				std::max(upload.width >> i, 1u),
+				std::max(upload.height >> i, 1u));
+		}
+		std::memcpy(staging_ring_data + ring_offset + used,
+			upload.data.data() + offset + upload.row * row_size,
+			count * row_size);
+		region.bufferOffset = ring_offset + used;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = upload.level;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset = VkOffset3D {0,
+			static_cast<int32_t> (upload.row * block), 0};
+		region.imageExtent = VkExtent3D {width,
+			std::min(count * block, height - upload.row * block), 1};
+		vkCmdCopyBufferToImage(buf, staging_ring, image,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+		used += count * row_size;
+		upload.row += count;
+		if (upload.row < rows)
+		{
+			break ;
+		}
+		if (upload.gpu_mips)
+		{
+			recordMipBlits(buf, upload);
+			upload.resident = 0;
+			break ;
+		}
+
+		VkImageMemoryBarrier barrier {setImageBarrier(image, upload.level, 1,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT)};
+
+		vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1,
+			&barrier);
+		upload.resident = upload.level;
+		upload.level -= (upload.level != 0);
+		upload.row = 0;
+	}
+	if (upload.resident != resident)
+	{
+		if (upload.texture.view != VK_NULL_HANDLE)
+		{
+			retire([this, view = upload.texture.view](void)
+				{
+					vkDestroyImageView(device, view, allocator);
+				});
+		}
+		upload.texture.view = createImageView(image, upload.format,
+			VK_IMAGE_ASPECT_COLOR_BIT, upload.resident,
+			upload.mip_levels - upload.resident);
+	}
+	return (upload.resident == 0);
+}
+
+/**
+ * Records the GPU mip generation of <upload>: each level is linearly blitted
+ * from the previous one, which is then made readable by the fragment stage.
+ */
+void Scop::recordMipBlits(VkCommandBuffer buf, const TextureUpload &upload)
+{
+	VkImage image {upload.texture.image};
+	int32_t width {static_cast<int32_t> (upload.width)};
+	int32_t height {static_cast<int32_t> (upload.height)};
+
+	for (uint32_t i {1}; i < upload.mip_levels; ++i)
+	{
+		VkImageMemoryBarrier barrier {setImageBarrier(image, i - 1, 1,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_ACCESS_TRANSFER_READ_BIT)};
+		VkImageBlit blit {};
+
+		vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1,
+			&barrier);
+		blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.srcSubresource.mipLevel = i - 1;
+		blit.srcSubresource.layerCount = 1;
+		blit.srcOffsets[1] = VkOffset3D {width, height, 1};
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+		blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.dstSubresource.mipLevel = i;
+		blit.dstSubresource.layerCount = 1;
+		blit.dstOffsets[1] = VkOffset3D {width, height, 1};
+		vkCmdBlitImage(buf, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+		barrier = setImageBarrier(image, i - 1, 1,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT);
+		vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1,
+			&barrier);
+	}
+
+	VkImageMemoryBarrier barrier {setImageBarrier(image,
+		upload.mip_levels - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_ACCESS_SHADER_READ_BIT)};
+
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1,
+		&barrier);
+}
+
+/**
+ * Picks the texture being loaded up once the pool is done with it, then
+ * streams it a budget at a time, after the <used> bytes of the staging ring
+ * slice the mesh took. The texture is bound as soon as its smallest level is
+ * resident, and follows the view down as more levels arrive.
+ */
+void Scop::pollTexture(VkCommandBuffer buf, VkDeviceSize used)
+{
+	if (!streaming)
+	{
+		if (!texture_load.valid() || texture_load.wait_for(
+			std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			return ;
+		}
+		texture_upload = texture_load.get();
+		texture_upload.start_frame = frame_count;
+		texture_upload.start = std::chrono::steady_clock::now();
+		streaming = true;
+	}
+
+	uint32_t resident {texture_upload.resident};
+	bool done {recordTextureStream(buf, texture_upload,
+		static_cast<VkDeviceSize> (SCOP_UPLOAD_BUDGET) * curr_frame + used,
+		SCOP_UPLOAD_BUDGET - used)};
+
+	if (texture_upload.resident != resident)
+	{
+		texture = texture_upload.texture;
+	}
+	if (done)
+	{
+		reportTexture();
+		std::vector<uint8_t> {}.swap(texture_upload.data);
+		streaming = false;
+	}
+}
+
+/**
+ * Reports how long loading the streamed texture took, if requested.
+ */
+void Scop::reportTexture(void)
+{
+	if (!options.report)
+	{
+		return ;
+	}
+	std::cerr << "texture " << texture_upload.width << "x"
+		<< texture_upload.height << ", " << texture_upload.mip_levels
+		<< " levels: ";
+	if (!texture_upload.cached)
+	{
+		std::cerr << "decode " << texture_upload.decode_ms << " ms, ";
+	}
+	if (!texture_upload.gpu_mips && !texture_upload.cached)
+	{
+		std::cerr << "cpu mips " << texture_upload.mip_ms << " ms, ";
+	}
+	if (texture_upload.format != VK_FORMAT_R8G8B8A8_SRGB)
+	{
+		std::cerr << (texture_upload.format == VK_FORMAT_BC1_RGB_SRGB_BLOCK
+			? "bc1 " : "bc3 ") << (texture_upload.cached ? "cache read "
+			: "encode ") << texture_upload.encode_ms << " ms, ";
+	}
+	std::cerr << "streamed in " << frame_count - texture_upload.start_frame + 1
+		<< " frames, " << std::chrono::duration<double, std::milli> (
+			std::chrono::steady_clock::now() - texture_upload.start).count()
+		<< " ms" << std::endl;
+}
+
+/**
+ * Destroys every texture and the staging ring, waiting for the pool to be
+ * done with the texture being loaded. The device must be idle.
+ */
+void Scop::cleanupTextures(void)
+{
+	if (texture_load.valid())
+	{
+		try
+		{
+			TextureUpload upload {texture_load.get()};
+
+			destroyTexture(upload.texture);
+		}
+		catch (...)
+		{
+			// Nothing was left to destroy;
+		}
+	}
+	if (streaming && texture_upload.texture.image != texture.image)
+	{
+		destroyTexture(texture_upload.texture);
+	}
+	if (texture.image != placeholder.image)
+	{
+		destroyTexture(texture);
+	}
+	destroyTexture(placeholder);
+	evicted_texture = 0;
+	vkDestroyBuffer(device, staging_ring, allocator);
+	memory_budget.free(staging_ring_memory);
+	vkDestroySampler(device, sampler, allocator);
+	vkDestroyDescriptorPool(device, descriptor_pool, allocator);
+}
+
+/**
+ * Tells if the current pipeline variant samples the texture: every shading
+ * mode but normals, which only reads its alpha to blend.
+ */
+bool Scop::usesTexture(void)
+{
+	return (!options.texture.empty()
+		&& (variant.shading != PipelineVariants::NORMALS
+			|| variant.blend == PipelineVariants::ALPHA));
+}
+
+/**
+ * Evicts <resource> from device local memory. The mesh moves to host memory,
+ * where it is still drawn from over the bus. The texture is destroyed and the
+ * placeholder bound until it is loaded again, from the texture cache when
+ * block compressed. The old objects are retired, not waited for. Returns false
+ * if <resource> isn't resident or is still streaming.
+ */
+bool Scop::evict(uint32_t resource)
+{
+	if (resource == RESOURCE_MESH ? !mesh_resident || mesh_stream.active
+		: (streaming || texture_load.valid()
+		|| texture.image == placeholder.image))
+	{
+		return (false);
+	}
+	if (resource == RESOURCE_MESH)
+	{
+		retireMesh();
+		uploadMesh(false);
+	}
+	else
+	{
+		evicted_texture = memory_budget.getSize(texture.memory);
+		memory_budget.retire(texture.memory);
+		retire([this, evicted = texture](void) mutable
+			{
+				destroyTexture(evicted);
+			});
+		texture = placeholder;
+		descriptor_views.assign(max_frame_in_flight, VK_NULL_HANDLE);
+	}
+	if (options.report)
+	{
+		std::cerr << (resource == RESOURCE_MESH ? "mesh" : "texture")
+			<< " evicted from device memory" << std::endl;
+	}
+	return (true);
+}
+
+/**
+ * Keeps device local memory within its budget, once per frame. What this
+ * frame draws is marked as used, then the least recently used resources are
+ * evicted while the device heap is past MEMORYBUDGET_HIGH percent of its
+ * budget. Evicted resources page back in once needed and fitting under
+ * MEMORYBUDGET_LOW percent, the gap keeping them from bouncing. The mesh is
+ * copied back by the frame recorded next.
+ */
+void Scop::manageResidency(void)
+{
+	uint32_t heap {memory_budget.getDeviceHeap()};
+
+	memory_budget.update();
+	memory_budget.touch(RESOURCE_MESH);
+	if (usesTexture())
+	{
+		memory_budget.touch(RESOURCE_TEXTURE);
+	}
+	for (uint32_t resource : memory_budget.getLeastRecentlyUsed())
+	{
+		if (!memory_budget.exceeds(heap, 0, MEMORYBUDGET_HIGH))
+		{
+			break ;
+		}
+		evict(resource);
+	}
+	if (!mesh_resident && !mesh_stream.active && !memory_budget.exceeds(heap,
+		mesh.getPositions().size() * sizeof(Vec3)
+			+ mesh.getAttributes().size() * sizeof(Mesh::Attributes)
+			+ mesh.getIndices().size() * sizeof(uint32_t), MEMORYBUDGET_LOW))
+	{
+		mesh_page_in = true;
+	}
+	if (evicted_texture && usesTexture() && !memory_budget.exceeds(heap,
+		evicted_texture, MEMORYBUDGET_LOW))
+	{
+		evicted_texture = 0;
+		loadTexture(options.texture);
+		if (options.report)
+		{
+			std::cerr << "texture paged in" << std::endl;
+		}
+	}
+}
+
+/**
+ * Creates a command buffer.
+ */
+void Scop::createCommandBuffers(void)
+{
+	VkCommandBufferAllocateInfo info {};
+
+	command_buffer.resize(max_frame_in_flight);
 	info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 	info.commandPool = command_pool;
 	info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
@@ -1209,28 +3963,36 @@ void Scop::createCommandBuffers(void)
  * Creates semaphores for graphics:
  * - One so the rendering waits for images to be available from the swapchain
  * - Second one to wait for the render pass to be finished and be presented
- * Creates a fence for the cpu to wait for the end of the frame to avoid writing
- * to it while it is still used by the GPU
+ * Creates the timeline semaphore every submission signals with the next value
+ * of a single counter: the CPU waits on a frame's value before reusing its
+ * slot, and anything retired at value N is free once N is reached.
  */
 void Scop::createSyncObjects(void)
 {
 	VkSemaphoreCreateInfo sem {};
-	VkFenceCreateInfo fence {};
+	VkSemaphoreTypeCreateInfoKHR type {};
+	VkSemaphoreCreateInfo timeline_info {};
 
 	image_sem.resize(max_frame_in_flight);
 	render_sem.resize(max_frame_in_flight);
-	frame_fence.resize(max_frame_in_flight);
+	frame_value.assign(max_frame_in_flight, 0);
 	sem.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-	fence.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	fence.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+	type.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+	type.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+	type.initialValue = timeline_value;
+	timeline_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	timeline_info.pNext = &type;
+	if (vkCreateSemaphore(device, &timeline_info, allocator, &timeline)
+		!= VK_SUCCESS)
+	{
+		throw (Error("Scop::createSyncObjects", "failed timeline creation"));
+	}
 	for (int i {0}; i < max_frame_in_flight; ++i)
 	{
 		if (
-			vkCreateSemaphore(device, &sem, nullptr, &image_sem[i])
+			vkCreateSemaphore(device, &sem, allocator, &image_sem[i])
 				!= VK_SUCCESS
-			|| vkCreateSemaphore(device, &sem, nullptr, &render_sem[i])
-				!= VK_SUCCESS
-			|| vkCreateFence(device, &fence, nullptr, &frame_fence[i])
+			|| vkCreateSemaphore(device, &sem, allocator, &render_sem[i])
 				!= VK_SUCCESS)
 		{
 			throw (Error("Scop::createSyncObjects", "failed creation"));
@@ -1238,6 +4000,75 @@ void Scop::createSyncObjects(void)
 	}
 }
 
+/**
+ * Blocks until the timeline reaches <value>.
+ */
+void Scop::waitTimeline(uint64_t value)
+{
+	VkSemaphoreWaitInfoKHR wait_info {};
+
+	wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+	wait_info.semaphoreCount = 1;
+	wait_info.pSemaphores = &timeline;
+	wait_info.pValues = &value;
+	if (wait_semaphores(device, &wait_info, UINT64_MAX) != VK_SUCCESS)
+	{
+		throw (Error("Scop::waitTimeline", "failed wait"));
+	}
+}
+
+/**
+ * Value of the last submission the GPU completed.
+ */
+uint64_t Scop::getCompletedValue(void)
+{
+	uint64_t value {0};
+
+	if (get_semaphore_counter(device, timeline, &value) != VK_SUCCESS)
+	{
+		throw (Error("Scop::getCompletedValue", "failed query"));
+	}
+	return (value);
+}
+
+/**
+ * Creates the timestamp query pool measuring GPU frame time, two queries per
+ * frame in flight. The pool stays null if the graphic queue can't write
+ * timestamps.
+ */
+void Scop::createQueryPool(void)
+{
+	QueueFamilyIndices indices {findQueueFamilies(physical_device)};
+	VkPhysicalDeviceProperties properties {};
+	uint32_t count {0};
+
+	vkGetPhysicalDeviceProperties(physical_device, &properties);
+	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &count, nullptr);
+
+	std::vector<VkQueueFamilyProperties> families(count);
+
+	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &count,
+		families.data());
+	query_written.assign(max_frame_in_flight, false);
+	if (families[indices.graphic_family.value()].timestampValidBits == 0
+		|| properties.limits.timestampPeriod == 0.0f)
+	{
+		return ;
+	}
+
+	VkQueryPoolCreateInfo create_info {};
+
+	create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	create_info.queryCount = 2 * static_cast<uint32_t> (max_frame_in_flight);
+	if (vkCreateQueryPool(device, &create_info, allocator, &query_pool)
+		!= VK_SUCCESS)
+	{
+		throw (Error("Scop::createQueryPool", "failed creation"));
+	}
+	timestamp_period = properties.limits.timestampPeriod;
+}
+
 /**
  * Sets the buffer begin info structure.
  */
@@ -1254,7 +4085,7 @@ VkCommandBufferBeginInfo Scop::setBufferBeginInfo(void)
  * Sets the render pass begin info structure.
  */
 VkRenderPassBeginInfo Scop::setRenderPassBeginInfo(uint32_t image_index,
-	const VkClearValue &clear_color)
+	const VkClearValue *clear_values)
 {
 	return (VkRenderPassBeginInfo {
 		.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
@@ -1262,8 +4093,8 @@ VkRenderPassBeginInfo Scop::setRenderPassBeginInfo(uint32_t image_index,
 		.framebuffer = swapchain_framebuffers[image_index],
 		.renderArea.offset = {0, 0},
 		.renderArea.extent = swapchain_extent,
-		.clearValueCount = 1,
-		.pClearValues = &clear_color
+		.clearValueCount = 2,
+		.pClearValues = clear_values
 	});
 }
 
@@ -1283,7 +4114,67 @@ VkViewport Scop::setViewport(void)
 }
 
 /**
- * Records commands in the command buffer <buf>.
+ * Starts rendering to the swapchain image <image_index> and the depth buffer,
+ * both cleared to <clear_values>. Without dynamic rendering, this begins the
+ * render pass on the image framebuffer. Otherwise the attachments are bound
+ * directly. Either way the render graph has already put them in their
+ * attachment layout.
+ */
+void Scop::beginRendering(VkCommandBuffer buf, uint32_t image_index,
+	const VkClearValue *clear_values)
+{
+	if (!dynamic_rendering)
+	{
+		VkRenderPassBeginInfo pass_info {setRenderPassBeginInfo(image_index,
+			clear_values)};
+
+		vkCmdBeginRenderPass(buf, &pass_info, VK_SUBPASS_CONTENTS_INLINE);
+		return ;
+	}
+
+	VkRenderingAttachmentInfoKHR color {};
+	VkRenderingAttachmentInfoKHR depth {};
+	VkRenderingInfoKHR rendering_info {};
+
+	color.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+	color.imageView = swapchain_image_view[image_index];
+	color.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	color.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	color.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	color.clearValue = clear_values[0];
+	depth.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+	depth.imageView = depth_image_view;
+	depth.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depth.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depth.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depth.clearValue = clear_values[1];
+	rendering_info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+	rendering_info.renderArea = {{0, 0}, swapchain_extent};
+	rendering_info.layerCount = 1;
+	rendering_info.colorAttachmentCount = 1;
+	rendering_info.pColorAttachments = &color;
+	rendering_info.pDepthAttachment = &depth;
+	cmd_begin_rendering(buf, &rendering_info);
+}
+
+/**
+ * Ends rendering to the swapchain image. The render graph moves it to the
+ * presentation layout afterwards.
+ */
+void Scop::endRendering(VkCommandBuffer buf)
+{
+	if (!dynamic_rendering)
+	{
+		vkCmdEndRenderPass(buf);
+		return ;
+	}
+	cmd_end_rendering(buf);
+}
+
+/**
+ * Records commands in the command buffer <buf>: texture and mesh streaming,
+ * then the passes of the render graph. The end timestamp follows them, the
+ * start one is written by the scene pass.
  */
 void Scop::recordCommandBuffer(VkCommandBuffer buf, uint32_t img_index)
 {
@@ -1294,33 +4185,217 @@ void Scop::recordCommandBuffer(VkCommandBuffer buf, uint32_t img_index)
 		throw (Error("Scop::recordCommandBuffer", "failed begin"));
 	}
 
-	VkClearValue clear {{{0.0f, 0.0f, 0.0f, 1.0f}}};
-	VkRenderPassBeginInfo pass_info {setRenderPassBeginInfo(img_index, clear)};
+	uint32_t query {2 * curr_frame};
+
+	if (query_pool != VK_NULL_HANDLE)
+	{
+		vkCmdResetQueryPool(buf, query_pool, query, 2);
+	}
+	pageInMesh(buf);
+	pollTexture(buf, pollMesh(buf));
+	updateDescriptorSet();
+	render_graph.execute(buf, img_index);
+	if (query_pool != VK_NULL_HANDLE)
+	{
+		vkCmdWriteTimestamp(buf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			query_pool, query + 1);
+		query_written[curr_frame] = true;
+	}
+	if (vkEndCommandBuffer(buf) != VK_SUCCESS)
+	{
+		throw (Error("Scop::recordCommandBuffer", "failed ending"));
+	}
+}
+
+/**
+ * Records the scene pass of the render graph into <buf>: the mesh drawn to the
+ * swapchain image <image_index>. The start timestamp is written at vertex
+ * input, where the scene begins, so that the GPU time of the frame leaves out
+ * the streaming copies before it and the wait for the swapchain image, which
+ * only blocks color output.
+ */
+void Scop::recordScene(VkCommandBuffer buf, uint32_t image_index)
+{
+	VkClearValue clear[2] {};
+
+	clear[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
+	clear[1].depthStencil = {1.0f, 0};
+
 	VkViewport viewport {setViewport()};
 	VkRect2D scissor {{0,0}, swapchain_extent};
 
-	vkCmdBeginRenderPass(buf, &pass_info, VK_SUBPASS_CONTENTS_INLINE);
-	vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_GRAPHICS, graphics_pipeline);
+	if (query_pool != VK_NULL_HANDLE)
+	{
+		vkCmdWriteTimestamp(buf, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+			query_pool, 2 * curr_frame);
+	}
+	beginRendering(buf, image_index, clear);
 	vkCmdSetViewport(buf, 0, 1, &viewport);
 	vkCmdSetScissor(buf, 0, 1, &scissor);
-	vkCmdDraw(buf, 3, 1, 0, 0);
-	vkCmdEndRenderPass(buf);
-	if (vkEndCommandBuffer(buf) != VK_SUCCESS)
+	recordDraw(buf);
+	endRendering(buf);
+}
+
+/**
+ * Records the draws of the mesh, or of the part of it streamed so far. With
+ * the pre-pass, depth is first laid down
+ * from the position stream alone, then the shading pass only keeps fragments
+ * at the stored depth.
+ */
+void Scop::recordDraw(VkCommandBuffer buf)
+{
+	Transform transform {computeTransform()};
+	VkBuffer buffers[] {position_buffer, attribute_buffer};
+	VkDeviceSize offsets[] {0, 0};
+	uint32_t count {index_count};
+
+	if (count == 0)
 	{
-		throw (Error("Scop::recordCommandBuffer", "failed ending"));
+		return ;
+	}
+	vkCmdPushConstants(buf, pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0,
+		sizeof(Transform), &transform);
+	vkCmdBindIndexBuffer(buf, index_buffer, 0, VK_INDEX_TYPE_UINT32);
+	vkCmdBindDescriptorSets(buf, VK_PIPELINE_BIND_POINT_GRAPHICS,
+		pipeline_layout, 0, 1, &descriptor_sets[curr_frame], 0, nullptr);
+	if (options.depth_prepass)
+	{
+		vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_GRAPHICS,
+			pipelines.get(getDepthVariant()));
+		vkCmdBindVertexBuffers(buf, 0, 1, buffers, offsets);
+		vkCmdDrawIndexed(buf, count, 1, 0, 0, 0);
 	}
+	vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_GRAPHICS,
+		pipelines.get(variant));
+	vkCmdBindVertexBuffers(buf, 0, 2, buffers, offsets);
+	vkCmdDrawIndexed(buf, count, 1, 0, 0, 0);
 }
 
 /**
- * Main loop.
+ * Main loop. Frames are drawn on a dedicated render thread while the calling
+ * thread, which must be the one that initialized SDL, keeps pumping window
+ * events. Slow event handling (modal drags, resizes) and slow frames overlap
+ * instead of adding up. Errors of the render thread are rethrown here.
  */
 void Scop::mainLoop(void)
 {
-	while (manageEvent())
+	running.store(true, std::memory_order_release);
+
+	std::thread render {&Scop::renderLoop, this};
+
+	pumpEvents();
+	render.join();
+	if (!software)
+	{
+		vkDeviceWaitIdle(device);
+		frame_capture.release();
+	}
+	input_log.writeSummary(std::cerr);
+	frame_capture.writeReport(std::cerr);
+	if (options.report)
+	{
+		host_allocator.writeReport(std::cerr);
+		memory_budget.update();
+		memory_budget.writeReport(std::cerr);
+	}
+	if (render_error)
+	{
+		std::rethrow_exception(render_error);
+	}
+}
+
+/**
+ * Event thread loop: forwards every SDL event to the render thread through
+ * the lock-free event queue until rendering stops. The drawable size is
+ * resolved here since window queries belong to the thread owning SDL, and so
+ * is the title, which shows the progress of a mesh being streamed.
+ */
+void Scop::pumpEvents(void)
+{
+	SDL_Event event;
+	uint32_t shown {100};
+
+	while (running.load(std::memory_order_acquire))
+	{
+		uint32_t percent {load_percent.load(std::memory_order_relaxed)};
+
+		if (percent != shown)
+		{
+			shown = percent;
+			sdl.setWindowTitle(percent < 100 ? ("scop - loading "
+				+ std::to_string(percent) + "%").c_str() : "scop");
+		}
+		if (!sdl.waitEventTimeout(&event, SCOP_IDLE_TIMEOUT_MS))
+		{
+			continue ;
+		}
+		if (event.type == SDL_USEREVENT
+			&& event.user.code == SCOP_PRESENT_EVENT)
+		{
+			presentSoftware();
+			continue ;
+		}
+		if (event.type == SDL_WINDOWEVENT
+			&& event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+		{
+			sdl.getWindowPixelResolution(&event.window.data1,
+				&event.window.data2);
+		}
+		while (!events.push(event) && running.load(std::memory_order_acquire))
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+/**
+ * Render thread loop. The frame slot is waited for first, then the pacer
+ * sleeps until just before the predicted GPU slot, and only then input is
+ * sampled and the frame recorded, so it is drawn with the freshest input
+ * possible.
+ */
+void Scop::renderLoop(void)
+{
+	try
+	{
+		while (running.load(std::memory_order_acquire))
+		{
+			waitForFrame();
+			pacer.wait();
+			if (!manageEvent())
+			{
+				break ;
+			}
+			animate();
+			if (!isIdle())
+			{
+				pacer.markInput(curr_frame);
+				drawFrame();
+			}
+			if (options.report)
+			{
+				pacer.report(std::cerr);
+			}
+		}
+	}
+	catch (...)
 	{
-		drawFrame();
+		render_error = std::current_exception();
 	}
-	vkDeviceWaitIdle(device);
+	stopRendering();
+}
+
+/**
+ * Stops both loops, and wakes the event thread up with a user event so it
+ * doesn't wait for its timeout.
+ */
+void Scop::stopRendering(void)
+{
+	SDL_Event wake {};
+
+	running.store(false, std::memory_order_release);
+	wake.type = SDL_USEREVENT;
+	sdl.pushEvent(&wake);
 }
 
 VkSubmitInfo Scop::setSubmitInfo(
@@ -1355,11 +4430,89 @@ VkPresentInfoKHR Scop::setPresentInfoKHR(VkSwapchainKHR *swapchains,
 }
 
 /**
- * Draws a frame and present it to the screen.
+ * Waits for the GPU to be done with the current frame slot, then hands the
+ * completion and GPU time of the frame to the pacer, destroys what the
+ * completed frames retired and writes what they captured.
+ */
+void Scop::waitForFrame(void)
+{
+	if (software)
+	{
+		return (pacer.markComplete(curr_frame, false, -1.0));
+	}
+
+	bool observed {getCompletedValue() < frame_value[curr_frame]};
+
+	waitTimeline(frame_value[curr_frame]);
+	pacer.markComplete(curr_frame, observed, readGpuTime());
+
+	uint64_t completed {getCompletedValue()};
+
+	deletion_queue.flush(completed);
+	frame_capture.collect(completed);
+}
+
+/**
+ * Waits for the GPU to be done with every frame submitted, then destroys what
+ * they retired and writes what they captured. Called before the render thread
+ * blocks, which would otherwise hold both until the next frame.
+ */
+void Scop::settle(void)
+{
+	if (software)
+	{
+		return ;
+	}
+	waitTimeline(timeline_value);
+
+	uint64_t completed {getCompletedValue()};
+
+	deletion_queue.flush(completed);
+	frame_capture.collect(completed);
+}
+
+/**
+ * Reads back the timestamps of the current frame slot and returns the GPU
+ * time of that frame in milliseconds, or a negative value if unavailable.
+ */
+double Scop::readGpuTime(void)
+{
+	uint64_t stamps[2] {0, 0};
+
+	if (query_pool == VK_NULL_HANDLE || !query_written[curr_frame])
+	{
+		return (-1.0);
+	}
+	query_written[curr_frame] = false;
+	if (vkGetQueryPoolResults(device, query_pool, 2 * curr_frame, 2,
+		sizeof(stamps), stamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT)
+		!= VK_SUCCESS)
+	{
+		return (-1.0);
+	}
+	return (static_cast<double> (stamps[1] - stamps[0])
+		* timestamp_period / 1e6);
+}
+
+/**
+ * Draws a frame and present it to the screen. The frame slot must have been
+ * waited for with waitForFrame().
  */
 void Scop::drawFrame(void)
 {
-	vkWaitForFences(device, 1, &frame_fence[curr_frame], VK_TRUE, UINT64_MAX);
+	if (software)
+	{
+		return (drawSoftware());
+	}
+	if (framebuffer_resized)
+	{
+		recreateSwapChain();
+	}
+	else if (capture_pass != needsCapturePass())
+	{
+		rebuildRenderGraph();
+	}
+	manageResidency();
 
 	uint32_t img_idx;
 	VkResult result = vkAcquireNextImageKHR(device, swapchain, UINT64_MAX,
@@ -1373,29 +4526,111 @@ void Scop::drawFrame(void)
 	{
 		throw (Error("Scop::drawFrame", "failed to acquire swapchain image"));
 	}
-	vkResetFences(device, 1, &frame_fence[curr_frame]);
 	vkResetCommandBuffer(command_buffer[curr_frame], 0);
 	recordCommandBuffer(command_buffer[curr_frame], img_idx);
+	scene_dirty = false;
 	queueSubmit();
+	pacer.markSubmit(curr_frame);
 	queuePresent(&img_idx);
+	countFrame();
+}
+
+/**
+ * Draws a frame with the software rasterizer into the back frame, then hands
+ * it to the event thread, which owns the window surface, as the next frame to
+ * show. A frame it didn't show yet is replaced, so drawing never waits.
+ */
+void Scop::drawSoftware(void)
+{
+	SDL_Event wake {};
+
+	framebuffer_resized = false;
+	soft_back.width = static_cast<uint32_t> (std::max(drawable_width, 1));
+	soft_back.height = static_cast<uint32_t> (std::max(drawable_height, 1));
+	swapchain_extent = VkExtent2D {soft_back.width, soft_back.height};
+
+	Transform transform {computeTransform()};
+
+	rasterizer.draw(mesh, transform.mvp, transform.model, variant,
+		soft_texture, soft_back);
+	scene_dirty = false;
+	pacer.markSubmit(curr_frame);
+	{
+		std::lock_guard<std::mutex> lock {soft_mutex};
+
+		std::swap(soft_back, soft_pending);
+		soft_ready = true;
+	}
+	wake.type = SDL_USEREVENT;
+	wake.user.code = SCOP_PRESENT_EVENT;
+	sdl.pushEvent(&wake);
+	countFrame();
+}
+
+/**
+ * Shows the last frame drawn by the software rasterizer. Runs on the event
+ * thread, a frame that fails to show is simply dropped.
+ */
+void Scop::presentSoftware(void)
+{
+	{
+		std::lock_guard<std::mutex> lock {soft_mutex};
+
+		if (!soft_ready)
+		{
+			return ;
+		}
+		std::swap(soft_pending, soft_front);
+		soft_ready = false;
+	}
+	sdl.presentPixels(soft_front.color.data(),
+		static_cast<int> (soft_front.width),
+		static_cast<int> (soft_front.height),
+		static_cast<int> (soft_front.stride * sizeof(uint32_t)));
+}
+
+/**
+ * Moves on to the next frame slot, and reports how long the first frame took
+ * to be drawn.
+ */
+void Scop::countFrame(void)
+{
 	curr_frame = (curr_frame + 1) % max_frame_in_flight;
+	if (++frame_count == 1 && options.report)
+	{
+		std::cerr << "first frame after " << std::chrono::duration<double,
+			std::milli> (std::chrono::steady_clock::now() - startup).count()
+			<< " ms" << std::endl;
+	}
 }
 
 /**
- * Submits the command buffer to the graphic queue.
+ * Submits the command buffer to the graphic queue. Besides the binary
+ * semaphore presentation waits on, it signals the next timeline value, which
+ * becomes the value of the frame slot.
  */
 void Scop::queueSubmit(void)
 {
 	VkSemaphore wait_sem[] {image_sem[curr_frame]};
 	VkPipelineStageFlags wstg[] {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-	VkSemaphore sig_sem[] {render_sem[curr_frame]};
+	VkSemaphore sig_sem[] {render_sem[curr_frame], timeline};
+	uint64_t wait_values[] {0};
+	uint64_t sig_values[] {0, timeline_value + 1};
+	VkTimelineSemaphoreSubmitInfoKHR values {};
 	VkSubmitInfo submit {setSubmitInfo(wait_sem, wstg, sig_sem)};
 
-	if (vkQueueSubmit(graphic_queue, 1, &submit, frame_fence[curr_frame])
-		!= VK_SUCCESS)
+	values.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+	values.waitSemaphoreValueCount = 1;
+	values.pWaitSemaphoreValues = wait_values;
+	values.signalSemaphoreValueCount = 2;
+	values.pSignalSemaphoreValues = sig_values;
+	submit.pNext = &values;
+	submit.signalSemaphoreCount = 2;
+	if (vkQueueSubmit(graphic_queue, 1, &submit, VK_NULL_HANDLE) != VK_SUCCESS)
 	{
 		throw (Error("Scop::drawFrame", "failed submition"));
 	}
+	frame_value[curr_frame] = ++timeline_value;
 }
 
 /**
@@ -1410,8 +4645,7 @@ void Scop::queuePresent(uint32_t *img_idx)
 
 	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
 	{
-		std::cout << "Image out of date" << std::endl;
-		recreateSwapChain();
+		framebuffer_resized = true;
 	}
 	else if (result != VK_SUCCESS)
 	{
@@ -1420,14 +4654,22 @@ void Scop::queuePresent(uint32_t *img_idx)
 }
 
 /**
- * Recreates the swapchain in case of certain events.
+ * Recreates the swapchain in case of certain events. The previous swapchain is
+ * handed to the new one and retired instead of destroyed, so the GPU is never
+ * drained and frames already in flight keep presenting. Nothing is done while
+ * the window has no drawable area (minimized).
  */
 void Scop::recreateSwapChain(void)
 {
-	vkDeviceWaitIdle(device);
-	cleanupSwapChain();
+	if (drawable_width == 0 || drawable_height == 0)
+	{
+		return ;
+	}
+	framebuffer_resized = false;
+	retireSwapChain();
 	createSwapChain();
 	createImageViews();
+	buildRenderGraph();
 	createFramebuffers();
 }
 
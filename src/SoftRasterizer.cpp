@@ -0,0 +1,630 @@
+#include <SoftRasterizer.hpp>
+
+struct SrgbTables
+{
+	float to_linear[256];
+	uint8_t to_srgb[SOFTRASTERIZER_SRGB_TABLE_SIZE];
+};
+
+/**
+ * Builds the sRGB transfer function tables.
+ */
+static inline SrgbTables buildSrgbTables(void)
+{
+	SrgbTables tables {};
+
+	for (int i {0}; i < 256; ++i)
+	{
+		float c {static_cast<float> (i) / 255.0f};
+
+		tables.to_linear[i] = c <= 0.04045f
+			? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+	}
+	for (int i {0}; i < SOFTRASTERIZER_SRGB_TABLE_SIZE; ++i)
+	{
+		float l {static_cast<float> (i) / (SOFTRASTERIZER_SRGB_TABLE_SIZE - 1)};
+		float c {l <= 0.0031308f
+			? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f};
+
+		tables.to_srgb[i] = static_cast<uint8_t> (c * 255.0f + 0.5f);
+	}
+	return (tables);
+}
+
+/**
+ * Shared sRGB tables, built on first use.
+ */
+static inline const SrgbTables &srgbTables(void)
+{
+	static const SrgbTables tables {buildSrgbTables()};
+
+	return (tables);
+}
+
+/**
+ * Encodes the linear <value> to 8 bits sRGB.
+ */
+static inline uint32_t toSrgb(const SrgbTables &tables, float value)
+{
+	return (tables.to_srgb[static_cast<int> (std::clamp(value, 0.0f, 1.0f)
+		* (SOFTRASTERIZER_SRGB_TABLE_SIZE - 1) + 0.5f)]);
+}
+
+/**
+ * Sets <edge> to the edge function from <ax>, <ay> to <bx>, <by> scaled by
+ * <inv_area>, so that edge[0] * x + edge[1] * y + edge[2] is the barycentric
+ * coordinate of the vertex opposite the edge at the point x, y.
+ */
+static inline void setEdge(float edge[3], float ax, float ay, float bx,
+	float by, float inv_area)
+{
+	edge[0] = (ay - by) * inv_area;
+	edge[1] = (bx - ax) * inv_area;
+	edge[2] = ((by - ay) * ax - (bx - ax) * ay) * inv_area;
+}
+
+/**
+ * Rasterizer without threads, it can't draw.
+ */
+SoftRasterizer::SoftRasterizer(void) :
+	pool {nullptr},
+#if defined(SOFTRASTERIZER_AVX2)
+	avx2 {static_cast<bool> (__builtin_cpu_supports("avx2"))},
+#else
+	avx2 {false},
+#endif
+	tiles_x {0},
+	tiles_y {0},
+	vertices {},
+	batches {},
+	depth {},
+	block_depth {}
+{
+	// Empty;
+}
+
+/**
+ * Rasterizer running on the workers of <pool> and the calling thread.
+ */
+SoftRasterizer::SoftRasterizer(ThreadPool &pool) : SoftRasterizer()
+{
+	this->pool = &pool;
+}
+
+/**
+ * Copy constructor, only the pool is shared: buffers are rebuilt every frame.
+ */
+SoftRasterizer::SoftRasterizer(const SoftRasterizer &cpy) : SoftRasterizer()
+{
+	pool = cpy.pool;
+}
+
+/**
+ * Destructor.
+ */
+SoftRasterizer::~SoftRasterizer(void) noexcept
+{
+	// Empty;
+}
+
+/**
+ * Copy assignement operator, only the pool is copied.
+ */
+SoftRasterizer &SoftRasterizer::operator=(const SoftRasterizer &cpy)
+{
+	pool = cpy.pool;
+	return (*this);
+}
+
+/**
+ * Draws the triangles of <mesh> into <frame>, cleared first, with the
+ * shading, culling and blending of <key> and the sRGB RGBA <texture>. The
+ * width and height of <frame> must be set, its stride and pixels are set
+ * here. Triangles crossing the plane of the eye are skipped, not clipped.
+ */
+void SoftRasterizer::draw(const Mesh &mesh, const Mat4 &mvp,
+	const Mat4 &model, const PipelineVariants::Key &key,
+	const Texture &texture, Frame &frame)
+{
+	if (!pool)
+	{
+		throw (Error("SoftRasterizer::draw", "no thread pool"));
+	}
+
+	size_t triangles {mesh.getIndices().size() / 3};
+	size_t count {std::clamp<size_t>((triangles + SOFTRASTERIZER_BATCH - 1)
+		/ SOFTRASTERIZER_BATCH, 1, (pool->size() + 1) * 4)};
+	size_t size {(triangles + count - 1) / count};
+
+	resize(frame);
+	transform(mesh, mvp, model, frame);
+	batches.resize(count);
+	pool->parallelFor(count, [&](size_t begin, size_t end)
+		{
+			for (size_t i {begin}; i < end; ++i)
+			{
+				bin(mesh, batches[i], std::min(i * size, triangles),
+					std::min((i + 1) * size, triangles), key.cull, frame);
+			}
+		});
+	pool->parallelFor(static_cast<size_t> (tiles_x) * tiles_y,
+		[&](size_t begin, size_t end)
+		{
+			for (size_t tile {begin}; tile < end; ++tile)
+			{
+				rasterizeTile(tile, key, texture, frame);
+			}
+		});
+}
+
+/**
+ * Sizes the buffers for <frame>, rounded up to whole tiles.
+ */
+void SoftRasterizer::resize(Frame &frame)
+{
+	size_t size;
+
+	tiles_x = (frame.width + SOFTRASTERIZER_TILE - 1) / SOFTRASTERIZER_TILE;
+	tiles_y = (frame.height + SOFTRASTERIZER_TILE - 1) / SOFTRASTERIZER_TILE;
+	frame.stride = tiles_x * SOFTRASTERIZER_TILE;
+	size = static_cast<size_t> (frame.stride) * tiles_y * SOFTRASTERIZER_TILE;
+	frame.color.resize(size);
+	depth.resize(size);
+	block_depth.resize(size / (SOFTRASTERIZER_BLOCK * SOFTRASTERIZER_BLOCK));
+}
+
+/**
+ * Transforms every vertex of <mesh> to the pixel coordinates of <frame>, with
+ * its depth, the inverse of its w for perspective correct interpolation, and
+ * its normal in world space. Vertices behind the eye get a null inverse w.
+ */
+void SoftRasterizer::transform(const Mesh &mesh, const Mat4 &mvp,
+	const Mat4 &model, const Frame &frame)
+{
+	const std::vector<Vec3> &positions {mesh.getPositions()};
+	const std::vector<Mesh::Attributes> &attributes {mesh.getAttributes()};
+	float half_width {static_cast<float> (frame.width) * 0.5f};
+	float half_height {static_cast<float> (frame.height) * 0.5f};
+
+	vertices.resize(positions.size());
+	pool->parallelFor(positions.size(), [&](size_t begin, size_t end)
+		{
+			const float *m {mvp.m};
+			const float *n {model.m};
+
+			for (size_t i {begin}; i < end; ++i)
+			{
+				const Vec3 &p {positions[i]};
+				const float *normal {attributes[i].normal};
+				Vertex &v {vertices[i]};
+				float w {m[3] * p.x + m[7] * p.y + m[11] * p.z + m[15]};
+
+				v.inv_w = w > SOFTRASTERIZER_MIN_W ? 1.0f / w : 0.0f;
+				v.x = ((m[0] * p.x + m[4] * p.y + m[8] * p.z + m[12])
+					* v.inv_w + 1.0f) * half_width;
+				v.y = ((m[1] * p.x + m[5] * p.y + m[9] * p.z + m[13])
+					* v.inv_w + 1.0f) * half_height;
+				v.z = (m[2] * p.x + m[6] * p.y + m[10] * p.z + m[14])
+					* v.inv_w;
+				v.normal = Vec3 {
+					n[0] * normal[0] + n[4] * normal[1] + n[8] * normal[2],
+					n[1] * normal[0] + n[5] * normal[1] + n[9] * normal[2],
+					n[2] * normal[0] + n[6] * normal[1] + n[10] * normal[2]
+				};
+				v.uv[0] = attributes[i].uv[0];
+				v.uv[1] = attributes[i].uv[1];
+			}
+		});
+}
+
+/**
+ * Sets up the triangles [<begin>, <end>) of <mesh> into <batch>, and lists
+ * each in the bins of the tiles its bounding box overlaps. Triangles culled
+ * by <cull>, degenerate, off screen or crossing the plane of the eye are
+ * dropped. Faces are counter-clockwise in framebuffer coordinates, as the
+ * pipeline expects. Edges are marked top or left, where the inside is below
+ * or to the right of them: pixels exactly on an edge only belong to the
+ * triangle it is top or left of, so that pixels on an edge shared by two
+ * triangles are drawn once.
+ */
+void SoftRasterizer::bin(const Mesh &mesh, Batch &batch, size_t begin,
+	size_t end, VkCullModeFlags cull, const Frame &frame)
+{
+	const std::vector<uint32_t> &indices {mesh.getIndices()};
+	float right_edge {static_cast<float> (frame.width) - 1.0f};
+	float bottom_edge {static_cast<float> (frame.height) - 1.0f};
+
+	batch.triangles.clear();
+	batch.bins.resize(static_cast<size_t> (tiles_x) * tiles_y);
+	for (std::vector<uint32_t> &tile : batch.bins)
+	{
+		tile.clear();
+	}
+	for (size_t i {begin}; i < end; ++i)
+	{
+		Triangle triangle {};
+		const Vertex &a {vertices[indices[3 * i]]};
+		const Vertex &b {vertices[indices[3 * i + 1]]};
+		const Vertex &c {vertices[indices[3 * i + 2]]};
+		float area {(b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x)};
+
+		if (a.inv_w == 0.0f || b.inv_w == 0.0f || c.inv_w == 0.0f
+			|| area == 0.0f || (cull & (area < 0.0f ? VK_CULL_MODE_FRONT_BIT
+				: VK_CULL_MODE_BACK_BIT)))
+		{
+			continue ;
+		}
+
+		float left {std::ceil(std::max(std::min({a.x, b.x, c.x}) - 0.5f,
+			0.0f))};
+		float right {std::floor(std::min(std::max({a.x, b.x, c.x}) - 0.5f,
+			right_edge))};
+		float top {std::ceil(std::max(std::min({a.y, b.y, c.y}) - 0.5f,
+			0.0f))};
+		float bottom {std::floor(std::min(std::max({a.y, b.y, c.y}) - 0.5f,
+			bottom_edge))};
+
+		if (right < left || bottom < top)
+		{
+			continue ;
+		}
+		triangle.min_x = static_cast<uint32_t> (left);
+		triangle.min_y = static_cast<uint32_t> (top);
+		triangle.max_x = static_cast<uint32_t> (right);
+		triangle.max_y = static_cast<uint32_t> (bottom);
+		setEdge(triangle.edge[0], b.x, b.y, c.x, c.y, 1.0f / area);
+		setEdge(triangle.edge[1], c.x, c.y, a.x, a.y, 1.0f / area);
+		setEdge(triangle.edge[2], a.x, a.y, b.x, b.y, 1.0f / area);
+		for (int k {0}; k < 3; ++k)
+		{
+			triangle.top_left[k] = triangle.edge[k][0] > 0.0f
+				|| (triangle.edge[k][0] == 0.0f && triangle.edge[k][1] > 0.0f);
+		}
+		triangle.depth[0] = a.z;
+		triangle.depth[1] = b.z - a.z;
+		triangle.depth[2] = c.z - a.z;
+		triangle.min_z = std::min({a.z, b.z, c.z});
+		for (int k {0}; k < 3; ++k)
+		{
+			triangle.vertex[k] = indices[3 * i + k];
+		}
+		for (uint32_t y {triangle.min_y / SOFTRASTERIZER_TILE};
+			y <= triangle.max_y / SOFTRASTERIZER_TILE; ++y)
+		{
+			for (uint32_t x {triangle.min_x / SOFTRASTERIZER_TILE};
+				x <= triangle.max_x / SOFTRASTERIZER_TILE; ++x)
+			{
+				batch.bins[y * tiles_x + x].push_back(
+					static_cast<uint32_t> (batch.triangles.size()));
+			}
+		}
+		batch.triangles.push_back(triangle);
+	}
+}
+
+/**
+ * Clears the tile <tile> of <frame>, then draws the triangles binned into it,
+ * batch after batch so that they land in submission order.
+ */
+void SoftRasterizer::rasterizeTile(size_t tile,
+	const PipelineVariants::Key &key, const Texture &texture, Frame &frame)
+{
+	uint32_t x0 {static_cast<uint32_t> (tile % tiles_x) * SOFTRASTERIZER_TILE};
+	uint32_t y0 {static_cast<uint32_t> (tile / tiles_x) * SOFTRASTERIZER_TILE};
+	uint32_t x1 {x0 + SOFTRASTERIZER_TILE - 1};
+	uint32_t y1 {y0 + SOFTRASTERIZER_TILE - 1};
+	uint32_t blocks {frame.stride / SOFTRASTERIZER_BLOCK};
+
+	for (uint32_t y {y0}; y <= y1; ++y)
+	{
+		size_t row {static_cast<size_t> (y) * frame.stride + x0};
+
+		std::fill_n(frame.color.begin() + row, SOFTRASTERIZER_TILE,
+			SOFTRASTERIZER_CLEAR);
+		std::fill_n(depth.begin() + row, SOFTRASTERIZER_TILE, 1.0f);
+	}
+	for (uint32_t y {y0 / SOFTRASTERIZER_BLOCK};
+		y <= y1 / SOFTRASTERIZER_BLOCK; ++y)
+	{
+		std::fill_n(block_depth.begin() + y * blocks
+			+ x0 / SOFTRASTERIZER_BLOCK, SOFTRASTERIZER_TILE
+			/ SOFTRASTERIZER_BLOCK, 1.0f);
+	}
+	for (const Batch &batch : batches)
+	{
+		for (uint32_t index : batch.bins[tile])
+		{
+			const Triangle &triangle {batch.triangles[index]};
+			uint32_t last_x {std::min(triangle.max_x, x1)
+				/ SOFTRASTERIZER_BLOCK};
+			uint32_t last_y {std::min(triangle.max_y, y1)
+				/ SOFTRASTERIZER_BLOCK};
+
+			for (uint32_t y {std::max(triangle.min_y, y0)
+				/ SOFTRASTERIZER_BLOCK}; y <= last_y; ++y)
+			{
+				for (uint32_t x {std::max(triangle.min_x, x0)
+					/ SOFTRASTERIZER_BLOCK}; x <= last_x; ++x)
+				{
+					rasterizeBlock(triangle, x, y, key, texture, frame);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Draws the pixels of <triangle> in the block at <block_x>, <block_y>. The
+ * block is skipped if the triangle is entirely behind its farthest depth, or
+ * entirely outside one of its edges at the four corners. Each row of the
+ * block is tested at once: the pixels inside the triangle and closer than
+ * the depth buffer get their depth written, then are shaded.
+ */
+void SoftRasterizer::rasterizeBlock(const Triangle &triangle,
+	uint32_t block_x, uint32_t block_y, const PipelineVariants::Key &key,
+	const Texture &texture, Frame &frame)
+{
+	uint32_t x0 {block_x * SOFTRASTERIZER_BLOCK};
+	uint32_t y0 {block_y * SOFTRASTERIZER_BLOCK};
+	uint32_t last_y {std::min(y0 + SOFTRASTERIZER_BLOCK - 1, triangle.max_y)};
+	float left {static_cast<float> (x0) + 0.5f};
+	float top {static_cast<float> (y0) + 0.5f};
+	float right {left + SOFTRASTERIZER_BLOCK - 1};
+	float bottom {top + SOFTRASTERIZER_BLOCK - 1};
+	bool written {false};
+
+	if (triangle.min_z >= block_depth[block_y * (frame.stride
+		/ SOFTRASTERIZER_BLOCK) + block_x])
+	{
+		return ;
+	}
+	for (const float *edge : triangle.edge)
+	{
+		if (edge[0] * (edge[0] > 0.0f ? right : left)
+			+ edge[1] * (edge[1] > 0.0f ? bottom : top) + edge[2] < 0.0f)
+		{
+			return ;
+		}
+	}
+	for (uint32_t y {std::max(y0, triangle.min_y)}; y <= last_y; ++y)
+	{
+		size_t row {static_cast<size_t> (y) * frame.stride + x0};
+		uint32_t *row_color {&frame.color[row]};
+		float center {static_cast<float> (y) + 0.5f};
+		float width {static_cast<float> (frame.width)};
+		alignas(32) float lambda[3][SOFTRASTERIZER_BLOCK];
+		uint32_t covered;
+
+#if defined(SOFTRASTERIZER_AVX2)
+		covered = avx2 ? coverRowAvx2(triangle, left, center, width,
+			&depth[row], lambda) : coverRow(triangle, left, center, width,
+			&depth[row], lambda);
+#else
+		covered = coverRow(triangle, left, center, width, &depth[row],
+			lambda);
+#endif
+		written = written || covered;
+		while (covered)
+		{
+			int i {std::countr_zero(covered)};
+			float weights[3] {lambda[0][i], lambda[1][i], lambda[2][i]};
+
+			row_color[i] = shade(triangle, weights, row_color[i], key,
+				texture);
+			covered &= covered - 1;
+		}
+	}
+	if (written)
+	{
+		updateBlockDepth(block_x, block_y, frame.stride);
+	}
+}
+
+/**
+ * Stores the farthest depth of the block at <block_x>, <block_y> once pixels
+ * of it were drawn.
+ */
+void SoftRasterizer::updateBlockDepth(uint32_t block_x, uint32_t block_y,
+	uint32_t stride)
+{
+	const float *row {&depth[static_cast<size_t> (block_y)
+		* SOFTRASTERIZER_BLOCK * stride + block_x * SOFTRASTERIZER_BLOCK]};
+	float &farthest {block_depth[block_y * (stride / SOFTRASTERIZER_BLOCK)
+		+ block_x]};
+
+#if defined(SOFTRASTERIZER_AVX2)
+	farthest = avx2 ? farthestDepthAvx2(row, stride)
+		: farthestDepth(row, stride);
+#else
+	farthest = farthestDepth(row, stride);
+#endif
+}
+
+/**
+ * Tests the SOFTRASTERIZER_BLOCK pixels of a row at <center> starting at the
+ * pixel center <left> against <triangle>, left of <width> and in front of
+ * <row_depth>, following the top-left rule. Writes the depth of the pixels
+ * passing, their barycentric coordinates to <lambda>, and returns them as a
+ * bit mask.
+ */
+uint32_t SoftRasterizer::coverRow(const Triangle &triangle, float left,
+	float center, float width, float *row_depth,
+	float lambda[3][SOFTRASTERIZER_BLOCK])
+{
+	uint32_t covered {0};
+
+	for (uint32_t i {0}; i < SOFTRASTERIZER_BLOCK; ++i)
+	{
+		float x {left + static_cast<float> (i)};
+		bool inside {x < width};
+		float z;
+
+		for (int e {0}; e < 3; ++e)
+		{
+			lambda[e][i] = triangle.edge[e][0] * x
+				+ triangle.edge[e][1] * center + triangle.edge[e][2];
+			inside = inside && (lambda[e][i] > 0.0f
+				|| (lambda[e][i] == 0.0f && triangle.top_left[e]));
+		}
+		z = triangle.depth[0] + lambda[1][i] * triangle.depth[1]
+			+ lambda[2][i] * triangle.depth[2];
+		if (inside && z >= 0.0f && z < row_depth[i])
+		{
+			row_depth[i] = z;
+			covered |= 1u << i;
+		}
+	}
+	return (covered);
+}
+
+/**
+ * Farthest of the SOFTRASTERIZER_BLOCK rows of depths at <row>, <stride>
+ * apart.
+ */
+float SoftRasterizer::farthestDepth(const float *row, uint32_t stride)
+{
+	float farthest {0.0f};
+
+	for (uint32_t y {0}; y < SOFTRASTERIZER_BLOCK; ++y)
+	{
+		farthest = std::max(farthest, *std::max_element(row + y * stride,
+			row + y * stride + SOFTRASTERIZER_BLOCK));
+	}
+	return (farthest);
+}
+
+#if defined(SOFTRASTERIZER_AVX2)
+/**
+ * coverRow on the 8 pixels at once, only called when the CPU supports AVX2.
+ */
+__attribute__((target("avx2")))
+uint32_t SoftRasterizer::coverRowAvx2(const Triangle &triangle, float left,
+	float center, float width, float *row_depth,
+	float lambda[3][SOFTRASTERIZER_BLOCK])
+{
+	__m256 zero {_mm256_setzero_ps()};
+	__m256 xs {_mm256_add_ps(_mm256_set1_ps(left),
+		_mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f))};
+	__m256 inside {_mm256_cmp_ps(xs, _mm256_set1_ps(width), _CMP_LT_OQ)};
+	__m256 l[3];
+
+	for (int i {0}; i < 3; ++i)
+	{
+		__m256 top_left {_mm256_castsi256_ps(_mm256_set1_epi32(
+			triangle.top_left[i] ? -1 : 0))};
+
+		l[i] = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(
+			triangle.edge[i][0]), xs), _mm256_set1_ps(triangle.edge[i][1]
+			* center)), _mm256_set1_ps(triangle.edge[i][2]));
+		inside = _mm256_and_ps(inside, _mm256_or_ps(_mm256_cmp_ps(l[i], zero,
+			_CMP_GT_OQ), _mm256_and_ps(_mm256_cmp_ps(l[i], zero, _CMP_EQ_OQ),
+			top_left)));
+		_mm256_store_ps(lambda[i], l[i]);
+	}
+
+	__m256 z {_mm256_add_ps(_mm256_set1_ps(triangle.depth[0]),
+		_mm256_add_ps(_mm256_mul_ps(l[1], _mm256_set1_ps(
+		triangle.depth[1])), _mm256_mul_ps(l[2], _mm256_set1_ps(
+		triangle.depth[2]))))};
+	__m256 old {_mm256_loadu_ps(row_depth)};
+
+	inside = _mm256_and_ps(inside, _mm256_cmp_ps(z, zero, _CMP_GE_OQ));
+	inside = _mm256_and_ps(inside, _mm256_cmp_ps(z, old, _CMP_LT_OQ));
+	_mm256_storeu_ps(row_depth, _mm256_blendv_ps(old, z, inside));
+	return (static_cast<uint32_t> (_mm256_movemask_ps(inside)));
+}
+
+/**
+ * farthestDepth on 8 columns at once, only called when the CPU supports
+ * AVX2.
+ */
+__attribute__((target("avx2")))
+float SoftRasterizer::farthestDepthAvx2(const float *row, uint32_t stride)
+{
+	__m256 rows {_mm256_loadu_ps(row)};
+	__m128 half;
+
+	for (uint32_t y {1}; y < SOFTRASTERIZER_BLOCK; ++y)
+	{
+		rows = _mm256_max_ps(rows, _mm256_loadu_ps(row + y * stride));
+	}
+	half = _mm_max_ps(_mm256_castps256_ps128(rows),
+		_mm256_extractf128_ps(rows, 1));
+	half = _mm_max_ps(half, _mm_movehl_ps(half, half));
+	half = _mm_max_ss(half, _mm_shuffle_ps(half, half, 1));
+	return (_mm_cvtss_f32(half));
+}
+#endif
+
+/**
+ * Color of the pixel of <triangle> at the barycentric coordinates <lambda>,
+ * as the fragment shader computes it: the attributes are interpolated with
+ * perspective correction, the texture is sampled at the nearest texel and
+ * lit in linear space. Blends over <dst> if <key> asks for it.
+ */
+uint32_t SoftRasterizer::shade(const Triangle &triangle,
+	const float lambda[3], uint32_t dst, const PipelineVariants::Key &key,
+	const Texture &texture) const
+{
+	static const Vec3 light {Vec3::normalize(Vec3 {0.4f, 0.7f, 0.6f})};
+	const SrgbTables &tables {srgbTables()};
+	float weights[3];
+	float sum {0.0f};
+	Vec3 normal {0.0f, 0.0f, 0.0f};
+	float uv[2] {0.0f, 0.0f};
+
+	for (int i {0}; i < 3; ++i)
+	{
+		weights[i] = lambda[i] * vertices[triangle.vertex[i]].inv_w;
+		sum += weights[i];
+	}
+	for (int i {0}; i < 3; ++i)
+	{
+		const Vertex &v {vertices[triangle.vertex[i]]};
+		float weight {weights[i] / sum};
+
+		normal = normal + v.normal * weight;
+		uv[0] += v.uv[0] * weight;
+		uv[1] += v.uv[1] * weight;
+	}
+	normal = Vec3::normalize(normal);
+
+	float u {uv[0] - std::floor(uv[0])};
+	float v {1.0f - uv[1] - std::floor(1.0f - uv[1])};
+	uint32_t x {std::min(static_cast<uint32_t> (u * static_cast<float> (
+		texture.width)), texture.width - 1)};
+	uint32_t y {std::min(static_cast<uint32_t> (v * static_cast<float> (
+		texture.height)), texture.height - 1)};
+	const uint8_t *texel {&texture.texels[(static_cast<size_t> (y)
+		* texture.width + x) * 4]};
+	float color[3] {tables.to_linear[texel[0]], tables.to_linear[texel[1]],
+		tables.to_linear[texel[2]]};
+	float alpha {static_cast<float> (texel[3]) / 255.0f};
+
+	if (key.shading == PipelineVariants::LIT)
+	{
+		float light_factor {0.15f + 0.85f
+			* std::fabs(Vec3::dot(normal, light))};
+
+		for (float &c : color)
+		{
+			c *= light_factor;
+		}
+	}
+	else if (key.shading == PipelineVariants::NORMALS)
+	{
+		color[0] = normal.x * 0.5f + 0.5f;
+		color[1] = normal.y * 0.5f + 0.5f;
+		color[2] = normal.z * 0.5f + 0.5f;
+	}
+	if (key.blend == PipelineVariants::ALPHA)
+	{
+		for (int i {0}; i < 3; ++i)
+		{
+			color[i] = color[i] * alpha + tables.to_linear[(dst
+				>> (16 - 8 * i)) & 0xff] * (1.0f - alpha);
+		}
+	}
+	return (SOFTRASTERIZER_CLEAR | toSrgb(tables, color[0]) << 16
+		| toSrgb(tables, color[1]) << 8 | toSrgb(tables, color[2]));
+}
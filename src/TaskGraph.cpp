@@ -0,0 +1,246 @@
+#include <TaskGraph.hpp>
+
+/**
+ * Empty graph.
+ */
+TaskGraph::TaskGraph(void) :
+	nodes {},
+	mutex {},
+	changed {},
+	main_ready {},
+	remaining {0},
+	error {},
+	origin {}
+{
+	// Empty;
+}
+
+/**
+ * Copy constructor, copies the tasks and their dependencies.
+ */
+TaskGraph::TaskGraph(const TaskGraph &cpy) : TaskGraph()
+{
+	nodes = cpy.nodes;
+}
+
+/**
+ * Destructor.
+ */
+TaskGraph::~TaskGraph(void) noexcept
+{
+	// Empty;
+}
+
+/**
+ * Copy assignement operator, copies the tasks and their dependencies.
+ */
+TaskGraph &TaskGraph::operator=(const TaskGraph &cpy)
+{
+	nodes = cpy.nodes;
+	return (*this);
+}
+
+/**
+ * Adds the task <name> running <task> once every node of <dependencies> is
+ * done, on the thread calling run() if <main_thread> is set. Returns its node.
+ * Dependencies must already be in the graph, which keeps it acyclic.
+ */
+size_t TaskGraph::add(const std::string &name, std::function<void(void)> task,
+	const std::vector<size_t> &dependencies, bool main_thread)
+{
+	size_t node {nodes.size()};
+
+	for (size_t dependency : dependencies)
+	{
+		if (dependency >= node)
+		{
+			throw (Error("TaskGraph::add", "unknown dependency"));
+		}
+		nodes[dependency].dependents.push_back(node);
+	}
+	nodes.push_back(Node {
+		.name = name,
+		.task = std::move(task),
+		.dependents = {},
+		.dependencies = dependencies.size(),
+		.main_thread = main_thread,
+		.waiting = 0,
+		.start_ms = 0.0,
+		.end_ms = 0.0,
+		.thread = {}
+	});
+	return (node);
+}
+
+/**
+ * Hands the ready <node> to the thread it runs on. Called with the lock held.
+ */
+void TaskGraph::dispatch(size_t node, ThreadPool &pool)
+{
+	if (nodes[node].main_thread)
+	{
+		main_ready.push_back(node);
+		changed.notify_all();
+		return ;
+	}
+	pool.submit([this, node, &pool](void) { execute(node, pool); });
+}
+
+/**
+ * Runs <node>, unless a task already failed, then dispatches the dependents it
+ * was the last dependency of.
+ */
+void TaskGraph::execute(size_t node, ThreadPool &pool)
+{
+	std::chrono::steady_clock::time_point start {
+		std::chrono::steady_clock::now()};
+	bool failed {false};
+
+	{
+		std::lock_guard<std::mutex> lock {mutex};
+
+		failed = static_cast<bool> (error);
+	}
+	try
+	{
+		if (!failed)
+		{
+			nodes[node].task();
+		}
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lock {mutex};
+
+		error = error ? error : std::current_exception();
+	}
+
+	std::lock_guard<std::mutex> lock {mutex};
+
+	nodes[node].start_ms = std::chrono::duration<double, std::milli> (
+		start - origin).count();
+	nodes[node].end_ms = std::chrono::duration<double, std::milli> (
+		std::chrono::steady_clock::now() - origin).count();
+	nodes[node].thread = std::this_thread::get_id();
+	for (size_t dependent : nodes[node].dependents)
+	{
+		if (--nodes[dependent].waiting == 0)
+		{
+			dispatch(dependent, pool);
+		}
+	}
+	--remaining;
+	changed.notify_all();
+}
+
+/**
+ * Runs every task and returns once all are done. The calling thread runs the
+ * tasks bound to it and sleeps otherwise. If a task throws, the tasks not
+ * started yet are skipped and the first exception is rethrown.
+ */
+void TaskGraph::run(ThreadPool &pool)
+{
+	std::unique_lock<std::mutex> lock {mutex};
+
+	origin = std::chrono::steady_clock::now();
+	remaining = nodes.size();
+	error = nullptr;
+	main_ready.clear();
+	for (Node &node : nodes)
+	{
+		node.waiting = node.dependencies;
+	}
+	for (size_t i {0}; i < nodes.size(); ++i)
+	{
+		if (nodes[i].waiting == 0)
+		{
+			dispatch(i, pool);
+		}
+	}
+	while (remaining != 0)
+	{
+		if (main_ready.empty())
+		{
+			changed.wait(lock);
+			continue ;
+		}
+
+		size_t node {main_ready.front()};
+
+		main_ready.pop_front();
+		lock.unlock();
+		execute(node, pool);
+		lock.lock();
+	}
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+}
+
+/**
+ * Time from the start of the last run to the end of its last task, in
+ * milliseconds.
+ */
+double TaskGraph::getDuration(void) const
+{
+	double duration {0.0};
+
+	for (const Node &node : nodes)
+	{
+		duration = std::max(duration, node.end_ms);
+	}
+	return (duration);
+}
+
+/**
+ * Writes the start and duration of every task of the last run, in start
+ * order.
+ */
+void TaskGraph::writeSummary(std::ostream &out) const
+{
+	std::vector<const Node *> order {};
+
+	for (const Node &node : nodes)
+	{
+		order.push_back(&node);
+	}
+	std::sort(order.begin(), order.end(), [](const Node *a, const Node *b)
+		{
+			return (a->start_ms < b->start_ms);
+		});
+	for (const Node *node : order)
+	{
+		out << std::fixed << std::setprecision(2) << std::setw(9)
+			<< node->start_ms << " ms +" << std::setw(8)
+			<< node->end_ms - node->start_ms << " ms  " << node->name
+			<< std::endl;
+	}
+	out << std::defaultfloat;
+}
+
+/**
+ * Writes the last run in the Chrome trace event format, one track per thread,
+ * viewable in chrome://tracing or Perfetto.
+ */
+void TaskGraph::writeTrace(std::ostream &out) const
+{
+	std::vector<std::thread::id> threads {};
+
+	out << "{\"traceEvents\":[";
+	for (size_t i {0}; i < nodes.size(); ++i)
+	{
+		auto it {std::find(threads.begin(), threads.end(), nodes[i].thread)};
+
+		if (it == threads.end())
+		{
+			it = threads.insert(threads.end(), nodes[i].thread);
+		}
+		out << (i ? "," : "") << "\n{\"name\":\"" << nodes[i].name
+			<< "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << it - threads.begin()
+			<< ",\"ts\":" << static_cast<long long> (nodes[i].start_ms * 1e3)
+			<< ",\"dur\":" << static_cast<long long> (
+				(nodes[i].end_ms - nodes[i].start_ms) * 1e3) << "}";
+	}
+	out << "\n]}" << std::endl;
+}
@@ -0,0 +1,116 @@
+#include <TextureCache.hpp>
+
+/**
+ * Cache in the default directory.
+ */
+TextureCache::TextureCache(void) : TextureCache(TEXTURECACHE_DIRECTORY)
+{
+	// Empty;
+}
+
+/**
+ * Cache in <directory>, created on the first write.
+ */
+TextureCache::TextureCache(const std::string &directory) :
+	directory {directory}
+{
+	// Empty;
+}
+
+/**
+ * Copy constructor.
+ */
+TextureCache::TextureCache(const TextureCache &cpy) :
+	directory {cpy.directory}
+{
+	// Empty;
+}
+
+/**
+ * Destructor.
+ */
+TextureCache::~TextureCache(void) noexcept
+{
+	// Empty;
+}
+
+/**
+ * Copy assignement operator.
+ */
+TextureCache &TextureCache::operator=(const TextureCache &cpy)
+{
+	directory = cpy.directory;
+	return (*this);
+}
+
+/**
+ * Path of the entry of the image of content <hash> encoded in <mode>.
+ */
+std::string TextureCache::path(uint64_t hash, BlockCompressor::Mode mode) const
+{
+	char name[32];
+
+	std::snprintf(name, sizeof(name), "%016llx-%s.bc",
+		static_cast<unsigned long long> (hash),
+		mode == BlockCompressor::FAST ? "fast" : "quality");
+	return (directory + "/" + name);
+}
+
+/**
+ * Reads the entry of the image of content <hash> encoded in <mode> to <header>
+ * and <data>. Returns false if there is no valid entry, or if it isn't a
+ * chain of <levels> levels, at least one, of a <width> by <height> image.
+ */
+bool TextureCache::read(uint64_t hash, BlockCompressor::Mode mode,
+	uint32_t width, uint32_t height, uint32_t levels, Header &header,
+	std::vector<uint8_t> &data) const
+{
+	std::ifstream file {path(hash, mode), std::ios::binary};
+
+	if (!file.read(reinterpret_cast<char *> (&header), sizeof(header))
+		|| std::memcmp(header.magic, "SCBC", 4)
+		|| header.version != TEXTURECACHE_VERSION
+		|| header.format > BlockCompressor::BC3
+		|| header.levels == 0 || header.width != width
+		|| header.height != height || header.levels != levels
+		|| header.size != BlockCompressor::chainSize(
+			static_cast<BlockCompressor::Format> (header.format),
+			header.width, header.height, header.levels))
+	{
+		return (false);
+	}
+	data.resize(header.size);
+	return (static_cast<bool> (file.read(reinterpret_cast<char *> (
+		data.data()), static_cast<std::streamsize> (header.size))));
+}
+
+/**
+ * Stores <header> and its <data> as the entry of the image of content <hash>
+ * encoded in <mode>. The entry is written aside then renamed, so that readers
+ * never see it partially. Returns false on failure.
+ */
+bool TextureCache::write(uint64_t hash, BlockCompressor::Mode mode,
+	const Header &header, const uint8_t *data) const
+{
+	std::string target {path(hash, mode)};
+	std::string temporary {target + ".tmp"};
+	std::error_code error {};
+
+	std::filesystem::create_directories(directory, error);
+	if (error)
+	{
+		return (false);
+	}
+	{
+		std::ofstream file {temporary, std::ios::binary | std::ios::trunc};
+
+		if (!file.write(reinterpret_cast<const char *> (&header),
+			sizeof(header)) || !file.write(reinterpret_cast<const char *> (
+			data), static_cast<std::streamsize> (header.size)))
+		{
+			return (false);
+		}
+	}
+	std::filesystem::rename(temporary, target, error);
+	return (!error);
+}
@@ -0,0 +1,184 @@
+#include <ThreadPool.hpp>
+
+/**
+ * Pool with one worker per hardware thread, minus the main and render ones.
+ */
+ThreadPool::ThreadPool(void) : ThreadPool(defaultSize())
+{
+	// Empty;
+}
+
+/**
+ * Pool of <count> workers, at least one.
+ */
+ThreadPool::ThreadPool(size_t count) : stopping {false}
+{
+	workers.reserve(std::max<size_t>(count, 1));
+	for (size_t i {0}; i < std::max<size_t>(count, 1); ++i)
+	{
+		workers.emplace_back(&ThreadPool::work, this);
+	}
+}
+
+/**
+ * Copy constructor. Threads and pending tasks can't be shared, the copy only
+ * gets as many workers.
+ */
+ThreadPool::ThreadPool(const ThreadPool &cpy) : ThreadPool(cpy.size())
+{
+	// Empty;
+}
+
+/**
+ * Destructor, runs the remaining tasks then joins the workers.
+ */
+ThreadPool::~ThreadPool(void) noexcept
+{
+	{
+		std::lock_guard<std::mutex> lock {mutex};
+
+		stopping = true;
+	}
+	available.notify_all();
+	for (std::thread &worker : workers)
+	{
+		worker.join();
+	}
+}
+
+/**
+ * Copy assignement operator. Keeps its own workers.
+ */
+ThreadPool &ThreadPool::operator=(const ThreadPool &cpy)
+{
+	(void)cpy;
+	return (*this);
+}
+
+/**
+ * Worker loop, pops and runs tasks until the pool stops and the queue is
+ * empty.
+ */
+void ThreadPool::work(void)
+{
+	while (true)
+	{
+		std::function<void(void)> task;
+
+		{
+			std::unique_lock<std::mutex> lock {mutex};
+
+			available.wait(lock, [this](void) {
+				return (stopping || !tasks.empty());
+			});
+			if (tasks.empty())
+			{
+				return ;
+			}
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+		task();
+	}
+}
+
+/**
+ * Queues <task> and wakes a worker up.
+ */
+void ThreadPool::push(std::function<void(void)> task)
+{
+	{
+		std::lock_guard<std::mutex> lock {mutex};
+
+		tasks.push_back(std::move(task));
+	}
+	available.notify_one();
+}
+
+/**
+ * Number of workers.
+ */
+size_t ThreadPool::size(void) const
+{
+	return (workers.size());
+}
+
+/**
+ * Calls <body> on chunks [begin, end) covering [0, count) in parallel and
+ * returns once every chunk is done. The calling thread processes chunks too,
+ * so this never deadlocks when called from a worker of a busy pool: helpers
+ * that start late simply find nothing left to do. A chunk that throws still
+ * counts as done, the first exception is rethrown once every chunk is.
+ */
+void ThreadPool::parallelFor(size_t count,
+	const std::function<void(size_t, size_t)> &body)
+{
+	struct Shared
+	{
+		std::atomic<size_t> next;
+		std::atomic<size_t> done;
+		std::function<void(size_t, size_t)> body;
+		size_t count;
+		size_t chunk;
+		std::mutex mutex;
+		std::exception_ptr error;
+	};
+	auto shared {std::make_shared<Shared>()};
+	size_t helpers {std::min(workers.size(), count > 0 ? count - 1 : 0)};
+	auto run {[](Shared &s)
+	{
+		size_t begin;
+
+		while ((begin = s.next.fetch_add(s.chunk)) < s.count)
+		{
+			size_t end {std::min(begin + s.chunk, s.count)};
+
+			try
+			{
+				s.body(begin, end);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock {s.mutex};
+
+				if (!s.error)
+				{
+					s.error = std::current_exception();
+				}
+			}
+			s.done.fetch_add(end - begin, std::memory_order_release);
+		}
+	}};
+
+	shared->next = 0;
+	shared->done = 0;
+	shared->body = body;
+	shared->count = count;
+	shared->chunk = std::max<size_t>(count / ((helpers + 1) * 4), 1);
+	for (size_t i {0}; i < helpers; ++i)
+	{
+		push([shared, run](void) { run(*shared); });
+	}
+	run(*shared);
+	while (shared->done.load(std::memory_order_acquire) < count)
+	{
+		std::this_thread::yield();
+	}
+
+	std::lock_guard<std::mutex> lock {shared->mutex};
+
+	if (shared->error)
+	{
+		std::rethrow_exception(shared->error);
+	}
+}
+
+/**
+ * Default number of workers.
+ */
+size_t ThreadPool::defaultSize(void)
+{
+	unsigned int threads {std::thread::hardware_concurrency()};
+
+	return (threads > 2 ? threads - 2 : 1);
+}
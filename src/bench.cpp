@@ -0,0 +1,226 @@
+#include <bench.hpp>
+
+/**
+ * Statements of an OBJ file the loader spends its time on: the arguments of
+ * every vertex statement, each giving several floats, and of every face.
+ */
+struct Statements
+{
+	std::vector<const char *> vertices;
+	size_t floats;
+	std::vector<const char *> faces;
+	std::vector<Mesh::FaceIndex> face_indices;
+};
+
+/**
+ * Parses the floats of the vertex statement at <p>, at most three, and
+ * returns their sum.
+ */
+static inline float parseVertex(const char *p, const char *end, size_t &count)
+{
+	float sum {0.0f};
+
+	for (size_t i {0}; i < 3 && p < end && *p != '\n'; ++i, ++count)
+	{
+		sum += Mesh::parseFloat(p, end);
+		p = Mesh::skipSpaces(p, end);
+	}
+	return (sum);
+}
+
+/**
+ * Finds the vertex and face statements of the OBJ file in <data>.
+ */
+static Statements findStatements(const std::string &data)
+{
+	Statements statements {};
+	const char *p {data.data()};
+	const char *end {p + data.size()};
+
+	for (; p < end; p = Mesh::nextLine(p, end))
+	{
+		const char *args {nullptr};
+		Mesh::FaceIndex idx {};
+
+		p = Mesh::skipSpaces(p, end);
+		if (end - p > 1 && p[0] == 'v' && (p[1] == ' ' || p[1] == 't'
+			|| p[1] == 'n'))
+		{
+			args = Mesh::skipSpaces(p + (p[1] == ' ' ? 1 : 2), end);
+			statements.vertices.push_back(args);
+			parseVertex(args, end, statements.floats);
+		}
+		else if (end - p > 1 && p[0] == 'f' && p[1] == ' ')
+		{
+			args = Mesh::skipSpaces(p + 1, end);
+			statements.faces.push_back(args);
+			while (Mesh::parseFaceIndex(args, end, idx))
+			{
+				statements.face_indices.push_back(idx);
+				args = Mesh::skipSpaces(args, end);
+			}
+		}
+	}
+	return (statements);
+}
+
+/**
+ * Runs the parser and mesh kernels on the OBJ file at <path>, naming them
+ * after <label>.
+ */
+static void benchModel(Benchmark &bench, const std::string &path,
+	const std::string &label, const std::map<std::string, double> &baseline)
+{
+	std::string data {Mesh::readFile(path)};
+	const char *end {data.data() + data.size()};
+	Statements statements {findStatements(data)};
+	Mesh mesh {path};
+	const std::vector<Vec3> &positions {mesh.getPositions()};
+
+	Benchmark::writeResult(std::cout, bench.run("parse_float/" + label,
+		statements.floats, [&](void)
+		{
+			float sum {0.0f};
+			size_t count {0};
+
+			for (const char *p : statements.vertices)
+			{
+				sum += parseVertex(p, end, count);
+			}
+			Benchmark::keep(sum);
+		}), baseline);
+	Benchmark::writeResult(std::cout, bench.run("face_tokenize/" + label,
+		statements.face_indices.size(), [&](void)
+		{
+			Mesh::FaceIndex idx {};
+			int32_t sum {0};
+
+			for (const char *p : statements.faces)
+			{
+				while (Mesh::parseFaceIndex(p, end, idx))
+				{
+					sum += idx.v + idx.vt + idx.vn;
+					p = Mesh::skipSpaces(p, end);
+				}
+			}
+			Benchmark::keep(sum);
+		}), baseline);
+	Benchmark::writeResult(std::cout, bench.run("weld_insert/" + label,
+		statements.face_indices.size(), [&](void)
+		{
+			std::unordered_map<Mesh::FaceIndex, uint32_t, Mesh::FaceIndexHash>
+				welded {};
+
+			for (const Mesh::FaceIndex &idx : statements.face_indices)
+			{
+				welded.try_emplace(idx, static_cast<uint32_t> (welded.size()));
+			}
+			Benchmark::keep(welded.size());
+		}), baseline);
+	Benchmark::writeResult(std::cout, bench.run("bounds_reduce/" + label,
+		positions.size(), [&](void)
+		{
+			Mesh::Bounds bounds {positions[0], positions[0]};
+
+			Mesh::growBounds(bounds, positions);
+			Benchmark::keep(bounds);
+		}), baseline);
+}
+
+/**
+ * Runs the matrix kernels: BENCH_MATRICES independent products of 4x4
+ * matrices.
+ */
+static void benchMath(Benchmark &bench,
+	const std::map<std::string, double> &baseline)
+{
+	std::vector<Mat4> a {};
+	std::vector<Mat4> b {};
+	std::vector<Mat4> product(BENCH_MATRICES);
+
+	for (size_t i {0}; i < BENCH_MATRICES; ++i)
+	{
+		a.push_back(Mat4::rotation(static_cast<float> (i) * 0.01f,
+			Vec3 {0.0f, 1.0f, 0.0f}));
+		b.push_back(Mat4::translation(Vec3 {static_cast<float> (i), 1.0f,
+			-2.0f}));
+	}
+	Benchmark::writeResult(std::cout, bench.run("mat4_multiply",
+		BENCH_MATRICES, [&](void)
+		{
+			for (size_t i {0}; i < BENCH_MATRICES; ++i)
+			{
+				product[i] = a[i] * b[i];
+			}
+			Benchmark::keep(product.data());
+		}), baseline);
+}
+
+/**
+ * Prints the available arguments on the error output.
+ */
+static void usage(const char *name)
+{
+	std::cerr << "usage: " << name << " [--compare <results>] [model.obj]..."
+		<< std::endl;
+	std::cerr << "\t--compare <results>\tshow changes from a previous output"
+		<< std::endl;
+}
+
+/**
+ * Runs every benchmark on the models given, resources/teapot.obj and
+ * resources/42.obj by default, and writes one line per result. Saving the
+ * output of a commit and passing it to --compare on another shows the change
+ * of each result.
+ */
+int main(int argc, char **argv)
+{
+	try
+	{
+		std::vector<std::string> models {};
+		std::map<std::string, double> baseline {};
+		Benchmark bench {};
+
+		for (int i {1}; i < argc; ++i)
+		{
+			if (!std::strcmp(argv[i], "--compare") && i + 1 < argc)
+			{
+				std::ifstream file {argv[++i]};
+
+				if (!file)
+				{
+					throw (Error("main", "failed to open results"));
+				}
+				baseline = Benchmark::readResults(file);
+			}
+			else if (argv[i][0] == '-')
+			{
+				usage(argv[0]);
+				throw (Error("main", "unknown argument"));
+			}
+			else
+			{
+				models.push_back(argv[i]);
+			}
+		}
+		if (models.empty())
+		{
+			models = {"resources/teapot.obj", "resources/42.obj"};
+		}
+		std::cout << "# " << BENCHMARK_REPETITIONS << " samples after "
+			<< BENCHMARK_WARMUP << " warmup, cycle counters "
+			<< (bench.hasCounters() ? "on" : "unavailable") << std::endl;
+		for (const std::string &model : models)
+		{
+			benchModel(bench, model, model.substr(model.find_last_of('/')
+				+ 1), baseline);
+		}
+		benchMath(bench, baseline);
+		return (0);
+	}
+	catch (std::exception const &e)
+	{
+		Error::print(e);
+		return (1);
+	}
+}
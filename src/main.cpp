@@ -1,10 +1,10 @@
 #include <main.hpp>
 
-int main(void)
+int main(int argc, char **argv)
 {
 	try
 	{
-		Scop scop;
+		Scop scop {Options(argc, argv)};
 
 		scop.mainLoop();
 		return (0);
@@ -0,0 +1,225 @@
+#include <opt.hpp>
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * Outcome of the conversion of one OBJ file.
+ */
+struct Conversion
+{
+	std::string target;
+	uintmax_t source_size;
+	uintmax_t target_size;
+	size_t source_vertices;
+	size_t vertices;
+	std::vector<size_t> triangles;
+	float source_acmr;
+	float acmr;
+	double parse_ms;
+	double optimize_ms;
+	double write_ms;
+};
+
+/**
+ * Milliseconds elapsed since <start>.
+ */
+static inline double elapsedMs(Clock::time_point start)
+{
+	return (std::chrono::duration<double, std::milli> (Clock::now() - start)
+		.count());
+}
+
+/**
+ * Converts the OBJ file at <source> into the asset at <target>. Throws if the
+ * file can't be loaded or the asset written.
+ */
+static Conversion convert(const std::string &source, const std::string &target)
+{
+	Conversion result {};
+	Clock::time_point start {Clock::now()};
+	Mesh mesh {source};
+
+	result.parse_ms = elapsedMs(start);
+	start = Clock::now();
+
+	MeshOptimizer optimizer {mesh};
+
+	result.optimize_ms = elapsedMs(start);
+	start = Clock::now();
+	if (!optimizer.write(target))
+	{
+		throw (Error("convert", "failed to write asset"));
+	}
+	result.write_ms = elapsedMs(start);
+	result.target = target;
+	result.source_size = std::filesystem::file_size(source);
+	result.target_size = optimizer.getAssetSize();
+	result.source_vertices = optimizer.getSourceVertexCount();
+	result.vertices = optimizer.getVertices().size();
+	for (const MeshOptimizer::Lod &lod : optimizer.getLods())
+	{
+		result.triangles.push_back(lod.indices.size() / 3);
+	}
+	result.source_acmr = optimizer.getSourceAcmr();
+	result.acmr = MeshOptimizer::computeAcmr(optimizer.getLods()[0].indices,
+		result.vertices);
+	return (result);
+}
+
+/**
+ * Writes the timings, sizes and statistics of <conversion> of <source>.
+ */
+static void writeConversion(std::ostream &out, const std::string &source,
+	const Conversion &conversion)
+{
+	out << source << " -> " << conversion.target << std::endl;
+	out << std::fixed << std::setprecision(2) << "\tparse "
+		<< conversion.parse_ms << " ms, optimize " << conversion.optimize_ms
+		<< " ms, write " << conversion.write_ms << " ms" << std::endl;
+	out << "\t" << conversion.source_size << " -> " << conversion.target_size
+		<< " bytes (" << 100.0 * static_cast<double> (conversion.target_size)
+		/ static_cast<double> (conversion.source_size) << "%), "
+		<< conversion.source_vertices << " -> " << conversion.vertices
+		<< " vertices, ACMR " << conversion.source_acmr << " -> "
+		<< conversion.acmr << std::endl;
+	out << "\ttriangles per level of detail:";
+	for (size_t count : conversion.triangles)
+	{
+		out << " " << count;
+	}
+	out << std::endl;
+}
+
+/**
+ * Adds <path> to <sources>, or every OBJ file below it if it is a directory.
+ */
+static void collectSources(const std::string &path,
+	std::vector<std::string> &sources)
+{
+	std::vector<std::string> found {};
+
+	if (!std::filesystem::is_directory(path))
+	{
+		sources.push_back(path);
+		return ;
+	}
+	for (const std::filesystem::directory_entry &entry
+		: std::filesystem::recursive_directory_iterator(path))
+	{
+		if (entry.is_regular_file() && entry.path().extension() == ".obj")
+		{
+			found.push_back(entry.path().string());
+		}
+	}
+	std::sort(found.begin(), found.end());
+	sources.insert(sources.end(), found.begin(), found.end());
+}
+
+/**
+ * Path of the asset of <source>: next to it, or in <output> if not empty.
+ */
+static std::string targetPath(const std::string &source,
+	const std::string &output)
+{
+	std::filesystem::path target {source};
+
+	target.replace_extension(OPT_EXTENSION);
+	if (!output.empty())
+	{
+		target = std::filesystem::path(output) / target.filename();
+	}
+	return (target.string());
+}
+
+/**
+ * Prints the available arguments on the error output.
+ */
+static void usage(const char *name)
+{
+	std::cerr << "usage: " << name << " [-o <dir>] <model.obj|dir>..."
+		<< std::endl;
+	std::cerr << "\t-o <dir>\twrite the assets to dir instead of next to"
+		" their model" << std::endl;
+}
+
+/**
+ * Converts the OBJ files given, or found in the directories given, into
+ * binary assets in parallel, then reports each conversion in order. Returns
+ * 1 if any failed.
+ */
+int main(int argc, char **argv)
+{
+	try
+	{
+		std::string output {};
+		std::vector<std::string> sources {};
+		std::vector<std::future<Conversion>> jobs {};
+		Clock::time_point start {Clock::now()};
+		uintmax_t source_size {0};
+		uintmax_t target_size {0};
+		size_t failed {0};
+
+		for (int i {1}; i < argc; ++i)
+		{
+			if (!std::strcmp(argv[i], "-o") && i + 1 < argc)
+			{
+				output = argv[++i];
+			}
+			else if (argv[i][0] == '-')
+			{
+				usage(argv[0]);
+				throw (Error("main", "unknown argument"));
+			}
+			else
+			{
+				collectSources(argv[i], sources);
+			}
+		}
+		if (sources.empty())
+		{
+			usage(argv[0]);
+			return (1);
+		}
+		if (!output.empty())
+		{
+			std::filesystem::create_directories(output);
+		}
+
+		ThreadPool pool {std::max(std::thread::hardware_concurrency(), 1u)};
+
+		for (const std::string &source : sources)
+		{
+			jobs.push_back(pool.submit([source, target = targetPath(source,
+				output)](void)
+				{
+					return (convert(source, target));
+				}));
+		}
+		for (size_t i {0}; i < jobs.size(); ++i)
+		{
+			try
+			{
+				Conversion conversion {jobs[i].get()};
+
+				writeConversion(std::cout, sources[i], conversion);
+				source_size += conversion.source_size;
+				target_size += conversion.target_size;
+			}
+			catch (std::exception const &e)
+			{
+				std::cerr << sources[i] << ": ";
+				Error::print(e);
+				++failed;
+			}
+		}
+		std::cout << jobs.size() - failed << " of " << jobs.size()
+			<< " files converted in " << elapsedMs(start) << " ms, "
+			<< source_size << " -> " << target_size << " bytes" << std::endl;
+		return (failed ? 1 : 0);
+	}
+	catch (std::exception const &e)
+	{
+		Error::print(e);
+		return (1);
+	}
+}